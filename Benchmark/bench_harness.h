@@ -0,0 +1,209 @@
+//bench_harness.h
+//Tiny benchmark harness shared by the bench_*.cpp files.
+//Each benchmark is a function that runs its operation `iterations` times.
+//The harness grows the iteration count until one run takes long enough,
+//repeats the measurement and keeps the fastest one (least disturbed by the OS).
+//
+//Command line (same for every bench_* program):
+//  --filter TEXT       only run benchmarks whose name contains TEXT
+//  --quick             smaller parameter sets and shorter runs
+//  --json FILE         write the results as JSON
+//  --baseline FILE     compare with an earlier --json file; exit code 1 if
+//                      anything got slower than the tolerance
+//  --tolerance 0.10    allowed slowdown for --baseline (default 10%)
+#ifndef BENCH_HARNESS_H
+#define BENCH_HARNESS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+//Keeps the compiler from optimising a result away
+template <typename T>
+inline void doNotOptimize(const T& value){
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct BenchResult{
+    std::string name;   //e.g. "Sensor::addReading"
+    std::string params; //e.g. "capacity=1000"
+    long long iterations = 0;
+    double nsPerOp = 0.0;
+    std::string key() const {return params.empty() ? name : name + " [" + params + "]";}
+};
+
+class BenchSuite{
+    private:
+        std::string suiteName;
+        std::string filter;
+        std::string jsonPath;
+        std::string baselinePath;
+        double tolerance = 0.10;
+        bool quick = false;
+        std::vector<BenchResult> results;
+
+        static std::string escape(const std::string& text){
+            std::string out;
+            for(char c : text){
+                if(c == '"' || c == '\\') out += '\\';
+                out += c;
+            }
+            return out;
+        }
+        //Value of "field": in one JSON object written by writeJson()
+        static std::string field(const std::string& object, const std::string& name){
+            std::string tag = "\"" + name + "\":";
+            std::size_t at = object.find(tag);
+            if(at == std::string::npos) return "";
+            at += tag.size();
+            while(at < object.size() && object[at] == ' ') ++at;
+            if(at < object.size() && object[at] == '"'){
+                std::string text;
+                for(std::size_t i = at + 1; i < object.size() && object[i] != '"'; ++i){
+                    if(object[i] == '\\' && i + 1 < object.size()) ++i;
+                    text += object[i];
+                }
+                return text;
+            }
+            std::size_t end = object.find_first_of(",}", at);
+            return object.substr(at, end - at);
+        }
+    public:
+        explicit BenchSuite(std::string name) : suiteName(std::move(name)){}
+
+    //Returns false if the arguments are wrong
+    bool parseArgs(int argc, char* argv[]){
+        for(int i = 1; i < argc; ++i){
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if(arg == "--quick") quick = true;
+            else if(arg == "--filter" && hasValue) filter = argv[++i];
+            else if(arg == "--json" && hasValue) jsonPath = argv[++i];
+            else if(arg == "--baseline" && hasValue) baselinePath = argv[++i];
+            else if(arg == "--tolerance" && hasValue) tolerance = std::atof(argv[++i]);
+            else{
+                std::cout << "usage: " << argv[0]
+                          << " [--filter TEXT] [--quick] [--json FILE] [--baseline FILE] [--tolerance 0.10]\n";
+                return false;
+            }
+        }
+        return true;
+    }
+    bool isQuick() const {return quick;}
+
+    //fn(iterations) must perform the operation `iterations` times
+    void run(const std::string& name, const std::string& params, const std::function<void(long long)>& fn){
+        BenchResult r;
+        r.name = name;
+        r.params = params;
+        if(!filter.empty() && r.key().find(filter) == std::string::npos) return;
+        using Clock = std::chrono::steady_clock;
+        const double target = quick ? 0.02 : 0.1; //seconds per measurement
+        long long iterations = 1;
+        double seconds = 0.0;
+        //grow until one run is long enough to time reliably
+        while(true){
+            auto start = Clock::now();
+            fn(iterations);
+            seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            if(seconds >= target || iterations >= (1ll << 40)) break;
+            double scale = seconds > 0 ? target / seconds * 1.2 : 10.0;
+            iterations = static_cast<long long>(iterations * std::min(10.0, std::max(2.0, scale)));
+        }
+        double best = seconds / iterations;
+        for(int repeat = 0; repeat < (quick ? 1 : 3); ++repeat){
+            auto start = Clock::now();
+            fn(iterations);
+            best = std::min(best, std::chrono::duration<double>(Clock::now() - start).count() / iterations);
+        }
+        r.iterations = iterations;
+        r.nsPerOp = best * 1e9;
+        results.push_back(r);
+        std::printf("%-58s %14.2f ns/op %14.0f ops/s\n", r.key().c_str(), r.nsPerOp, 1e9 / r.nsPerOp);
+        std::fflush(stdout);
+    }
+
+    void writeJson(const std::string& path) const {
+        std::ofstream out(path);
+        out << "{\n  \"suite\": \"" << escape(suiteName) << "\",\n  \"results\": [\n";
+        for(std::size_t i = 0; i < results.size(); ++i){
+            const BenchResult& r = results[i];
+            out << "    {\"name\": \"" << escape(r.name) << "\", \"params\": \"" << escape(r.params)
+                << "\", \"iterations\": " << r.iterations << ", \"ns_per_op\": " << r.nsPerOp << "}"
+                << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        out << "  ]\n}\n";
+    }
+    //Reads a file written by writeJson(); empty if missing
+    static std::vector<BenchResult> readJson(const std::string& path){
+        std::vector<BenchResult> list;
+        std::ifstream in(path);
+        if(!in) return list;
+        std::stringstream buffer;
+        buffer << in.rdbuf();
+        std::string text = buffer.str();
+        std::size_t at = text.find("\"results\"");
+        while(at != std::string::npos){
+            std::size_t open = text.find('{', at);
+            if(open == std::string::npos) break;
+            std::size_t close = text.find('}', open);
+            if(close == std::string::npos) break;
+            std::string object = text.substr(open, close - open + 1);
+            BenchResult r;
+            r.name = field(object, "name");
+            r.params = field(object, "params");
+            r.iterations = std::atoll(field(object, "iterations").c_str());
+            r.nsPerOp = std::atof(field(object, "ns_per_op").c_str());
+            if(!r.name.empty()) list.push_back(r);
+            at = close + 1;
+        }
+        return list;
+    }
+    //Print old vs new for every benchmark in both runs; returns the number of regressions
+    int compare(const std::vector<BenchResult>& baseline) const {
+        int regressions = 0;
+        std::printf("\n%-58s %12s %12s %9s\n", "benchmark", "base ns/op", "now ns/op", "change");
+        for(const BenchResult& now : results){
+            auto it = std::find_if(baseline.begin(), baseline.end(), [&](const BenchResult& b){
+                return b.key() == now.key();
+            });
+            if(it == baseline.end()){
+                std::printf("%-58s %12s %12.2f %9s\n", now.key().c_str(), "-", now.nsPerOp, "new");
+                continue;
+            }
+            double change = it->nsPerOp > 0 ? now.nsPerOp / it->nsPerOp - 1.0 : 0.0;
+            bool slower = change > tolerance;
+            regressions += slower;
+            std::printf("%-58s %12.2f %12.2f %+8.1f%%%s\n", now.key().c_str(), it->nsPerOp, now.nsPerOp,
+                        change * 100.0, slower ? "  REGRESSION" : "");
+        }
+        return regressions;
+    }
+    //Write/compare as asked on the command line; returns the process exit code
+    int finish() const {
+        if(!jsonPath.empty()){
+            writeJson(jsonPath);
+            std::cout << "results written to " << jsonPath << "\n";
+        }
+        if(!baselinePath.empty()){
+            std::vector<BenchResult> baseline = readJson(baselinePath);
+            if(baseline.empty()){
+                std::cout << "baseline " << baselinePath << " missing or empty\n";
+                return 1;
+            }
+            int regressions = compare(baseline);
+            std::cout << regressions << " regression(s) beyond " << tolerance * 100.0 << "%\n";
+            return regressions > 0 ? 1 : 0;
+        }
+        return 0;
+    }
+};
+
+#endif
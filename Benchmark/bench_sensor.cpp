@@ -0,0 +1,129 @@
+//bench_sensor.cpp
+//Benchmarks for Project2 (sensor_data_logger): Sensor::addReading, getAverage,
+//detcetAnomaly and ctakeReading, for several history sizes.
+//history=0 is the unbounded vector mode, anything else is the ring buffer size.
+//Build: g++ -std=c++17 -O2 bench_sensor.cpp -o bench_sensor
+#define BENCHMARK_BUILD
+#include "../Project2/sensor_data_logger.cpp"
+#include "bench_harness.h"
+
+//Pre-generated readings so the benchmarks don't time the random generator
+std::vector<double> makeValues(std::size_t n){
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<double> ran(20.0, 40.0);
+    std::vector<double> values(n);
+    for(double& v : values) v = ran(gen);
+    return values;
+}
+std::unique_ptr<Sensor> makeSensor(std::size_t history){
+    if(history == 0) return std::make_unique<Sensor>("Temperature", "C");
+    return std::make_unique<Sensor>("Temperature", "C", history);
+}
+std::unique_ptr<AnomalyDetector> makeDetector(const std::string& name){
+    if(name == "zscore") return std::make_unique<RollingZScoreDetector>();
+    if(name == "mad") return std::make_unique<MadDetector>();
+    if(name == "ewma") return std::make_unique<EwmaDriftDetector>();
+    return nullptr;
+}
+
+int main(int argc, char* argv[]){
+    BenchSuite suite("sensor");
+    if(!suite.parseArgs(argc, argv)) return 2;
+    //time the code itself: with logging on, the numbers would depend on whether
+    //the logger ring happens to be full (full rings drop records cheaply)
+    AsyncLogger::instance().setLevel(LogLevel::Off);
+
+    const std::vector<double> values = makeValues(4096);
+    const std::size_t mask = values.size() - 1;
+    std::vector<std::size_t> histories = {0, 16, 1024, 65536};
+    if(suite.isQuick()) histories = {0, 1024};
+
+    for(std::size_t history : histories){
+        const std::string params = "history=" + std::to_string(history);
+        suite.run("Sensor::addReading", params, [&](long long n){
+            auto sensor = makeSensor(history); //fresh sensor, unbounded mode would keep growing
+            for(long long i = 0; i < n; ++i) sensor->addReading(values[i & mask]);
+            doNotOptimize(sensor->getAverage());
+        });
+
+        auto filled = makeSensor(history);
+        for(std::size_t i = 0; i < std::max<std::size_t>(history, 1024); ++i) filled->addReading(values[i & mask]);
+        suite.run("Sensor::getAverage", params, [&](long long n){
+            double sum = 0.0;
+            for(long long i = 0; i < n; ++i){
+                sum += filled->getAverage();
+                doNotOptimize(sum);
+            }
+        });
+        suite.run("Sensor::detcetAnomaly", params, [&](long long n){
+            long long flagged = 0;
+            for(long long i = 0; i < n; ++i) flagged += filled->detcetAnomaly();
+            doNotOptimize(flagged);
+        });
+        suite.run("ctakeReading", params, [&](long long n){
+            auto temp = makeSensor(history);
+            auto dist = makeSensor(history);
+            auto light = makeSensor(history);
+            auto weight = makeSensor(history);
+            for(long long i = 0; i < n; ++i){
+                int battery = 100; //ctakeReading stops below 10%
+                ctakeReading(*temp, *dist, *light, *weight, battery);
+            }
+            doNotOptimize(temp->getAverage());
+        });
+    }
+
+    //detector cost inside addReading, with a 1024-reading window
+    for(const std::string name : {"zscore", "mad", "ewma"}){
+        suite.run("Sensor::addReading", "history=1024 detector=" + name, [&](long long n){
+            Sensor sensor("Temperature", "C", 1024);
+            sensor.setDetector(makeDetector(name));
+            for(long long i = 0; i < n; ++i) sensor.addReading(values[i & mask]);
+            doNotOptimize(sensor.getAnomalyCount());
+        });
+    }
+
+    //batch generation, per frame of four channels
+    for(std::size_t batchSize : {std::size_t(1), std::size_t(64), std::size_t(1024)}){
+        suite.run("generateReadings", "batch=" + std::to_string(batchSize), [&](long long n){
+            Sensor temp("Temperature", "C", 1024), dist("Distance", "cm", 1024);
+            Sensor light("Light", "lux", 1024), weight("Weight", "g", 1024);
+            Sensor* sensors[4] = {&temp, &dist, &light, &weight};
+            SampleEngine engine(sensorChannels(), 42);
+            SampleBatch batch(4, batchSize);
+            generateReadings(engine, batch, static_cast<std::size_t>(n), sensors);
+            doNotOptimize(temp.getAverage());
+        });
+    }
+
+    //fusion: one op = one aligned frame of all streams, pushes of the samples
+    //behind it included (two samples per stream per frame, off the clock grid)
+    const std::size_t streamCounts[] = {16, 4000};
+    for(std::size_t streamCount : streamCounts){
+        if(suite.isQuick() && streamCount > 16) continue;
+        for(const std::string mode : {"hold", "linear"}){
+            suite.run("StreamFusion::emitUntil", "streams=" + std::to_string(streamCount) + " mode=" + mode, [&](long long n){
+                const std::int64_t CLOCK_US = 20000;
+                std::vector<TimedStream> streams(streamCount);
+                StreamFusion fusion(0, CLOCK_US, mode == "hold" ? Resample::Hold : Resample::Linear);
+                for(TimedStream& st : streams) fusion.addStream(st);
+                FusedBatch batch;
+                std::int64_t t = 0;
+                long long done = 0;
+                while(done < n){
+                    long long chunk = std::min<long long>(64, n - done);
+                    for(long long f = 0; f < chunk * 2; ++f){
+                        t += CLOCK_US / 2;
+                        for(std::size_t i = 0; i < streamCount; ++i) streams[i].push(t - 7 - static_cast<std::int64_t>(i % 5), values[(t + i) & mask]);
+                    }
+                    done += static_cast<long long>(fusion.emitUntil(fusion.watermark(), batch, static_cast<std::size_t>(n - done)));
+                    doNotOptimize(batch.values.data());
+                    batch.clear();
+                }
+            });
+        }
+    }
+
+    logFlush();
+    return suite.finish();
+}
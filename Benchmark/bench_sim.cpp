@@ -0,0 +1,232 @@
+//bench_sim.cpp
+//Benchmarks for Project3 (robot_sim): Robot::isObstacle, every move() variant,
+//virtual vs grouped updates, displayGrid, RobotPool churn, the fleet tick and
+//the proximity index for several world and fleet sizes.
+//Build: g++ -std=c++17 -O2 -pthread bench_sim.cpp -o bench_sim
+#define BENCHMARK_BUILD
+#include "../Project3/robot_sim.cpp"
+#include "bench_harness.h"
+
+//Opens up the protected parts of a robot for the benchmarks
+template <typename R>
+class Probe : public R{
+    public:
+        using R::R;
+    bool probeObstacle(int x, int y) const {return this->isObstacle(x, y);}
+    void place(int x, int y){
+        this->positionX = x;
+        this->positionY = y;
+    }
+    void refill(){this->battery = 100;}
+    //path history is not what we time here, keep it from growing without end
+    void trimPath(){
+        if(this->path.size() > 4096){
+            this->path.clear();
+            this->path.push(this->positionX, this->positionY);
+        }
+    }
+};
+
+//A square world with `obstacles` random blocked cells (plus the default map)
+void makeWorld(int size, std::size_t extraObstacles, unsigned seed = 1){
+    world = OccupancyGrid(size, size, OccupancyGrid::chooseMode(size, size, obstacles.size() + extraObstacles));
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int> cell(0, size - 1);
+    for(std::size_t i = 0; i < extraObstacles; ++i) world.set(cell(gen), cell(gen));
+    for(const auto& o : obstacles){
+        if(world.inBounds(o.first, o.second)) world.set(o.first, o.second);
+    }
+    view.setZoom(1);
+    view.fitTo(world, VIEW_COLS, VIEW_ROWS);
+}
+std::string worldParam(int size){
+    return "world=" + std::to_string(size) + (world.getMode() == OccupancyMode::Dense ? " dense" : " sparse");
+}
+
+//Free: back and forth between (x, y) and the cell to its right.
+//Blocked: always right, into an obstacle. The battery is refilled every step.
+template <typename R>
+void benchMove(BenchSuite& suite, const std::string& name, R& robot, int x, int y, bool blocked){
+    suite.run(name + "::move", worldParam(world.getWidth()) + (blocked ? " blocked" : " free"), [&](long long n){
+        robot.place(x, y);
+        for(long long i = 0; i < n; ++i){
+            robot.refill();
+            robot.move((i & 1) && !blocked ? Direction::Left : Direction::Right);
+            robot.trimPath();
+        }
+        doNotOptimize(robot.getX());
+    });
+}
+
+int main(int argc, char* argv[]){
+    BenchSuite suite("sim");
+    if(!suite.parseArgs(argc, argv)) return 2;
+    //time the code itself: with logging on, the numbers would depend on whether
+    //the logger ring happens to be full (full rings drop records cheaply)
+    AsyncLogger::instance().setLevel(LogLevel::Off);
+
+    std::vector<int> worldSizes = {10, 1000, 100000};
+    std::vector<std::size_t> fleetSizes = {3, 100, 10000};
+    std::vector<std::size_t> tickFleets = {1000, 100000, 1000000};
+    if(suite.isQuick()){
+        worldSizes = {10, 1000};
+        fleetSizes = {3, 1000};
+        tickFleets = {1000, 100000};
+    }
+
+    // === Robot::isObstacle ===
+    for(int size : worldSizes){
+        makeWorld(size, size <= 1000 ? static_cast<std::size_t>(size) * size / 10 : 10000);
+        std::mt19937 gen(3);
+        std::uniform_int_distribution<int> cell(0, size - 1);
+        std::vector<std::pair<int,int>> cells(4096);
+        for(auto& c : cells) c = {cell(gen), cell(gen)};
+        Probe<WheeledRobot> robot;
+        suite.run("Robot::isObstacle", worldParam(size), [&](long long n){
+            long long hits = 0;
+            for(long long i = 0; i < n; ++i){
+                const auto& c = cells[i & 4095];
+                hits += robot.probeObstacle(c.first, c.second);
+            }
+            doNotOptimize(hits);
+        });
+    }
+
+    // === move() of each robot kind: a free move, and one into an obstacle ===
+    makeWorld(100, 0);
+    world.set(20, 50); //blocks the step right of (19, 50) and the 3-cell jump from (17, 50)
+    Probe<WheeledRobot> wheeled;
+    Probe<LeggedRobot> legged;
+    Probe<FlyingRobot> flying("FlyingRobot");
+    benchMove(suite, "WheeledRobot", wheeled, 50, 50, false);
+    benchMove(suite, "WheeledRobot", wheeled, 19, 50, true);
+    benchMove(suite, "LeggedRobot", legged, 50, 50, false);
+    benchMove(suite, "LeggedRobot", legged, 19, 50, true);
+    benchMove(suite, "FlyingRobot", flying, 50, 50, false);
+    benchMove(suite, "FlyingRobot", flying, 17, 50, true);
+
+    //the same moves without the virtual call: the kind's kernel called directly
+    suite.run("WheeledRobot::moveWith", worldParam(world.getWidth()) + " free", [&](long long n){
+        wheeled.place(50, 50);
+        for(long long i = 0; i < n; ++i){
+            wheeled.refill();
+            wheeled.moveWith((i & 1) ? Direction::Left : Direction::Right);
+            wheeled.trimPath();
+        }
+        doNotOptimize(wheeled.getX());
+    });
+
+    // === one autonomous step of a mixed fleet: vtable per robot vs grouped by kind ===
+    makeWorld(1000, 1000);
+    for(std::size_t robotsCount : fleetSizes){
+        RobotPool pool;
+        std::mt19937 gen(11);
+        std::uniform_int_distribution<int> cell(0, 999);
+        for(std::size_t i = 0; i < robotsCount; ++i){
+            int x = cell(gen);
+            pool.spawn(static_cast<RobotKind>(i % ROBOT_KIND_COUNT), x, cell(gen));
+        }
+        //batteries last only a few moves, so every robot starts over every 4 steps
+        auto respawnAll = [&]{
+            for(RobotHandle h : pool.handles()){
+                Robot* r = pool.get(h);
+                r->respawn(r->getX(), r->getY(), r->getTraceId());
+            }
+        };
+        const std::string params = "robots=" + std::to_string(robotsCount) + " mixed";
+        suite.run("Robot::update virtual", params, [&](long long n){
+            for(long long i = 0; i < n; ++i){
+                if(i % 4 == 0) respawnAll();
+                for(Robot* r : pool.list()) r->update();
+            }
+        });
+        suite.run("RobotPool::updateAll", params, [&](long long n){
+            for(long long i = 0; i < n; ++i){
+                if(i % 4 == 0) respawnAll();
+                pool.updateAll();
+            }
+        });
+    }
+
+    // === displayGrid: world size x fleet size ===
+    for(int size : {10, 1000}){
+        makeWorld(size, static_cast<std::size_t>(size) * size / 20);
+        for(std::size_t robotsCount : fleetSizes){
+            RobotPool pool;
+            std::mt19937 gen(5);
+            std::uniform_int_distribution<int> cell(0, size - 1);
+            for(std::size_t i = 0; i < robotsCount; ++i){
+                int x = cell(gen);
+                pool.spawn(RobotKind::Wheeled, x, cell(gen));
+            }
+            suite.run("displayGrid", worldParam(size) + " robots=" + std::to_string(robotsCount), [&](long long n){
+                for(long long i = 0; i < n; ++i) displayGrid(pool.list());
+            });
+        }
+    }
+
+    // === RobotPool: one spawn + one despawn, with `robots` alive the whole time ===
+    for(std::size_t robotsCount : fleetSizes){
+        RobotPool pool;
+        std::vector<RobotHandle> alive;
+        for(std::size_t i = 0; i < robotsCount; ++i){
+            alive.push_back(pool.spawn(static_cast<RobotKind>(i % ROBOT_KIND_COUNT), 0, 0));
+        }
+        suite.run("RobotPool spawn+despawn", "robots=" + std::to_string(robotsCount), [&](long long n){
+            std::size_t victim = 0;
+            for(long long i = 0; i < n; ++i){
+                //replace a robot in the middle of the list, with a different kind
+                victim = (victim + 7919) % alive.size();
+                pool.despawn(alive[victim]);
+                alive[victim] = pool.spawn(static_cast<RobotKind>(i % ROBOT_KIND_COUNT), 1, 1);
+            }
+            doNotOptimize(pool.size());
+        });
+    }
+
+    // === one fleet tick: plain step and the collision-aware parallel tick ===
+    makeWorld(1000, 1000);
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    ParallelTicker ticker(threads);
+    for(std::size_t robotsCount : tickFleets){
+        RobotFleet pristine;
+        std::mt19937 gen(9);
+        std::uniform_int_distribution<int> cell(0, 999);
+        for(std::size_t i = 0; i < robotsCount; ++i){
+            //plenty of battery, so the robots keep moving for the whole run
+            pristine.spawn(static_cast<RobotKind>(i % ROBOT_KIND_COUNT), cell(gen), cell(gen), 1 << 30);
+        }
+        const std::string params = "world=1000 robots=" + std::to_string(robotsCount);
+        //every run starts from the same fleet, so runs do the same work
+        suite.run("RobotFleet::step", params, [&](long long n){
+            RobotFleet fleet = pristine;
+            std::size_t moved = 0;
+            for(long long i = 0; i < n; ++i) moved += fleet.step(world);
+            doNotOptimize(moved);
+        });
+        suite.run("ParallelTicker::tick", params + " threads=" + std::to_string(threads), [&](long long n){
+            RobotFleet fleet = pristine;
+            std::size_t moved = 0;
+            for(long long i = 0; i < n; ++i) moved += ticker.tick(fleet, world);
+            doNotOptimize(moved);
+        });
+        //broadphase over the same fleet: rebuild, then one batch query per robot
+        ProximityGrid proximity(3);
+        ProximityResult neighbourSet;
+        suite.run("ProximityGrid::build", params, [&](long long n){
+            for(long long i = 0; i < n; ++i) proximity.build(pristine);
+            doNotOptimize(proximity.size());
+        });
+        suite.run("ProximityGrid::radiusAll", params + " r=3", [&](long long n){
+            for(long long i = 0; i < n; ++i) proximity.radiusAll(3, neighbourSet);
+            doNotOptimize(neighbourSet.hits.size());
+        });
+        suite.run("ProximityGrid::nearestAll", params + " k=4", [&](long long n){
+            for(long long i = 0; i < n; ++i) proximity.nearestAll(4, neighbourSet);
+            doNotOptimize(neighbourSet.hits.size());
+        });
+    }
+
+    logFlush();
+    return suite.finish();
+}
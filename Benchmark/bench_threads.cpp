@@ -0,0 +1,205 @@
+//bench_threads.cpp
+//Benchmarks for Project4 (multi_threads_robot): the hand-off of samples and
+//state between threads. Times are per item moved from one thread to another.
+//  SpscQueue    sensor -> control, one producer thread, one consumer thread
+//  MpscQueue    sensor + control -> logger, several producer threads
+//  Seqlock      control publishes RobotTelemetry while reader threads copy it
+//  pipeline     sensorStep + controlStep + loggingStep in one thread (no waiting)
+//  TaskScheduler  parallelFor over small and large ranges, spawn + wait of
+//               small tasks, summarizeWindow (the analytics batch job)
+//On a machine with fewer cores than threads the numbers mostly show scheduling.
+//Build: g++ -std=c++17 -O2 -pthread bench_threads.cpp -o bench_threads
+#define BENCHMARK_BUILD
+#include "../Project4/multi_threads_robot.cpp"
+#include "bench_harness.h"
+
+//Push n samples from a second thread, pop them here in batches
+void spscHandoff(SpscQueue<SensorSample>& queue, long long n){
+    std::thread producer([&]{
+        SensorSample sample;
+        for(long long i = 0; i < n; ++i){
+            sample.seq = static_cast<std::uint64_t>(i);
+            while(!queue.tryPush(sample)) std::this_thread::yield(); //full: let the consumer run
+        }
+    });
+    SensorSample batch[256];
+    long long received = 0;
+    std::uint64_t check = 0;
+    while(received < n){
+        std::size_t got = queue.popBatch(batch, 256);
+        if(got == 0){
+            std::this_thread::yield();
+            continue;
+        }
+        for(std::size_t i = 0; i < got; ++i) check += batch[i].seq;
+        received += static_cast<long long>(got);
+    }
+    producer.join();
+    doNotOptimize(check);
+}
+//n events in total, split over `producers` threads
+void mpscHandoff(MpscQueue<LogEvent>& queue, long long n, int producers){
+    std::vector<std::thread> threads;
+    for(int p = 0; p < producers; ++p){
+        long long count = n / producers + (p < n % producers ? 1 : 0);
+        threads.emplace_back([&queue, count, p]{
+            LogEvent ev;
+            ev.positionX = p;
+            for(long long i = 0; i < count; ++i){
+                ev.seq = static_cast<std::uint64_t>(i);
+                while(!queue.tryPush(ev)) std::this_thread::yield();
+            }
+        });
+    }
+    LogEvent batch[256];
+    long long received = 0;
+    while(received < n){
+        std::size_t got = queue.popBatch(batch, 256);
+        if(got == 0){
+            std::this_thread::yield();
+            continue;
+        }
+        received += static_cast<long long>(got);
+    }
+    for(auto& t : threads) t.join();
+}
+
+int main(int argc, char* argv[]){
+    BenchSuite suite("threads");
+    if(!suite.parseArgs(argc, argv)) return 2;
+    //time the code itself: with logging on, the numbers would depend on whether
+    //the logger ring happens to be full (full rings drop records cheaply)
+    AsyncLogger::instance().setLevel(LogLevel::Off);
+
+    std::vector<std::size_t> capacities = {64, 1024, 16384};
+    std::vector<int> producerCounts = {1, 2, 4};
+    std::vector<int> readerCounts = {0, 1, 4};
+    if(suite.isQuick()){
+        capacities = {1024};
+        producerCounts = {1, 2};
+        readerCounts = {0, 1};
+    }
+
+    for(std::size_t capacity : capacities){
+        SpscQueue<SensorSample> queue(capacity);
+        suite.run("SpscQueue handoff", "capacity=" + std::to_string(capacity), [&](long long n){
+            spscHandoff(queue, n);
+        });
+    }
+    for(int producers : producerCounts){
+        MpscQueue<LogEvent> queue(4096);
+        suite.run("MpscQueue handoff", "capacity=4096 producers=" + std::to_string(producers), [&](long long n){
+            mpscHandoff(queue, n, producers);
+        });
+    }
+
+    //writer cost with readers hammering the snapshot, and reader cost with a busy writer
+    for(int readers : readerCounts){
+        SeqlockSnapshot<RobotTelemetry> snapshot;
+        suite.run("SeqlockSnapshot::publish", "readers=" + std::to_string(readers), [&](long long n){
+            std::atomic<bool> stop{false};
+            std::vector<std::thread> threads;
+            for(int r = 0; r < readers; ++r){
+                threads.emplace_back([&]{
+                    RobotTelemetry seen;
+                    while(!stop.load(std::memory_order_relaxed)){
+                        snapshot.read(seen);
+                        doNotOptimize(seen.version);
+                    }
+                });
+            }
+            RobotTelemetry t;
+            for(long long i = 0; i < n; ++i){
+                t.version = static_cast<std::uint64_t>(i);
+                ++t.positionX;
+                snapshot.publish(t);
+            }
+            stop = true;
+            for(auto& th : threads) th.join();
+        });
+    }
+    for(bool busyWriter : {false, true}){
+        SeqlockSnapshot<RobotTelemetry> snapshot;
+        suite.run("SeqlockSnapshot::read", busyWriter ? "writer=busy" : "writer=idle", [&](long long n){
+            std::atomic<bool> stop{false};
+            std::thread writer;
+            if(busyWriter){
+                writer = std::thread([&]{
+                    RobotTelemetry t;
+                    while(!stop.load(std::memory_order_relaxed)){
+                        ++t.version;
+                        snapshot.publish(t);
+                    }
+                });
+            }
+            RobotTelemetry seen;
+            std::uint64_t retries = 0;
+            for(long long i = 0; i < n; ++i) retries += snapshot.read(seen);
+            stop = true;
+            if(writer.joinable()) writer.join();
+            doNotOptimize(retries);
+        });
+    }
+
+    //one cycle of each loop body back to back: the cost without any waiting
+    suite.run("pipeline cycle", "sensor+control+logger, quiet", [&](long long n){
+        RobotState state;
+        Pipeline pipe;
+        pipe.verbose = false;
+        SensorSource source;
+        for(long long i = 0; i < n; ++i){
+            sensorStep(source, pipe);
+            controlStep(state, pipe);
+            loggingStep(pipe);
+        }
+        doNotOptimize(state.current.version);
+    });
+
+    //the shared work-stealing pool: fork/join cost and one analytics window
+    const unsigned poolThreads = std::max(2u, std::thread::hardware_concurrency());
+    TaskScheduler pool(poolThreads);
+    const std::string poolParam = "threads=" + std::to_string(poolThreads);
+    std::vector<std::size_t> rangeSizes = {1024, 1 << 20};
+    if(suite.isQuick()) rangeSizes = {1024};
+    for(std::size_t items : rangeSizes){
+        std::vector<double> values(items, 1.0);
+        std::vector<double> partial(pool.size());
+        suite.run("TaskScheduler::parallelFor", "items=" + std::to_string(items) + " " + poolParam, [&](long long n){
+            for(long long i = 0; i < n; ++i){
+                std::fill(partial.begin(), partial.end(), 0.0);
+                pool.parallelFor(items, [&](std::size_t begin, std::size_t end, unsigned t){
+                    double sum = 0.0;
+                    for(std::size_t k = begin; k < end; ++k) sum += values[k];
+                    partial[t] += sum;
+                });
+                doNotOptimize(partial[0]);
+            }
+        });
+    }
+    suite.run("TaskScheduler spawn+wait", "batch=64 " + poolParam, [&](long long n){
+        std::atomic<long long> done{0};
+        std::vector<TaskHandle> tasks;
+        for(long long i = 0; i < n; i += 64){
+            tasks.clear();
+            for(long long k = i; k < std::min(n, i + 64); ++k){
+                tasks.push_back(pool.spawn([&]{ done.fetch_add(1, std::memory_order_relaxed); }));
+            }
+            for(const TaskHandle& t : tasks) pool.wait(t);
+        }
+        doNotOptimize(done.load());
+    });
+    {
+        std::vector<SensorSample> window(65536);
+        SensorSource source;
+        for(SensorSample& sample : window){
+            sample.distance = source.distRan(source.gen);
+            sample.temperature = 25.0 + source.tempNoise(source.gen);
+        }
+        suite.run("summarizeWindow", "samples=65536 " + poolParam, [&](long long n){
+            for(long long i = 0; i < n; ++i) doNotOptimize(summarizeWindow(pool, window).meanDistance);
+        });
+    }
+
+    logFlush();
+    return suite.finish();
+}
@@ -0,0 +1,455 @@
+//async_logger.h
+//Asynchronous logger shared by all the projects.
+//A LOG_xxx(...) call never touches the terminal or a file: it copies its
+//arguments (numbers as raw bytes, strings as their characters) into a ring
+//buffer owned by the calling thread and returns. A background thread drains
+//every ring, turns the records into text (so formatting happens there, not in
+//the caller) and writes each batch with one fwrite per sink.
+//  - LOG_INFO("Temp : ", t, " C") prints like std::cout << "Temp : " << t << " C" << '\n'
+//  - levels: ASYNC_LOG_LEVEL removes calls below it at compile time, setLevel()
+//    skips them at runtime before any argument is evaluated
+//  - a full ring drops the record and counts it, the caller never waits;
+//    a record bigger than half a ring is formatted by the caller and cut short
+//  - a thread's ring goes back to a free list when the thread exits and is
+//    reused by the next thread that logs
+//  - flush() waits until everything logged so far is written; call it before
+//    printing a menu / reading input with std::cout and std::cin
+//Include from a project as "../Common/async_logger.h".
+#ifndef ASYNC_LOGGER_H
+#define ASYNC_LOGGER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <iomanip>
+
+enum class LogLevel : int {Trace, Debug, Info, Warn, Error, Off};
+
+//Lowest level compiled in (0 = Trace ... 5 = Off), e.g. g++ -DASYNC_LOG_LEVEL=2
+#ifndef ASYNC_LOG_LEVEL
+#define ASYNC_LOG_LEVEL 0
+#endif
+
+// === argument encoding ===
+//Strings are copied by value, so the caller may free them right after the call
+struct LogStr{
+    const char* data;
+    std::uint32_t size;
+};
+inline LogStr logArg(const char* s){return {s, static_cast<std::uint32_t>(std::strlen(s))};}
+inline LogStr logArg(char* s){return logArg(static_cast<const char*>(s));}
+inline LogStr logArg(const std::string& s){return {s.data(), static_cast<std::uint32_t>(s.size())};}
+template <std::size_t N>
+inline LogStr logArg(const char (&s)[N]){return logArg(static_cast<const char*>(s));}
+template <typename T>
+inline auto logArg(const T& value){
+    static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value,
+                  "LOG arguments must be numbers, chars, enums, pointers or strings");
+    if constexpr(std::is_enum<T>::value) return static_cast<std::underlying_type_t<T>>(value);
+    else return value;
+}
+
+template <typename T>
+struct LogCodec{
+    static std::size_t size(const T&){return sizeof(T);}
+    static char* write(char* p, const T& value){
+        std::memcpy(p, &value, sizeof(T));
+        return p + sizeof(T);
+    }
+    static const char* read(const char* p, std::ostream& os){
+        T value;
+        std::memcpy(&value, p, sizeof(T));
+        os << value;
+        return p + sizeof(T);
+    }
+};
+template <>
+struct LogCodec<LogStr>{
+    static std::size_t size(const LogStr& s){return sizeof(std::uint32_t) + s.size;}
+    static char* write(char* p, const LogStr& s){
+        std::memcpy(p, &s.size, sizeof(std::uint32_t));
+        std::memcpy(p + sizeof(std::uint32_t), s.data, s.size);
+        return p + sizeof(std::uint32_t) + s.size;
+    }
+    static const char* read(const char* p, std::ostream& os){
+        std::uint32_t size;
+        std::memcpy(&size, p, sizeof(std::uint32_t));
+        os.write(p + sizeof(std::uint32_t), size);
+        return p + sizeof(std::uint32_t) + size;
+    }
+};
+//Runs on the flusher thread: decode the payload in the same order it was written
+template <typename... Stored>
+void logFormat(const char* p, std::ostream& os){
+    ((p = LogCodec<Stored>::read(p, os)), ...);
+    (void)p;
+}
+
+struct LogRecordHeader{
+    std::uint32_t size;  //whole record incl. header, multiple of 8; 0 = skip to the ring start
+    std::uint32_t level;
+    std::int64_t timeNs; //steady clock
+    void (*format)(const char*, std::ostream&);
+};
+
+// === one thread's staging ring: the owning thread writes, the flusher reads ===
+class LogRing{
+    private:
+        std::unique_ptr<std::uint64_t[]> words; //8-byte aligned storage
+        std::size_t capacity;                   //bytes, power of two
+        std::size_t pending = 0;                //producer: tail after the reserved record
+        alignas(64) std::atomic<std::size_t> head{0}; //flusher
+        alignas(64) std::atomic<std::size_t> tail{0}; //owning thread
+    public:
+        std::atomic<std::uint64_t> dropped{0};
+
+        explicit LogRing(std::size_t bytes) : capacity(64){
+            while(capacity < bytes) capacity <<= 1;
+            words.reset(new std::uint64_t[capacity / 8]);
+        }
+        char* base() const {return reinterpret_cast<char*>(words.get());}
+
+    std::size_t size() const {return capacity;}
+    //Producer: room for a record of `need` bytes (multiple of 8), nullptr if full.
+    //A record never wraps; the space left at the end of the ring is skipped.
+    char* reserve(std::size_t need){
+        std::size_t t = tail.load(std::memory_order_relaxed);
+        std::size_t h = head.load(std::memory_order_acquire);
+        std::size_t pos = t & (capacity - 1);
+        std::size_t toEnd = capacity - pos;
+        std::size_t total = toEnd < need ? toEnd + need : need;
+        if(t + total - h > capacity) return nullptr;
+        if(toEnd < need){
+            if(toEnd >= sizeof(LogRecordHeader)){
+                LogRecordHeader skip{};
+                std::memcpy(base() + pos, &skip, sizeof(skip));
+            }
+            t += toEnd;
+            pos = 0;
+        }
+        pending = t + need;
+        return base() + pos;
+    }
+    void commit(){tail.store(pending, std::memory_order_release);}
+    //Flusher: visit every record between head and the current tail, returns that tail.
+    //fn(const LogRecordHeader&, const char* payload)
+    template <typename Fn>
+    std::size_t forEach(Fn fn) const {
+        std::size_t h = head.load(std::memory_order_relaxed);
+        std::size_t t = tail.load(std::memory_order_acquire);
+        while(h < t){
+            std::size_t pos = h & (capacity - 1);
+            std::size_t toEnd = capacity - pos;
+            LogRecordHeader rec;
+            if(toEnd >= sizeof(LogRecordHeader)) std::memcpy(&rec, base() + pos, sizeof(rec));
+            if(toEnd < sizeof(LogRecordHeader) || rec.size == 0){
+                h += toEnd;
+                continue;
+            }
+            fn(rec, base() + pos + sizeof(LogRecordHeader));
+            h += rec.size;
+        }
+        return t;
+    }
+    void release(std::size_t upTo){head.store(upTo, std::memory_order_release);}
+    std::size_t used() const {
+        return tail.load(std::memory_order_relaxed) - head.load(std::memory_order_relaxed);
+    }
+};
+
+class AsyncLogger{
+    private:
+        std::atomic<int> level{static_cast<int>(LogLevel::Info)};
+        std::atomic<int> precision{-1}; //fixed digits for floating point, -1 = stream default
+        std::atomic<bool> console{true};
+        std::size_t ringBytes = 1 << 20;
+        std::mutex mtx; //rings list, flush tickets, file sink
+        std::condition_variable wake;
+        std::condition_variable flushed;
+        std::vector<std::unique_ptr<LogRing>> rings; //every ring ever made, owned here
+        std::vector<LogRing*> freeRings;             //rings whose thread has exited
+        std::uint64_t flushRequested = 0;
+        std::uint64_t flushDone = 0;
+        bool stopping = false;
+        std::atomic<bool> nudged{false}; //a ring is filling up, drain before the timer
+        std::FILE* file = nullptr;
+        std::uint64_t written = 0;
+        std::thread flusher;
+        const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+        struct Pending{
+            std::int64_t timeNs;
+            const LogRecordHeader* header; //copy lives in `headers`
+            const char* payload;
+        };
+        std::vector<LogRecordHeader> headers;
+        std::vector<Pending> batch;
+        std::string consoleText;
+        std::string fileText;
+        std::ostringstream os;
+
+        static const char* levelName(std::uint32_t l){
+            static const char* names[] = {"TRACE", "DEBUG", "INFO", "WARN", "ERROR", "OFF"};
+            return names[l < 6 ? l : 5];
+        }
+        //Gives the calling thread's ring back when the thread exits.
+        //Records still in it are written by the next drain as usual.
+        struct RingHolder{
+            AsyncLogger* owner = nullptr;
+            LogRing* ring = nullptr;
+            ~RingHolder(){
+                if(ring == nullptr) return;
+                std::lock_guard<std::mutex> lock(owner->mtx);
+                owner->freeRings.push_back(ring);
+            }
+        };
+        LogRing& localRing(){
+            thread_local RingHolder holder;
+            if(holder.ring == nullptr){
+                std::lock_guard<std::mutex> lock(mtx);
+                //reuse a ring the flusher has emptied, so a new thread starts with a whole ring
+                auto it = std::find_if(freeRings.begin(), freeRings.end(),
+                                       [&](LogRing* r){ return r->size() >= ringBytes && r->used() == 0; });
+                if(it != freeRings.end()){
+                    holder.ring = *it;
+                    freeRings.erase(it);
+                }
+                else{
+                    rings.push_back(std::make_unique<LogRing>(ringBytes));
+                    holder.ring = rings.back().get();
+                }
+                holder.owner = this;
+            }
+            return *holder.ring;
+        }
+        void applyFloatFormat(std::ostream& o) const {
+            const int digits = precision.load(std::memory_order_relaxed);
+            o.setf(digits >= 0 ? std::ios::fixed : std::ios::fmtflags(0), std::ios::floatfield);
+            o.precision(digits >= 0 ? digits : 6);
+        }
+        //Flusher thread: write everything visible now, oldest first across threads
+        void drain(){
+            std::vector<LogRing*> snapshot;
+            std::FILE* out;
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                for(auto& r : rings){
+                    //a free ring has no writer: look at it only while it still holds records
+                    bool idle = r->used() == 0 &&
+                                std::find(freeRings.begin(), freeRings.end(), r.get()) != freeRings.end();
+                    if(!idle) snapshot.push_back(r.get());
+                }
+                out = file;
+            }
+            headers.clear();
+            batch.clear();
+            std::vector<std::size_t> ends(snapshot.size());
+            for(std::size_t i = 0; i < snapshot.size(); ++i){
+                ends[i] = snapshot[i]->forEach([&](const LogRecordHeader& rec, const char* payload){
+                    headers.push_back(rec);
+                    batch.push_back({rec.timeNs, nullptr, payload});
+                });
+            }
+            if(batch.empty()){
+                for(std::size_t i = 0; i < snapshot.size(); ++i) snapshot[i]->release(ends[i]); //skip markers only
+                return;
+            }
+            for(std::size_t i = 0; i < batch.size(); ++i) batch[i].header = &headers[i];
+            std::stable_sort(batch.begin(), batch.end(), [](const Pending& a, const Pending& b){
+                return a.timeNs < b.timeNs;
+            });
+
+            const bool toConsole = console.load(std::memory_order_relaxed);
+            applyFloatFormat(os);
+            consoleText.clear();
+            fileText.clear();
+            for(const Pending& p : batch){
+                os.str(std::string());
+                p.header->format(p.payload, os);
+                const std::string text = os.str();
+                if(toConsole){
+                    consoleText += text;
+                    consoleText += '\n';
+                }
+                if(out){
+                    char prefix[48];
+                    std::snprintf(prefix, sizeof(prefix), "[%.6f] %-5s ", (p.timeNs - epochNs()) / 1e9,
+                                  levelName(p.header->level));
+                    fileText += prefix;
+                    fileText += text;
+                    fileText += '\n';
+                }
+            }
+            //one write per sink for the whole batch
+            if(!consoleText.empty()){
+                std::fwrite(consoleText.data(), 1, consoleText.size(), stdout);
+                std::fflush(stdout);
+            }
+            if(out && !fileText.empty()){
+                std::fwrite(fileText.data(), 1, fileText.size(), out);
+                std::fflush(out);
+            }
+            written += batch.size();
+            for(std::size_t i = 0; i < snapshot.size(); ++i) snapshot[i]->release(ends[i]);
+        }
+        void flusherLoop(){
+            while(true){
+                std::uint64_t ticket;
+                bool stop;
+                {
+                    std::unique_lock<std::mutex> lock(mtx);
+                    wake.wait_for(lock, std::chrono::milliseconds(5), [&]{
+                        return stopping || flushRequested != flushDone || nudged.load();
+                    });
+                    ticket = flushRequested;
+                    stop = stopping;
+                }
+                nudged.store(false);
+                drain();
+                {
+                    std::lock_guard<std::mutex> lock(mtx);
+                    flushDone = ticket;
+                }
+                flushed.notify_all();
+                if(stop) return;
+            }
+        }
+        std::int64_t epochNs() const {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(epoch.time_since_epoch()).count();
+        }
+        AsyncLogger(){
+            flusher = std::thread(&AsyncLogger::flusherLoop, this);
+        }
+        ~AsyncLogger(){
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                stopping = true;
+            }
+            wake.notify_one();
+            flusher.join();
+            std::uint64_t lost = droppedCount();
+            if(lost > 0) std::fprintf(stderr, "[Logger] %llu records dropped (ring full)\n", static_cast<unsigned long long>(lost));
+            if(file) std::fclose(file);
+        }
+    public:
+        AsyncLogger(const AsyncLogger&) = delete;
+        AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    static AsyncLogger& instance(){
+        static AsyncLogger logger;
+        return logger;
+    }
+    bool enabled(LogLevel l) const {
+        return static_cast<int>(l) >= level.load(std::memory_order_relaxed);
+    }
+    void setLevel(LogLevel l){level.store(static_cast<int>(l), std::memory_order_relaxed);}
+    //Like std::fixed << std::setprecision(digits) for every floating-point argument
+    void setFixedPrecision(int digits){precision.store(digits, std::memory_order_relaxed);}
+    void setConsole(bool on){console.store(on, std::memory_order_relaxed);}
+    //Ring size for threads that log for the first time after this call
+    void setRingBytes(std::size_t bytes){
+        std::lock_guard<std::mutex> lock(mtx);
+        ringBytes = bytes;
+    }
+    //Also write every record, with time and level, to a file (appends)
+    bool openFile(const std::string& path){
+        std::FILE* f = std::fopen(path.c_str(), "a");
+        if(!f) return false;
+        std::lock_guard<std::mutex> lock(mtx);
+        if(file) std::fclose(file);
+        file = f;
+        return true;
+    }
+    //Block until everything logged before this call has been written
+    void flush(){
+        std::unique_lock<std::mutex> lock(mtx);
+        std::uint64_t ticket = ++flushRequested;
+        wake.notify_one();
+        flushed.wait(lock, [&]{ return flushDone >= ticket; });
+    }
+    std::uint64_t droppedCount(){
+        std::lock_guard<std::mutex> lock(mtx);
+        std::uint64_t total = 0;
+        for(auto& r : rings) total += r->dropped.load(std::memory_order_relaxed);
+        return total;
+    }
+
+    //Hot path: encode the arguments into this thread's ring
+    template <typename... Args>
+    void log(LogLevel l, const Args&... args){
+        write(l, logArg(args)...);
+    }
+    template <typename... Stored>
+    void write(LogLevel l, const Stored&... stored){
+        std::size_t payload = (std::size_t(0) + ... + LogCodec<Stored>::size(stored));
+        std::size_t need = (sizeof(LogRecordHeader) + payload + 7) & ~std::size_t(7);
+        LogRing& ring = localRing();
+        if(need > ring.size() / 2){
+            writeTruncated(l, ring.size() / 2, payload, stored...);
+            return;
+        }
+        char* p = ring.reserve(need);
+        if(p == nullptr){
+            ring.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        LogRecordHeader rec;
+        rec.size = static_cast<std::uint32_t>(need);
+        rec.level = static_cast<std::uint32_t>(l);
+        rec.timeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        rec.format = &logFormat<Stored...>;
+        std::memcpy(p, &rec, sizeof(rec));
+        char* q = p + sizeof(rec);
+        ((q = LogCodec<Stored>::write(q, stored)), ...);
+        (void)q;
+        ring.commit();
+        //half full: wake the flusher early (rare, so the syscall doesn't matter)
+        if(ring.used() > ring.size() / 2 && !nudged.exchange(true)) wake.notify_one();
+    }
+    //Record too big for the ring (rare): format it here and log the start of the text
+    template <typename... Stored>
+    void writeTruncated(LogLevel l, std::size_t maxRecord, std::size_t payload, const Stored&... stored){
+        std::vector<char> raw(payload);
+        char* q = raw.data();
+        ((q = LogCodec<Stored>::write(q, stored)), ...);
+        (void)q;
+        std::ostringstream text;
+        applyFloatFormat(text);
+        logFormat<Stored...>(raw.data(), text);
+        std::string s = text.str();
+        const std::string marker = " ...[truncated]";
+        const std::size_t room = maxRecord - sizeof(LogRecordHeader) - sizeof(std::uint32_t);
+        if(s.size() > room){
+            s.resize(room >= marker.size() ? room - marker.size() : room);
+            if(room >= marker.size()) s += marker;
+        }
+        write(l, logArg(s));
+    }
+};
+
+//The level test comes first, so disabled calls don't even evaluate their arguments
+#define ASYNC_LOG(lvl, ...) do{ \
+    if(static_cast<int>(lvl) >= ASYNC_LOG_LEVEL && AsyncLogger::instance().enabled(lvl)) \
+        AsyncLogger::instance().log(lvl, __VA_ARGS__); \
+}while(0)
+#define LOG_TRACE(...) ASYNC_LOG(LogLevel::Trace, __VA_ARGS__)
+#define LOG_DEBUG(...) ASYNC_LOG(LogLevel::Debug, __VA_ARGS__)
+#define LOG_INFO(...)  ASYNC_LOG(LogLevel::Info, __VA_ARGS__)
+#define LOG_WARN(...)  ASYNC_LOG(LogLevel::Warn, __VA_ARGS__)
+#define LOG_ERROR(...) ASYNC_LOG(LogLevel::Error, __VA_ARGS__)
+//Write out pending log lines, e.g. before std::cout prints a menu
+inline void logFlush(){AsyncLogger::instance().flush();}
+
+#endif
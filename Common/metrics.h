@@ -0,0 +1,420 @@
+//metrics.h
+//Hot-path instrumentation shared by all the projects: scoped timers, counters
+//and latency histograms, exported as Prometheus text and as a Chrome trace.
+//  - METRICS_SCOPE("robot_move") times the rest of the block
+//  - METRICS_COUNT("robot_move_rejected", 1) adds to a counter
+//  - METRICS_RECORD_NS("queue_sensor_to_control", ns) adds a latency measured elsewhere
+//  - METRICS_THREAD_NAME("sensor") names the calling thread in the trace
+//  - metricsExport("robot_sim") prints a summary and writes
+//    robot_sim_metrics.prom and robot_sim_trace.json (open the trace in
+//    chrome://tracing or ui.perfetto.dev)
+//Every thread records into its own shard (counters, histograms, trace events),
+//so recording takes no lock and no atomic read-modify-write; an export adds the
+//shards together. Timers read the TSC (rdtsc) on x86 and the steady clock
+//elsewhere. Histograms are HDR-style: 16 linear sub-buckets per power of two,
+//so every value is kept to within about 6% and any quantile can be read back.
+//
+//Compiled out unless the program is built with -DMETRICS_ENABLED=1: then the
+//macros expand to nothing (their arguments are not evaluated) and
+//metricsExport() is empty, so an instrumented function costs exactly what it
+//did before.
+//Include from a project as "../Common/metrics.h".
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <string>
+
+#ifndef METRICS_ENABLED
+#define METRICS_ENABLED 0
+#endif
+
+#if METRICS_ENABLED
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define METRICS_HAVE_RDTSC 1
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define METRICS_HAVE_RDTSC 1
+#endif
+
+inline std::int64_t metricsNowNs(){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+//Timer ticks: TSC cycles where there is one, nanoseconds otherwise
+inline std::uint64_t metricsTicks(){
+#ifdef METRICS_HAVE_RDTSC
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(metricsNowNs());
+#endif
+}
+
+//Only the owning thread writes, so "load, add, store" is enough; the atomics
+//just let an export read the value while the owner keeps going
+inline void metricsBump(std::atomic<std::uint64_t>& a, std::uint64_t n){
+    a.store(a.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+// === HDR-style histogram: bucket = (power of two, top 4 bits below it) ===
+struct HistogramLayout{
+    static constexpr int SUB_BITS = 4;
+    static constexpr int SUB = 1 << SUB_BITS;
+    static constexpr int BUCKETS = (64 - SUB_BITS + 1) * SUB;
+
+    static int bucketOf(std::uint64_t v){
+        if(v < static_cast<std::uint64_t>(SUB)) return static_cast<int>(v);
+        int msb = 63;
+        while(!(v >> msb)) --msb;
+        int shift = msb - SUB_BITS;
+        return (shift + 1) * SUB + static_cast<int>((v >> shift) & (SUB - 1));
+    }
+    //Smallest value of bucket b
+    static std::uint64_t lowest(int b){
+        if(b < SUB) return static_cast<std::uint64_t>(b);
+        int shift = b / SUB - 1;
+        return static_cast<std::uint64_t>(SUB + b % SUB) << shift;
+    }
+    //One past the biggest value of bucket b
+    static std::uint64_t limit(int b){
+        return b < SUB ? static_cast<std::uint64_t>(b) + 1 : lowest(b) + (std::uint64_t(1) << (b / SUB - 1));
+    }
+};
+
+//One thread's histogram
+struct ShardHistogram{
+    std::atomic<std::uint64_t> counts[HistogramLayout::BUCKETS] = {};
+    std::atomic<std::uint64_t> total{0};
+    std::atomic<std::uint64_t> sum{0};
+    std::atomic<std::uint64_t> max{0};
+
+    void record(std::uint64_t v){
+        metricsBump(counts[HistogramLayout::bucketOf(v)], 1);
+        metricsBump(total, 1);
+        metricsBump(sum, v);
+        if(v > max.load(std::memory_order_relaxed)) max.store(v, std::memory_order_relaxed);
+    }
+};
+//Every thread's histogram of one metric added up, for reports
+struct MergedHistogram{
+    std::vector<std::uint64_t> counts = std::vector<std::uint64_t>(HistogramLayout::BUCKETS, 0);
+    std::uint64_t total = 0;
+    std::uint64_t sum = 0;
+    std::uint64_t max = 0;
+
+    void add(const ShardHistogram& h){
+        for(int b = 0; b < HistogramLayout::BUCKETS; ++b) counts[b] += h.counts[b].load(std::memory_order_relaxed);
+        total += h.total.load(std::memory_order_relaxed);
+        sum += h.sum.load(std::memory_order_relaxed);
+        max = std::max(max, h.max.load(std::memory_order_relaxed));
+    }
+    //Value at quantile q (0..1), in the histogram's unit: the top of its bucket
+    std::uint64_t quantile(double q) const {
+        if(total == 0) return 0;
+        std::uint64_t rank = static_cast<std::uint64_t>(q * static_cast<double>(total - 1)) + 1;
+        std::uint64_t seen = 0;
+        for(int b = 0; b < HistogramLayout::BUCKETS; ++b){
+            seen += counts[b];
+            if(seen >= rank) return std::min(max, HistogramLayout::limit(b) - 1);
+        }
+        return max;
+    }
+};
+
+enum class MetricKind {Counter, Timer, Latency}; //Timer: ticks, Latency: nanoseconds
+
+//One finished METRICS_SCOPE, for the Chrome trace
+struct TraceEvent{
+    std::uint64_t start; //ticks
+    std::uint64_t ticks;
+    std::uint32_t metric;
+};
+
+// === one thread's records: only that thread writes, exports read ===
+class MetricShard{
+    public:
+        static constexpr std::size_t MAX_METRICS = 64;
+        static constexpr std::size_t TRACE_EVENTS = 1 << 16; //further events are counted, not kept
+
+        std::atomic<std::uint64_t> counters[MAX_METRICS] = {};
+        std::atomic<ShardHistogram*> histograms[MAX_METRICS] = {}; //created on first use
+        std::unique_ptr<TraceEvent[]> trace;
+        std::atomic<std::size_t> traceCount{0};
+        std::atomic<std::uint64_t> traceDropped{0};
+        std::string threadName;
+        std::uint32_t tid;
+
+        explicit MetricShard(std::uint32_t id) : tid(id){}
+        ~MetricShard(){
+            for(auto& h : histograms) delete h.load();
+        }
+        MetricShard(const MetricShard&) = delete;
+        MetricShard& operator=(const MetricShard&) = delete;
+
+    ShardHistogram& histogram(int metric){
+        ShardHistogram* h = histograms[metric].load(std::memory_order_relaxed);
+        if(h == nullptr){
+            h = new ShardHistogram();
+            histograms[metric].store(h, std::memory_order_release);
+        }
+        return *h;
+    }
+    void addTrace(std::uint64_t start, std::uint64_t ticks, int metric){
+        std::size_t n = traceCount.load(std::memory_order_relaxed);
+        if(n >= TRACE_EVENTS){
+            metricsBump(traceDropped, 1);
+            return;
+        }
+        if(!trace) trace.reset(new TraceEvent[TRACE_EVENTS]);
+        trace[n] = {start, ticks, static_cast<std::uint32_t>(metric)};
+        traceCount.store(n + 1, std::memory_order_release);
+    }
+};
+
+class Metrics{
+    private:
+        struct Info{
+            std::string name;
+            MetricKind kind;
+        };
+        std::mutex mtx; //metric names and the shard list; never taken while recording
+        std::vector<Info> infos;
+        std::vector<std::unique_ptr<MetricShard>> shards;
+        const std::uint64_t startTicks = metricsTicks();
+        const std::int64_t startNs = metricsNowNs();
+
+        Metrics() = default;
+
+        //Nanoseconds per tick, measured against the steady clock since startup
+        double nsPerTick(){
+#ifdef METRICS_HAVE_RDTSC
+            //at least 10 ms between the two readings for a stable ratio
+            while(metricsNowNs() - startNs < 10000000) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            std::uint64_t ticks = metricsTicks() - startTicks;
+            std::int64_t ns = metricsNowNs() - startNs;
+            return ticks > 0 ? static_cast<double>(ns) / static_cast<double>(ticks) : 1.0;
+#else
+            return 1.0;
+#endif
+        }
+        //Every shard's histogram of one metric
+        MergedHistogram merged(std::size_t metric){
+            MergedHistogram m;
+            for(auto& s : shards){
+                ShardHistogram* h = s->histograms[metric].load(std::memory_order_acquire);
+                if(h) m.add(*h);
+            }
+            return m;
+        }
+        std::uint64_t counterTotal(std::size_t metric){
+            std::uint64_t total = 0;
+            for(auto& s : shards) total += s->counters[metric].load(std::memory_order_relaxed);
+            return total;
+        }
+    public:
+        Metrics(const Metrics&) = delete;
+        Metrics& operator=(const Metrics&) = delete;
+
+    static Metrics& instance(){
+        static Metrics metrics;
+        return metrics;
+    }
+    //Id of a metric, registered on first use (-1 once MAX_METRICS are taken).
+    //The macros call this once per call site.
+    int id(const char* name, MetricKind kind){
+        std::lock_guard<std::mutex> lock(mtx);
+        for(std::size_t i = 0; i < infos.size(); ++i){
+            if(infos[i].name == name && infos[i].kind == kind) return static_cast<int>(i);
+        }
+        if(infos.size() >= MetricShard::MAX_METRICS){
+            std::cout << "[Metrics] too many metrics, '" << name << "' is not recorded\n";
+            return -1;
+        }
+        infos.push_back({name, kind});
+        return static_cast<int>(infos.size() - 1);
+    }
+    MetricShard& local(){
+        thread_local MetricShard* shard = nullptr;
+        if(shard == nullptr){
+            std::lock_guard<std::mutex> lock(mtx);
+            shards.push_back(std::make_unique<MetricShard>(static_cast<std::uint32_t>(shards.size() + 1)));
+            shard = shards.back().get();
+        }
+        return *shard;
+    }
+
+    void count(int metric, std::uint64_t n){
+        if(metric >= 0) metricsBump(local().counters[metric], n);
+    }
+    void recordTimer(int metric, std::uint64_t start, std::uint64_t end){
+        if(metric < 0) return;
+        MetricShard& s = local();
+        s.histogram(metric).record(end - start);
+        s.addTrace(start, end - start, metric);
+    }
+    void recordNs(int metric, std::int64_t ns){
+        if(metric >= 0) local().histogram(metric).record(ns > 0 ? static_cast<std::uint64_t>(ns) : 0);
+    }
+    void nameThread(const std::string& name){
+        MetricShard& s = local();
+        std::lock_guard<std::mutex> lock(mtx);
+        s.threadName = name;
+    }
+
+    //count, mean, p50 / p90 / p99 / p99.9 and max of every histogram, in microseconds
+    void printReport(std::ostream& os){
+        const double tickNs = nsPerTick();
+        std::lock_guard<std::mutex> lock(mtx);
+        os << "\n=== Metrics (us) ===\n";
+        os << "name\tcount\tmean\tp50\tp90\tp99\tp99.9\tmax\n";
+        char line[256];
+        for(std::size_t i = 0; i < infos.size(); ++i){
+            if(infos[i].kind == MetricKind::Counter){
+                os << infos[i].name << "\t" << counterTotal(i) << "\n";
+                continue;
+            }
+            MergedHistogram h = merged(i);
+            if(h.total == 0) continue;
+            const double us = (infos[i].kind == MetricKind::Timer ? tickNs : 1.0) / 1000.0;
+            std::snprintf(line, sizeof(line), "%s\t%llu\t%.3f\t%.3f\t%.3f\t%.3f\t%.3f\t%.3f\n", infos[i].name.c_str(),
+                          static_cast<unsigned long long>(h.total), h.sum * us / h.total,
+                          h.quantile(0.5) * us, h.quantile(0.9) * us, h.quantile(0.99) * us,
+                          h.quantile(0.999) * us, h.max * us);
+            os << line;
+        }
+    }
+    //Prometheus text format: counters as <name>_total, histograms as
+    //<name>_seconds with one bucket per power of two
+    bool writePrometheus(const std::string& path){
+        std::FILE* f = std::fopen(path.c_str(), "w");
+        if(!f) return false;
+        const double tickNs = nsPerTick();
+        std::lock_guard<std::mutex> lock(mtx);
+        for(std::size_t i = 0; i < infos.size(); ++i){
+            const char* name = infos[i].name.c_str();
+            if(infos[i].kind == MetricKind::Counter){
+                std::fprintf(f, "# TYPE %s_total counter\n%s_total %llu\n", name, name,
+                             static_cast<unsigned long long>(counterTotal(i)));
+                continue;
+            }
+            MergedHistogram h = merged(i);
+            const double seconds = (infos[i].kind == MetricKind::Timer ? tickNs : 1.0) / 1e9;
+            std::fprintf(f, "# TYPE %s_seconds histogram\n", name);
+            int first = 0;
+            int last = -1;
+            for(int b = 0; b < HistogramLayout::BUCKETS; ++b){
+                if(h.counts[b] == 0) continue;
+                if(last < 0) first = b;
+                last = b;
+            }
+            //cumulative counts at the end of every power of two between the
+            //first and the last used bucket
+            std::uint64_t cumulative = 0;
+            for(int b = first; b <= last; ++b){
+                cumulative += h.counts[b];
+                if(b % HistogramLayout::SUB == HistogramLayout::SUB - 1 || b == last){
+                    std::fprintf(f, "%s_seconds_bucket{le=\"%.9g\"} %llu\n", name,
+                                 HistogramLayout::limit(b) * seconds, static_cast<unsigned long long>(cumulative));
+                }
+            }
+            std::fprintf(f, "%s_seconds_bucket{le=\"+Inf\"} %llu\n", name, static_cast<unsigned long long>(h.total));
+            std::fprintf(f, "%s_seconds_sum %.9g\n", name, h.sum * seconds);
+            std::fprintf(f, "%s_seconds_count %llu\n", name, static_cast<unsigned long long>(h.total));
+        }
+        std::fclose(f);
+        return true;
+    }
+    //Chrome trace event format: one complete ("X") event per recorded scope
+    bool writeChromeTrace(const std::string& path){
+        std::FILE* f = std::fopen(path.c_str(), "w");
+        if(!f) return false;
+        const double tickUs = nsPerTick() / 1000.0;
+        std::lock_guard<std::mutex> lock(mtx);
+        std::fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+        bool firstEvent = true;
+        std::uint64_t dropped = 0;
+        for(auto& s : shards){
+            std::fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                         firstEvent ? "" : ",\n", s->tid,
+                         s->threadName.empty() ? ("thread " + std::to_string(s->tid)).c_str() : s->threadName.c_str());
+            firstEvent = false;
+            const std::size_t n = s->traceCount.load(std::memory_order_acquire);
+            for(std::size_t e = 0; e < n; ++e){
+                const TraceEvent& ev = s->trace[e];
+                std::fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                             infos[ev.metric].name.c_str(), s->tid,
+                             static_cast<double>(ev.start - startTicks) * tickUs, ev.ticks * tickUs);
+            }
+            dropped += s->traceDropped.load(std::memory_order_relaxed);
+        }
+        std::fprintf(f, "\n],\"otherData\":{\"droppedEvents\":\"%llu\"}}\n", static_cast<unsigned long long>(dropped));
+        std::fclose(f);
+        return true;
+    }
+};
+
+//Times its own lifetime
+class MetricsScope{
+    private:
+        int metric;
+        std::uint64_t start;
+    public:
+        explicit MetricsScope(int id) : metric(id), start(metricsTicks()){}
+        ~MetricsScope(){Metrics::instance().recordTimer(metric, start, metricsTicks());}
+        MetricsScope(const MetricsScope&) = delete;
+        MetricsScope& operator=(const MetricsScope&) = delete;
+};
+
+//Summary on std::cout plus <prefix>_metrics.prom and <prefix>_trace.json
+inline void metricsExport(const char* prefix){
+    Metrics& m = Metrics::instance();
+    m.printReport(std::cout);
+    const std::string prom = std::string(prefix) + "_metrics.prom";
+    const std::string trace = std::string(prefix) + "_trace.json";
+    if(m.writePrometheus(prom) && m.writeChromeTrace(trace)){
+        std::cout << "metrics written to " << prom << " and " << trace << "\n";
+    }
+    else{
+        std::cout << "[Metrics] cannot write " << prom << " / " << trace << "\n";
+    }
+}
+
+#define METRICS_CAT2(a, b) a##b
+#define METRICS_CAT(a, b) METRICS_CAT2(a, b)
+//The metric id is looked up once per call site (function-local static)
+#define METRICS_SCOPE(name) \
+    static const int METRICS_CAT(metricsId_, __LINE__) = Metrics::instance().id(name, MetricKind::Timer); \
+    MetricsScope METRICS_CAT(metricsScope_, __LINE__)(METRICS_CAT(metricsId_, __LINE__))
+#define METRICS_COUNT(name, n) do{ \
+    static const int metricsId_ = Metrics::instance().id(name, MetricKind::Counter); \
+    Metrics::instance().count(metricsId_, static_cast<std::uint64_t>(n)); \
+}while(0)
+#define METRICS_RECORD_NS(name, ns) do{ \
+    static const int metricsId_ = Metrics::instance().id(name, MetricKind::Latency); \
+    Metrics::instance().recordNs(metricsId_, static_cast<std::int64_t>(ns)); \
+}while(0)
+#define METRICS_THREAD_NAME(name) Metrics::instance().nameThread(name)
+
+#else
+
+//Compiled out: sizeof keeps the arguments "used" without evaluating them
+#define METRICS_SCOPE(name) ((void)sizeof(name))
+#define METRICS_COUNT(name, n) ((void)sizeof(n))
+#define METRICS_RECORD_NS(name, ns) ((void)sizeof(ns))
+#define METRICS_THREAD_NAME(name) ((void)sizeof(name))
+inline void metricsExport(const char*){}
+
+#endif
+
+#endif
@@ -0,0 +1,110 @@
+//scenario_file.h
+//Plain-text scenario files for the headless batch modes.
+//One setting per line: a key followed by its values, separated by spaces.
+//'#' starts a comment. A key may appear more than once (e.g. one line per obstacle).
+//
+//  # 1000 x 1000 world, 2000 robots
+//  world 1000 1000
+//  robots wheeled 1000
+//  robots flying 1000
+//  ticks 1000000
+//
+//What the keys mean is up to each program; this file only reads them.
+//Include from a project as "../Common/scenario_file.h".
+#ifndef SCENARIO_FILE_H
+#define SCENARIO_FILE_H
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+class ScenarioFile{
+    private:
+        std::vector<std::pair<std::string, std::vector<std::string>>> entries;
+        std::string source;
+
+        const std::vector<std::string>* find(const std::string& key) const {
+            //the last line wins for single-value settings
+            for(auto it = entries.rbegin(); it != entries.rend(); ++it){
+                if(it->first == key) return &it->second;
+            }
+            return nullptr;
+        }
+    public:
+    //Returns false (and says why) if the file can't be read
+    bool load(const std::string& path){
+        std::ifstream in(path);
+        if(!in){
+            std::cout << "Cannot open scenario file " << path << "\n";
+            return false;
+        }
+        source = path;
+        entries.clear();
+        std::string line;
+        while(std::getline(in, line)){
+            std::size_t hash = line.find('#');
+            if(hash != std::string::npos) line.erase(hash);
+            std::istringstream words(line);
+            std::string key;
+            if(!(words >> key)) continue; //blank line
+            std::vector<std::string> values;
+            std::string value;
+            while(words >> value) values.push_back(value);
+            entries.emplace_back(key, values);
+        }
+        return true;
+    }
+    const std::string& path() const {return source;}
+    bool has(const std::string& key) const {return find(key) != nullptr;}
+    //Value number `index` of the last line with this key, or `fallback`
+    std::string getString(const std::string& key, std::size_t index = 0, const std::string& fallback = "") const {
+        const auto* values = find(key);
+        return values && index < values->size() ? (*values)[index] : fallback;
+    }
+    long long getInt(const std::string& key, std::size_t index, long long fallback) const {
+        std::string text = getString(key, index);
+        if(text.empty()) return fallback;
+        try{
+            return std::stoll(text, nullptr, 0); //0x... works too
+        }
+        catch(...){
+            std::cout << source << ": '" << key << "' expects a number, got '" << text << "'\n";
+            return fallback;
+        }
+    }
+    double getDouble(const std::string& key, std::size_t index, double fallback) const {
+        std::string text = getString(key, index);
+        if(text.empty()) return fallback;
+        try{
+            return std::stod(text);
+        }
+        catch(...){
+            std::cout << source << ": '" << key << "' expects a number, got '" << text << "'\n";
+            return fallback;
+        }
+    }
+    //Every line with this key, in file order
+    std::vector<std::vector<std::string>> all(const std::string& key) const {
+        std::vector<std::vector<std::string>> lines;
+        for(const auto& e : entries){
+            if(e.first == key) lines.push_back(e.second);
+        }
+        return lines;
+    }
+};
+
+//FNV-1a, used for the final state hashes that regression runs compare
+inline std::uint64_t fnv1a(const void* data, std::size_t size, std::uint64_t hash = 0xCBF29CE484222325ull){
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for(std::size_t i = 0; i < size; ++i){
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+#endif
@@ -0,0 +1,552 @@
+//task_scheduler.h
+//Work-stealing thread pool shared by all the projects, so simulation ticks,
+//proximity queries and sensor analytics run on one set of threads instead of
+//each starting its own and fighting over the cores.
+//  - every thread that runs tasks owns a Chase-Lev deque: it pushes and pops
+//    its own work at the bottom (newest first, still warm in its cache) and
+//    idle threads steal from the top (oldest first, which for a split range is
+//    the biggest piece left)
+//  - parallelFor(n, fn) calls fn(begin, end, thread) over [0, n). A range is
+//    cut into a few pieces up front and split further only while some thread
+//    is out of work, so the grain adapts to how uneven the work is
+//  - spawn(fn) / spawnAfter(deps, fn) / then(task, fn) run a task once the
+//    tasks it depends on have finished; wait(task) helps out until it is done
+//  - reservedCpus keeps CPUs free for loops that need their own thread (the
+//    PeriodicScheduler sensor/control loops): the pool only sizes itself, and
+//    with pin only runs, on the CPUs after them
+//`thread` is the index of the thread running fn, 0 .. size() - 1, so per-thread
+//scratch can be indexed by it. Outside threads (the main loop, a control loop)
+//join in through one of the `callers` slots, which are indices 0 .. callers - 1.
+//Tasks must not throw.
+//Include from a project as "../Common/task_scheduler.h".
+#ifndef TASK_SCHEDULER_H
+#define TASK_SCHEDULER_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <cstring>
+#endif
+#include "metrics.h"
+
+//Anything a worker can run
+struct SchedulerJob{
+    virtual void execute(unsigned thread) = 0;
+    virtual ~SchedulerJob() = default;
+};
+
+//Chase-Lev deque (the C11 version by Le, Pop, Cohen and Zappa Nardelli).
+//Only the owner calls push() and pop(); any thread may call steal().
+//The array doubles when full. Old arrays are kept until the deque dies,
+//because a thief may still be reading one.
+class WorkStealingDeque{
+    private:
+        struct Ring{
+            std::int64_t mask;
+            std::unique_ptr<std::atomic<SchedulerJob*>[]> slots;
+            explicit Ring(std::int64_t capacity)
+                : mask(capacity - 1), slots(new std::atomic<SchedulerJob*>[static_cast<std::size_t>(capacity)]){}
+            SchedulerJob* get(std::int64_t i) const {return slots[i & mask].load(std::memory_order_relaxed);}
+            void put(std::int64_t i, SchedulerJob* job){slots[i & mask].store(job, std::memory_order_relaxed);}
+        };
+        alignas(64) std::atomic<std::int64_t> top{0};    //thieves
+        alignas(64) std::atomic<std::int64_t> bottom{0}; //owner
+        std::atomic<Ring*> ring;
+        std::vector<std::unique_ptr<Ring>> rings; //owner only, current one last
+    public:
+        explicit WorkStealingDeque(std::int64_t capacity = 256){
+            std::int64_t c = 2;
+            while(c < capacity) c <<= 1;
+            rings.push_back(std::make_unique<Ring>(c));
+            ring.store(rings.back().get(), std::memory_order_relaxed);
+        }
+        WorkStealingDeque(const WorkStealingDeque&) = delete;
+        WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    void push(SchedulerJob* job){
+        std::int64_t b = bottom.load(std::memory_order_relaxed);
+        std::int64_t t = top.load(std::memory_order_acquire);
+        Ring* r = ring.load(std::memory_order_relaxed);
+        if(b - t > r->mask){
+            auto bigger = std::make_unique<Ring>((r->mask + 1) * 2);
+            for(std::int64_t i = t; i < b; ++i) bigger->put(i, r->get(i));
+            r = bigger.get();
+            rings.push_back(std::move(bigger));
+            ring.store(r, std::memory_order_release);
+        }
+        r->put(b, job);
+        bottom.store(b + 1, std::memory_order_release); //publishes the job to thieves
+    }
+    //Newest job, or null
+    SchedulerJob* pop(){
+        std::int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        Ring* r = ring.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = top.load(std::memory_order_relaxed);
+        if(t > b){
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        SchedulerJob* job = r->get(b);
+        if(t == b){
+            //last one: race the thieves for it
+            if(!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) job = nullptr;
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return job;
+    }
+    //Oldest job, or null if empty or another thread got there first
+    SchedulerJob* steal(){
+        std::int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t b = bottom.load(std::memory_order_acquire);
+        if(t >= b) return nullptr;
+        SchedulerJob* job = ring.load(std::memory_order_acquire)->get(t);
+        if(!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) return nullptr;
+        return job;
+    }
+    bool empty() const {
+        return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+    }
+};
+
+struct SchedulerOptions{
+    unsigned threads = 0;      //threads that run tasks, caller slots included
+                               //(0 = one per CPU not reserved, at least one worker)
+    unsigned callers = 1;      //outside threads that can join in at the same time
+    unsigned reservedCpus = 0; //CPUs 0 .. reservedCpus - 1 are left to dedicated loops
+    bool pin = false;          //pin worker i to CPU reservedCpus + i (Linux only)
+};
+
+struct SchedulerStats{
+    std::uint64_t executed = 0; //jobs run (tasks and range pieces)
+    std::uint64_t stolen = 0;   //of those, taken from another thread's deque
+    std::uint64_t sleeps = 0;   //times a worker ran out of work and went to sleep
+};
+
+class TaskScheduler;
+
+//A spawned task. Copies refer to the same task.
+class TaskHandle{
+    private:
+        friend class TaskScheduler;
+        struct Node : SchedulerJob{
+            TaskScheduler* owner = nullptr;
+            std::function<void()> fn;
+            std::atomic<int> waitingFor{1}; //unfinished dependencies + 1 until it is released
+            std::atomic<bool> finished{false};
+            std::mutex mtx;
+            std::vector<std::shared_ptr<Node>> next; //continuations, guarded by mtx
+            std::shared_ptr<Node> self; //keeps the node alive while it is queued
+            void execute(unsigned thread) override;
+        };
+        std::shared_ptr<Node> node;
+        explicit TaskHandle(std::shared_ptr<Node> n) : node(std::move(n)){}
+    public:
+        TaskHandle() = default;
+
+    bool valid() const {return static_cast<bool>(node);}
+    //An empty handle counts as done
+    bool done() const {return !node || node->finished.load(std::memory_order_acquire);}
+};
+
+class TaskScheduler{
+    private:
+        friend class TaskHandle;
+        //One piece of a parallelFor range
+        struct RangeJob;
+        struct ForState{
+            TaskScheduler* scheduler = nullptr;
+            const void* fn = nullptr;
+            void (*call)(const void*, std::size_t, std::size_t, unsigned) = nullptr;
+            std::size_t grain = 1;
+            std::atomic<std::size_t> pending{1}; //pieces not finished yet
+            RangeJob* pieces = nullptr;          //spare pieces for splits
+            std::size_t pieceCount = 0;
+            std::atomic<std::size_t> nextPiece{0};
+        };
+        struct RangeJob : SchedulerJob{
+            ForState* state = nullptr;
+            std::size_t begin = 0;
+            std::size_t end = 0;
+            void execute(unsigned thread) override {
+                ForState& f = *state;
+                TaskScheduler& s = *f.scheduler;
+                std::size_t b = begin, e = end;
+                while(e - b > f.grain){
+                    //someone is looking for work: hand them the upper half
+                    if(s.searching.load(std::memory_order_relaxed) > 0 && s.split(f, thread, b, e)) continue;
+                    f.call(f.fn, b, b + f.grain, thread);
+                    b += f.grain;
+                }
+                if(b < e) f.call(f.fn, b, e, thread);
+                f.pending.fetch_sub(1, std::memory_order_acq_rel);
+            }
+        };
+
+        struct alignas(64) Slot{
+            WorkStealingDeque deque;
+            std::atomic<std::uint64_t> executed{0};
+            std::atomic<std::uint64_t> stolen{0};
+            std::atomic<std::uint64_t> sleeps{0};
+            bool claimed = false; //caller slots only, guarded by callerMtx
+            //parallelFor pieces of calls made from this slot, kept between calls
+            //so a call doesn't allocate; a nested call takes the ones after
+            //those still in use
+            std::vector<RangeJob> pieces;
+            std::size_t piecesInUse = 0;
+        };
+        //Which scheduler and slot the current thread is running in, if any
+        struct Participant{
+            TaskScheduler* scheduler = nullptr;
+            unsigned slot = 0;
+        };
+        static Participant& current(){
+            static thread_local Participant p;
+            return p;
+        }
+        //Holds a caller slot for an outside thread; a thread already running
+        //in this scheduler keeps its own
+        class CallerSlot{
+            private:
+                TaskScheduler& s;
+                Participant saved;
+                bool claimed = false;
+            public:
+                explicit CallerSlot(TaskScheduler& scheduler) : s(scheduler), saved(current()){
+                    if(saved.scheduler == &s) return;
+                    std::unique_lock<std::mutex> lock(s.callerMtx);
+                    unsigned slot = 0;
+                    s.callerFree.wait(lock, [&]{
+                        for(slot = 0; slot < s.callers; ++slot) if(!s.slots[slot]->claimed) return true;
+                        return false;
+                    });
+                    s.slots[slot]->claimed = true;
+                    current() = Participant{&s, slot};
+                    claimed = true;
+                }
+                ~CallerSlot(){
+                    if(!claimed) return;
+                    {
+                        std::lock_guard<std::mutex> lock(s.callerMtx);
+                        s.slots[current().slot]->claimed = false;
+                    }
+                    s.callerFree.notify_one();
+                    current() = saved;
+                }
+                CallerSlot(const CallerSlot&) = delete;
+                CallerSlot& operator=(const CallerSlot&) = delete;
+            unsigned slot() const {return current().slot;}
+        };
+        unsigned callers;
+        unsigned reservedCpus;
+        bool pin;
+        std::vector<std::unique_ptr<Slot>> slots; //callers first, then workers
+        std::vector<std::thread> workers;
+        std::mutex injectMtx;
+        std::vector<SchedulerJob*> injected; //pushed by threads without a slot
+        std::atomic<std::size_t> injectedCount{0};
+        std::mutex callerMtx;
+        std::condition_variable callerFree;
+        std::mutex sleepMtx;
+        std::condition_variable wake;
+        std::uint64_t epoch = 0; //bumped under sleepMtx to wake sleepers
+        std::atomic<unsigned> sleepers{0};
+        std::atomic<unsigned> searching{0}; //awake threads without work
+        bool stopping = false;
+
+        //Move the upper half of [b, e) to a new piece on this thread's deque
+        bool split(ForState& f, unsigned thread, std::size_t b, std::size_t& e){
+            std::size_t i = f.nextPiece.fetch_add(1, std::memory_order_relaxed);
+            if(i >= f.pieceCount) return false;
+            RangeJob& piece = f.pieces[i];
+            piece.state = &f;
+            piece.begin = b + (e - b) / 2;
+            piece.end = e;
+            e = piece.begin;
+            f.pending.fetch_add(1, std::memory_order_relaxed);
+            push(&piece, thread);
+            return true;
+        }
+        //Queue a job on the current thread's deque, or the shared list if it has none
+        void push(SchedulerJob* job, unsigned thread){
+            slots[thread]->deque.push(job);
+            notify();
+        }
+        void schedule(SchedulerJob* job){
+            const Participant& p = current();
+            if(p.scheduler == this){
+                push(job, p.slot);
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(injectMtx);
+                injected.push_back(job);
+                injectedCount.store(injected.size(), std::memory_order_relaxed);
+            }
+            notify();
+        }
+        void notify(){
+            //pairs with the fence in sleep(): either we see the sleeper or it sees the job
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if(sleepers.load(std::memory_order_relaxed) == 0) return;
+            {
+                std::lock_guard<std::mutex> lock(sleepMtx);
+                ++epoch;
+            }
+            wake.notify_one();
+        }
+        bool anyWork() const {
+            if(injectedCount.load(std::memory_order_relaxed) > 0) return true;
+            for(const auto& s : slots) if(!s->deque.empty()) return true;
+            return false;
+        }
+        //Own deque first, then the shared list, then steal, starting after ourselves
+        SchedulerJob* findJob(unsigned thread){
+            Slot& own = *slots[thread];
+            if(SchedulerJob* job = own.deque.pop()) return job;
+            if(injectedCount.load(std::memory_order_relaxed) > 0){
+                std::lock_guard<std::mutex> lock(injectMtx);
+                if(!injected.empty()){
+                    SchedulerJob* job = injected.front();
+                    injected.erase(injected.begin());
+                    injectedCount.store(injected.size(), std::memory_order_relaxed);
+                    return job;
+                }
+            }
+            const unsigned n = size();
+            for(unsigned k = 1; k < n; ++k){
+                if(SchedulerJob* job = slots[(thread + k) % n]->deque.steal()){
+                    own.stolen.fetch_add(1, std::memory_order_relaxed);
+                    return job;
+                }
+            }
+            return nullptr;
+        }
+        bool runOne(unsigned thread){
+            SchedulerJob* job = findJob(thread);
+            if(!job) return false;
+            slots[thread]->executed.fetch_add(1, std::memory_order_relaxed);
+            job->execute(thread);
+            return true;
+        }
+        //Help out until done() is true
+        template <typename Done>
+        void helpUntil(unsigned thread, Done done){
+            bool idle = false;
+            while(!done()){
+                if(runOne(thread)){
+                    if(idle) searching.fetch_sub(1, std::memory_order_relaxed);
+                    idle = false;
+                    continue;
+                }
+                if(!idle) searching.fetch_add(1, std::memory_order_relaxed);
+                idle = true;
+                std::this_thread::yield();
+            }
+            if(idle) searching.fetch_sub(1, std::memory_order_relaxed);
+        }
+        //Returns false once the scheduler is stopping and nothing is left
+        bool sleep(unsigned thread){
+            std::unique_lock<std::mutex> lock(sleepMtx);
+            const std::uint64_t seen = epoch;
+            sleepers.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            bool work = anyWork();
+            if(!work && !stopping){
+                slots[thread]->sleeps.fetch_add(1, std::memory_order_relaxed);
+                wake.wait(lock, [&]{ return stopping || epoch != seen; });
+                work = anyWork();
+            }
+            sleepers.fetch_sub(1, std::memory_order_relaxed);
+            return work || !stopping;
+        }
+        void workerLoop(unsigned thread){
+            current() = Participant{this, thread};
+            const unsigned worker = thread - callers;
+            METRICS_THREAD_NAME("worker " + std::to_string(worker));
+            if(pin) pinTo(static_cast<int>(reservedCpus + worker));
+            const int SPINS = 64; //tries before sleeping; each one yields the CPU
+            while(true){
+                if(runOne(thread)) continue;
+                searching.fetch_add(1, std::memory_order_relaxed);
+                bool found = false;
+                for(int i = 0; i < SPINS && !found; ++i){
+                    std::this_thread::yield();
+                    found = runOne(thread);
+                }
+                searching.fetch_sub(1, std::memory_order_relaxed);
+                if(!found && !sleep(thread)) return;
+            }
+        }
+        static void pinTo(int cpu){
+#ifdef __linux__
+            unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(static_cast<unsigned>(cpu) % cpus, &set);
+            int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+            if(err != 0) std::cout << "[TaskScheduler] cannot pin a worker to CPU " << cpu << " (" << std::strerror(err) << ")\n";
+#else
+            (void)cpu;
+#endif
+        }
+    public:
+        explicit TaskScheduler(const SchedulerOptions& options)
+            : callers(std::max(1u, options.callers)), reservedCpus(options.reservedCpus), pin(options.pin){
+            unsigned threads = options.threads;
+            if(threads == 0){
+                unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+                threads = std::max(callers + 1, cpus > reservedCpus ? cpus - reservedCpus : 1);
+            }
+            const unsigned workerCount = threads > callers ? threads - callers : 0;
+            for(unsigned i = 0; i < callers + workerCount; ++i) slots.push_back(std::make_unique<Slot>());
+            for(unsigned i = 0; i < workerCount; ++i){
+                workers.emplace_back(&TaskScheduler::workerLoop, this, callers + i);
+            }
+        }
+        //threads includes the calling thread, so 1 means "no extra threads"
+        explicit TaskScheduler(unsigned threads) : TaskScheduler(SchedulerOptions{std::max(1u, threads), 1, 0, false}){}
+        //Runs whatever is still queued, then stops the workers
+        ~TaskScheduler(){
+            {
+                std::lock_guard<std::mutex> lock(sleepMtx);
+                stopping = true;
+            }
+            wake.notify_all();
+            for(auto& t : workers) t.join();
+        }
+        TaskScheduler(const TaskScheduler&) = delete;
+        TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    //Number of thread indices: caller slots + workers
+    unsigned size() const {return static_cast<unsigned>(slots.size());}
+    unsigned workerCount() const {return static_cast<unsigned>(workers.size());}
+    //CPU for the i-th dedicated loop (TaskOptions::cpu), -1 if none was reserved for it
+    int reservedCpu(unsigned i) const {
+        return i < reservedCpus ? static_cast<int>(i % std::max(1u, std::thread::hardware_concurrency())) : -1;
+    }
+
+    //Run fn(begin, end, thread) over pieces of [0, n) and wait for all of them.
+    //grain is the smallest piece (0 = about n / (8 * size())). Which thread gets
+    //which piece is not fixed: for a fixed split, pass n = number of chunks, grain 1.
+    template <typename Fn>
+    void parallelFor(std::size_t n, const Fn& fn, std::size_t grain = 0){
+        if(n == 0) return;
+        if(grain == 0) grain = std::max<std::size_t>(1, n / (8 * static_cast<std::size_t>(size())));
+        CallerSlot caller(*this);
+        const unsigned thread = caller.slot();
+        if(size() == 1 || n <= grain){
+            fn(0, n, thread);
+            return;
+        }
+        //a split never makes a piece under grain / 2, so there are fewer than 2n / grain
+        const std::size_t maxPieces = 64 * static_cast<std::size_t>(size());
+        const std::size_t pieceCount = std::min<std::size_t>(2 * (n / grain) + 1, maxPieces);
+        Slot& own = *slots[thread];
+        if(own.pieces.empty()) own.pieces.resize(maxPieces);
+        std::unique_ptr<RangeJob[]> overflow; //only for nested calls that don't fit
+        RangeJob* pieces;
+        if(own.piecesInUse + pieceCount <= own.pieces.size()){
+            pieces = own.pieces.data() + own.piecesInUse;
+            own.piecesInUse += pieceCount;
+        }
+        else{
+            overflow.reset(new RangeJob[pieceCount]);
+            pieces = overflow.get();
+        }
+        ForState f;
+        f.scheduler = this;
+        f.fn = &fn;
+        f.call = [](const void* p, std::size_t b, std::size_t e, unsigned t){ (*static_cast<const Fn*>(p))(b, e, t); };
+        f.grain = grain;
+        f.pieces = pieces;
+        f.pieceCount = pieceCount;
+        RangeJob root;
+        root.state = &f;
+        root.begin = 0;
+        root.end = n;
+        //halve a few times up front (biggest halves first, which thieves take
+        //first), so sleeping workers are woken and start on large pieces
+        std::size_t end = n;
+        for(unsigned k = 1; k < size() && end > grain; k <<= 1) split(f, thread, 0, end);
+        root.end = end;
+        root.execute(thread);
+        helpUntil(thread, [&]{ return f.pending.load(std::memory_order_acquire) == 0; });
+        if(!overflow) own.piecesInUse -= pieceCount;
+    }
+
+    //Run fn on the pool. Never waits; from an outside thread the task goes to a
+    //shared list the workers check.
+    TaskHandle spawn(std::function<void()> fn){
+        return spawnAfter({}, std::move(fn));
+    }
+    //Run fn once every task in deps has finished
+    TaskHandle spawnAfter(std::initializer_list<TaskHandle> deps, std::function<void()> fn){
+        auto node = std::make_shared<TaskHandle::Node>();
+        node->owner = this;
+        node->fn = std::move(fn);
+        node->self = node;
+        for(const TaskHandle& d : deps){
+            if(!d.node) continue;
+            std::lock_guard<std::mutex> lock(d.node->mtx);
+            if(d.node->finished.load(std::memory_order_relaxed)) continue;
+            node->waitingFor.fetch_add(1, std::memory_order_relaxed);
+            d.node->next.push_back(node);
+        }
+        TaskHandle handle(node);
+        if(node->waitingFor.fetch_sub(1, std::memory_order_acq_rel) == 1) schedule(node.get());
+        return handle;
+    }
+    //Continuation: fn runs after before
+    TaskHandle then(const TaskHandle& before, std::function<void()> fn){
+        return spawnAfter({before}, std::move(fn));
+    }
+    //Run other work until task has finished
+    void wait(const TaskHandle& task){
+        if(task.done()) return;
+        CallerSlot caller(*this);
+        helpUntil(caller.slot(), [&]{ return task.done(); });
+    }
+
+    SchedulerStats stats() const {
+        SchedulerStats s;
+        for(const auto& slot : slots){
+            s.executed += slot->executed.load(std::memory_order_relaxed);
+            s.stolen += slot->stolen.load(std::memory_order_relaxed);
+            s.sleeps += slot->sleeps.load(std::memory_order_relaxed);
+        }
+        return s;
+    }
+};
+
+inline void TaskHandle::Node::execute(unsigned){
+    std::shared_ptr<Node> keep = std::move(self);
+    fn();
+    fn = nullptr; //drop captured state now, the handle may live on
+    std::vector<std::shared_ptr<Node>> ready;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        finished.store(true, std::memory_order_release);
+        ready.swap(next);
+    }
+    for(auto& n : ready){
+        if(n->waitingFor.fetch_sub(1, std::memory_order_acq_rel) == 1) owner->schedule(n.get());
+    }
+}
+
+#endif
@@ -0,0 +1,174 @@
+//timed_stream.h
+//Timestamped samples and a fusion stage that lines many of them up in time.
+//
+//TimedStream: one channel (one sensor of one robot), samples in time order.
+//             Times are microseconds on timedNowUs()'s clock (steady_clock),
+//             so streams from different projects on the same machine compare.
+//StreamFusion: turns many streams with their own irregular sample times into
+//             frames on one common clock (start + k * period). Each stream is
+//             walked with its own cursor alongside the clock (a merge-join of
+//             two sorted sequences), so lining up S streams costs
+//             O(samples + frames * S) with no lookups by time or by name.
+//             Values between samples are either held (zero-order hold) or
+//             linearly interpolated.
+//Frames come out in batches (FusedBatch, one row per clock tick, one column per
+//stream). Samples a fusion no longer needs are dropped from its streams.
+//Include from a project as "../Common/timed_stream.h".
+#ifndef TIMED_STREAM_H
+#define TIMED_STREAM_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+//Microseconds on the steady clock, the time base of every stream
+inline std::int64_t timedNowUs(){
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+class TimedStream{
+    private:
+        std::string name;
+        std::vector<std::int64_t> times; //column of timestamps
+        std::vector<double> values;      //column of values
+        std::size_t head = 0;            //samples before head were consumed
+    public:
+        explicit TimedStream(std::string n = "") : name(std::move(n)){}
+
+    //Append a sample; false (and nothing stored) if it is older than the last one
+    bool push(std::int64_t timeUs, double value){
+        if(!times.empty() && timeUs < times.back()) return false;
+        times.push_back(timeUs);
+        values.push_back(value);
+        return true;
+    }
+    //Samples not consumed yet; index 0 is the oldest of them
+    std::size_t size() const {return times.size() - head;}
+    bool empty() const {return size() == 0;}
+    std::int64_t timeAt(std::size_t i) const {return times[head + i];}
+    double valueAt(std::size_t i) const {return values[head + i];}
+    std::int64_t lastTime() const {return times.back();}
+    const std::string& getName() const {return name;}
+    //Forget the oldest `count` samples. The storage is compacted once the
+    //consumed part is the bigger half, so memory stays bounded without a
+    //shift on every call.
+    void consume(std::size_t count){
+        head += count < size() ? count : size();
+        if(head >= 1024 && head * 2 >= times.size()){
+            times.erase(times.begin(), times.begin() + static_cast<std::ptrdiff_t>(head));
+            values.erase(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(head));
+            head = 0;
+        }
+    }
+};
+
+enum class Resample {Hold, Linear};
+
+//Aligned frames: frame i is at times[i] and has one value per stream.
+//NaN = that stream had no usable sample for this tick.
+struct FusedBatch{
+    std::size_t streams = 0;
+    std::vector<std::int64_t> times;
+    std::vector<double> values; //row-major, frames x streams
+
+    std::size_t frames() const {return times.size();}
+    const double* frame(std::size_t i) const {return values.data() + i * streams;}
+    void clear(){
+        times.clear();
+        values.clear();
+    }
+};
+
+class StreamFusion{
+    private:
+        std::vector<TimedStream*> inputs;
+        std::int64_t next;      //time of the next frame to emit
+        std::int64_t period;
+        Resample mode;
+        std::int64_t maxGap;    //a sample older than this is not used (0 = no limit)
+
+        //Fill column `col` of the `count` frames that start at frame `first`
+        void fillColumn(std::size_t col, std::size_t first, std::size_t count, FusedBatch& out){
+            TimedStream& s = *inputs[col];
+            const std::size_t n = s.size();
+            const double NaN = std::numeric_limits<double>::quiet_NaN();
+            std::size_t c = 0; //last sample at or before the current tick
+            for(std::size_t f = 0; f < count; ++f){
+                const std::int64_t t = out.times[first + f];
+                while(c + 1 < n && s.timeAt(c + 1) <= t) ++c;
+                double v = NaN;
+                if(n > 0 && s.timeAt(c) <= t && (maxGap == 0 || t - s.timeAt(c) <= maxGap)){
+                    v = s.valueAt(c);
+                    if(mode == Resample::Linear && c + 1 < n){
+                        std::int64_t t0 = s.timeAt(c);
+                        std::int64_t t1 = s.timeAt(c + 1);
+                        if(t1 > t0) v += (s.valueAt(c + 1) - v) * static_cast<double>(t - t0) / static_cast<double>(t1 - t0);
+                    }
+                }
+                out.values[(first + f) * out.streams + col] = v;
+            }
+            //samples before c can't matter for later ticks any more
+            s.consume(c);
+        }
+    public:
+        //Frames at startUs, startUs + periodUs, ...
+        StreamFusion(std::int64_t startUs, std::int64_t periodUs, Resample m = Resample::Linear, std::int64_t maxGapUs = 0)
+            : next(startUs), period(periodUs > 0 ? periodUs : 1), mode(m), maxGap(maxGapUs){}
+
+    //Add a stream, returns its column in the frames. The fusion consumes the
+    //stream's old samples, so a stream should feed only one fusion.
+    std::size_t addStream(TimedStream& stream){
+        inputs.push_back(&stream);
+        return inputs.size() - 1;
+    }
+    std::size_t streamCount() const {return inputs.size();}
+    std::int64_t nextFrameTime() const {return next;}
+    //Latest time every stream has reached. Frames up to here get the same values
+    //no matter what arrives later (for Linear, a frame past a stream's last sample
+    //is held and would change once the next sample arrives).
+    //With a maxGap, a stream that has gone quiet doesn't hold the others back:
+    //the watermark reaches at least (newest sample seen) - maxGap, and the quiet
+    //stream's column is NaN from there on.
+    std::int64_t watermark() const {
+        std::int64_t w = std::numeric_limits<std::int64_t>::max();
+        std::int64_t newest = std::numeric_limits<std::int64_t>::min();
+        bool anyEmpty = false;
+        for(const TimedStream* s : inputs){
+            if(s->empty()){
+                anyEmpty = true;
+                continue;
+            }
+            if(s->lastTime() < w) w = s->lastTime();
+            if(s->lastTime() > newest) newest = s->lastTime();
+        }
+        if(anyEmpty) w = next - 1;
+        if(maxGap > 0 && newest != std::numeric_limits<std::int64_t>::min() && newest - maxGap > w){
+            w = newest - maxGap;
+        }
+        return w;
+    }
+    //Append the frames for every clock tick up to and including untilUs (at most
+    //maxFrames of them) to out. Returns how many frames were added.
+    std::size_t emitUntil(std::int64_t untilUs, FusedBatch& out,
+                          std::size_t maxFrames = std::numeric_limits<std::size_t>::max()){
+        if(untilUs < next || inputs.empty()) return 0;
+        std::size_t count = static_cast<std::size_t>((untilUs - next) / period) + 1;
+        if(count > maxFrames) count = maxFrames;
+        out.streams = inputs.size();
+        const std::size_t first = out.times.size();
+        out.times.resize(first + count);
+        out.values.resize((first + count) * out.streams);
+        for(std::size_t f = 0; f < count; ++f) out.times[first + f] = next + static_cast<std::int64_t>(f) * period;
+        //stream by stream: each walk reads one stream front to back
+        for(std::size_t col = 0; col < inputs.size(); ++col) fillColumn(col, first, count, out);
+        next += static_cast<std::int64_t>(count) * period;
+        return count;
+    }
+};
+
+#endif
@@ -1,4 +1,5 @@
 #include <iostream> //input/output stream
+#include "../Common/async_logger.h" //LOG_INFO: printing happens on a background thread
 //using namespace std; // for beginners, ok here
 
 //display robot status
@@ -11,17 +12,17 @@ void displayStatus(const int& positionX, const int& positionY, const int& batter
 //robot move 
 void moveRobot(int& positionX, int& positionY, int dx, int dy, int& battery){
     if(battery<10){
-        std::cout << "Low battery! remaining : " << battery << "%" << std::endl;
-        std::cout << "Please recharge Robot..." << std::endl;
+        LOG_WARN("Low battery! remaining : ", battery, "%");
+        LOG_WARN("Please recharge Robot...");
         return;
     }
     positionX += dx;
     positionY += dy;
     battery -= 8;
     
-    std::cout << "new position : X -> " << positionX << " Y - > " << positionY << std::endl;
-    std::cout << "Battery used 8%" << std::endl;
-    std::cout << "Battery remaining: " << battery << std::endl;
+    LOG_INFO("new position : X -> ", positionX, " Y - > ", positionY);
+    LOG_INFO("Battery used 8%");
+    LOG_INFO("Battery remaining: ", battery);
 }
 
 //robot reset position and battery
@@ -30,18 +31,18 @@ void reset(int& positionX, int& positionY, int& battery){
     positionY = 0;
     positionX = 0;
     battery = 100;
-    std::cout << "Robot reseted." << std::endl;
-    std::cout << "new position : X -> " << positionX << " Y - > " << positionY << std::endl;
-    std::cout << "Battery : " << battery << std::endl;
+    LOG_INFO("Robot reseted.");
+    LOG_INFO("new position : X -> ", positionX, " Y - > ", positionY);
+    LOG_INFO("Battery : ", battery);
 }
 void chargeRobot(int& battery){
     battery += 20;
     if(battery >= 100){
         battery = 100;
-        std::cout << "Battery is 100%!" ;
+        LOG_INFO("Battery is 100%!");
         return;
     }
-    std::cout << "Battery : " << battery << std::endl;
+    LOG_INFO("Battery : ", battery);
 }
 int main() {
     int positionX = 0;
@@ -55,6 +56,7 @@ int main() {
     std::cout << "initial position X : " << positionX << "\ninitial position Y : " << positionY << std::endl;
     std::cout << "initial battery : " << battery << "%" << std::endl;
     do {
+        logFlush(); //let queued log lines out before the menu
         std::cout << "=== Main Menu ===\n";
         std::cout << "1. Move forward\n";
         std::cout << "2. Move Backward\n";
@@ -75,19 +77,19 @@ int main() {
         switch(choice){
             case '1' :
                 moveRobot(positionX,positionY,0,1,battery);
-                std::cout << "Robot move forward!";
+                LOG_INFO("Robot move forward!");
                 break;
             case '2' :
                 moveRobot(positionX,positionY,0,-1,battery);
-                std::cout << "Robot move backward!";
+                LOG_INFO("Robot move backward!");
                 break;
             case '3' :
                 moveRobot(positionX,positionY,-1,0,battery);
-                std::cout << "Robot move left!";
+                LOG_INFO("Robot move left!");
                 break;
             case '4' :
                 moveRobot(positionX,positionY,1,0,battery);
-                std::cout << "Robot move right!";
+                LOG_INFO("Robot move right!");
                 break;
             case '5' :
                 reset(positionX,positionY,battery);
@@ -105,7 +107,7 @@ int main() {
                 std::cout << "Invalid choice! Please enter 1 - 8." << std::endl;
         }
         if(battery < 10 && choice != '8'){
-            std::cout << "\n === CRITICAL !!!===\nBattery is " << battery << "%!" << " Recharge immediately!" << std::endl; 
+            LOG_WARN("\n === CRITICAL !!!===\nBattery is ", battery, "%!", " Recharge immediately!");
         }
 
     }
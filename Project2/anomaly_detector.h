@@ -0,0 +1,347 @@
+//anomaly_detector.h
+//Pluggable anomaly detectors for sensor streams.
+//Every detector works two ways:
+//  update(x)     streaming: feed one new reading, returns true if it is anomalous
+//  scan(data,n)  batch: screen a whole history buffer, returns every anomalous index
+//Both apply the same rule to the same data.
+//
+//Batch kernels use AVX2 (4 doubles per instruction) when the CPU has it,
+//chosen at runtime, with a plain scalar loop as fallback.
+#ifndef ANOMALY_DETECTOR_H
+#define ANOMALY_DETECTOR_H
+
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+#include "ring_buffer.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ANOMALY_HAVE_AVX2 1
+#include <immintrin.h>
+#endif
+
+//=== batch kernels ===
+namespace anomaly_kernels{
+
+//Scalar reference: flag i when |x[i] - center[i]| > k * scale[i]
+inline void flagOutsideScalar(const double* x, const double* center, const double* scale, double k,
+                              std::size_t begin, std::size_t end, std::vector<std::size_t>& out){
+    for(std::size_t i = begin; i < end; ++i){
+        if(std::fabs(x[i] - center[i]) > k * scale[i]) out.push_back(i);
+    }
+}
+//Scalar reference for the rolling z-score. prefix/prefixSq hold running sums
+//(prefix[i] = x[0] + ... + x[i-1]) so each window mean/variance is O(1).
+inline void zscoreScalar(const double* x, const double* prefix, const double* prefixSq, std::size_t window,
+                         double k, std::size_t begin, std::size_t end, std::vector<std::size_t>& out){
+    for(std::size_t i = begin; i < end; ++i){
+        double mean = (prefix[i] - prefix[i - window]) / window;
+        //E[x^2] - mean^2 can round to slightly below 0 for a flat window
+        double var = std::max(0.0, (prefixSq[i] - prefixSq[i - window]) / window - mean * mean);
+        double d = x[i] - mean;
+        if(d * d > k * k * var) out.push_back(i); //compare squares, no sqrt needed
+    }
+}
+
+#ifdef ANOMALY_HAVE_AVX2
+__attribute__((target("avx2")))
+inline void flagOutsideAvx2(const double* x, const double* center, const double* scale, double k,
+                            std::size_t begin, std::size_t end, std::vector<std::size_t>& out){
+    const __m256d vk = _mm256_set1_pd(k);
+    const __m256d signMask = _mm256_set1_pd(-0.0);
+    std::size_t i = begin;
+    for(; i + 4 <= end; i += 4){
+        __m256d d = _mm256_sub_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(center + i));
+        d = _mm256_andnot_pd(signMask, d); //absolute value
+        __m256d limit = _mm256_mul_pd(vk, _mm256_loadu_pd(scale + i));
+        int mask = _mm256_movemask_pd(_mm256_cmp_pd(d, limit, _CMP_GT_OQ));
+        while(mask){ //usually 0, anomalies are rare
+            int lane = __builtin_ctz(mask);
+            out.push_back(i + lane);
+            mask &= mask - 1;
+        }
+    }
+    flagOutsideScalar(x, center, scale, k, i, end, out);
+}
+__attribute__((target("avx2")))
+inline void zscoreAvx2(const double* x, const double* prefix, const double* prefixSq, std::size_t window,
+                       double k, std::size_t begin, std::size_t end, std::vector<std::size_t>& out){
+    const __m256d invW = _mm256_set1_pd(1.0 / window);
+    const __m256d k2 = _mm256_set1_pd(k * k);
+    std::size_t i = begin;
+    for(; i + 4 <= end; i += 4){
+        __m256d sum = _mm256_sub_pd(_mm256_loadu_pd(prefix + i), _mm256_loadu_pd(prefix + i - window));
+        __m256d sq = _mm256_sub_pd(_mm256_loadu_pd(prefixSq + i), _mm256_loadu_pd(prefixSq + i - window));
+        __m256d mean = _mm256_mul_pd(sum, invW);
+        __m256d var = _mm256_sub_pd(_mm256_mul_pd(sq, invW), _mm256_mul_pd(mean, mean));
+        var = _mm256_max_pd(var, _mm256_setzero_pd()); //same clamp as the scalar loop
+        __m256d d = _mm256_sub_pd(_mm256_loadu_pd(x + i), mean);
+        __m256d lhs = _mm256_mul_pd(d, d);
+        __m256d rhs = _mm256_mul_pd(k2, var);
+        int mask = _mm256_movemask_pd(_mm256_cmp_pd(lhs, rhs, _CMP_GT_OQ));
+        while(mask){
+            int lane = __builtin_ctz(mask);
+            out.push_back(i + lane);
+            mask &= mask - 1;
+        }
+    }
+    zscoreScalar(x, prefix, prefixSq, window, k, i, end, out);
+}
+inline bool cpuHasAvx2(){
+    static const bool has = __builtin_cpu_supports("avx2");
+    return has;
+}
+#endif
+
+inline void flagOutside(const double* x, const double* center, const double* scale, double k,
+                        std::size_t begin, std::size_t end, std::vector<std::size_t>& out){
+#ifdef ANOMALY_HAVE_AVX2
+    if(cpuHasAvx2()){
+        flagOutsideAvx2(x, center, scale, k, begin, end, out);
+        return;
+    }
+#endif
+    flagOutsideScalar(x, center, scale, k, begin, end, out);
+}
+inline void zscore(const double* x, const double* prefix, const double* prefixSq, std::size_t window,
+                   double k, std::size_t begin, std::size_t end, std::vector<std::size_t>& out){
+#ifdef ANOMALY_HAVE_AVX2
+    if(cpuHasAvx2()){
+        zscoreAvx2(x, prefix, prefixSq, window, k, begin, end, out);
+        return;
+    }
+#endif
+    zscoreScalar(x, prefix, prefixSq, window, k, begin, end, out);
+}
+
+} // namespace anomaly_kernels
+
+//=== detector interface ===
+class AnomalyDetector{
+    public:
+    virtual ~AnomalyDetector() = default;
+    virtual std::string name() const = 0;
+    //streaming: feed the next reading, true if it is an anomaly
+    virtual bool update(double value) = 0;
+    //batch: every anomalous index in data[0..n)
+    virtual std::vector<std::size_t> scan(const double* data, std::size_t n) const = 0;
+    //forget all streaming state
+    virtual void reset() = 0;
+};
+
+//Rolling z-score: x[i] is anomalous if it is more than "threshold" standard
+//deviations away from the mean of the previous "window" readings.
+class RollingZScoreDetector : public AnomalyDetector{
+    private:
+        std::size_t window;
+        double threshold;
+        RingBuffer<double> recent;
+        double sum = 0.0;   //sums of (x - reference), same trick as scan()
+        double sumSq = 0.0;
+        std::size_t pushesSinceResum = 0;
+        bool haveReference = false;
+        double reference = 0.0;
+    public:
+        RollingZScoreDetector(std::size_t w = 32, double k = 3.0)
+            : window(w > 1 ? w : 2), threshold(k), recent(window){}
+
+    std::string name() const override {return "rolling z-score";}
+    bool update(double value) override {
+        if(!haveReference){
+            reference = value;
+            haveReference = true;
+        }
+        value -= reference;
+        bool anomaly = false;
+        if(recent.full()){
+            double mean = sum / window;
+            double var = std::max(0.0, sumSq / window - mean * mean);
+            double d = value - mean;
+            anomaly = d * d > threshold * threshold * var;
+        }
+        double old = 0.0;
+        if(recent.push(value, &old)){
+            sum -= old;
+            sumSq -= old * old;
+        }
+        sum += value;
+        sumSq += value * value;
+        //re-add the window once per lap so rounding errors can't build up
+        if(++pushesSinceResum == window){
+            sum = sumSq = 0.0;
+            for(std::size_t i = 0; i < recent.size(); ++i){
+                sum += recent[i];
+                sumSq += recent[i] * recent[i];
+            }
+            pushesSinceResum = 0;
+        }
+        return anomaly;
+    }
+    std::vector<std::size_t> scan(const double* data, std::size_t n) const override {
+        std::vector<std::size_t> out;
+        if(n <= window) return out;
+        //running sums of (x - reference) keep the variance accurate for large
+        //offsets such as the weight channel (30000-80000 g)
+        double ref = data[0];
+        std::vector<double> shifted(n), prefix(n + 1), prefixSq(n + 1);
+        prefix[0] = prefixSq[0] = 0.0;
+        for(std::size_t i = 0; i < n; ++i){
+            shifted[i] = data[i] - ref;
+            prefix[i + 1] = prefix[i] + shifted[i];
+            prefixSq[i + 1] = prefixSq[i] + shifted[i] * shifted[i];
+        }
+        anomaly_kernels::zscore(shifted.data(), prefix.data(), prefixSq.data(), window, threshold, window, n, out);
+        return out;
+    }
+    void reset() override {
+        recent.clear();
+        sum = sumSq = 0.0;
+        pushesSinceResum = 0;
+        haveReference = false;
+    }
+};
+
+//Median absolute deviation over a sliding window. Robust: a few spikes in the
+//window do not hide the next one the way they inflate a standard deviation.
+//x[i] is anomalous if |x[i] - median| > threshold * 1.4826 * MAD of the previous "window" readings.
+class MadDetector : public AnomalyDetector{
+    private:
+        std::size_t window;
+        double threshold;
+        RingBuffer<double> recent;
+        std::vector<double> sorted; //same values as recent, kept in order
+        mutable std::vector<double> deviations; //scratch for the MAD
+
+        //1.4826 * MAD estimates the standard deviation for normal data
+        static constexpr double MAD_SCALE = 1.4826;
+
+        static double medianOfSorted(const std::vector<double>& v){
+            std::size_t m = v.size() / 2;
+            return v.size() % 2 ? v[m] : 0.5 * (v[m - 1] + v[m]);
+        }
+        //median and scaled MAD of a sorted window
+        void centerAndScale(const std::vector<double>& window, double& median, double& scale) const {
+            median = medianOfSorted(window);
+            deviations.resize(window.size());
+            for(std::size_t i = 0; i < window.size(); ++i) deviations[i] = std::fabs(window[i] - median);
+            std::size_t m = deviations.size() / 2;
+            std::nth_element(deviations.begin(), deviations.begin() + m, deviations.end());
+            double mad = deviations[m];
+            if(deviations.size() % 2 == 0){
+                mad = 0.5 * (mad + *std::max_element(deviations.begin(), deviations.begin() + m));
+            }
+            scale = MAD_SCALE * mad;
+        }
+        static void insertSorted(std::vector<double>& v, double value){
+            v.insert(std::upper_bound(v.begin(), v.end(), value), value);
+        }
+        static void eraseSorted(std::vector<double>& v, double value){
+            v.erase(std::lower_bound(v.begin(), v.end(), value));
+        }
+    public:
+        MadDetector(std::size_t w = 31, double k = 3.5)
+            : window(w > 0 ? w : 1), threshold(k), recent(window){
+            sorted.reserve(window + 1);
+        }
+
+    std::string name() const override {return "median absolute deviation";}
+    bool update(double value) override {
+        bool anomaly = false;
+        if(recent.full()){
+            double median, scale;
+            centerAndScale(sorted, median, scale);
+            anomaly = std::fabs(value - median) > threshold * scale;
+        }
+        double old = 0.0;
+        if(recent.push(value, &old)){
+            eraseSorted(sorted, old);
+        }
+        insertSorted(sorted, value);
+        return anomaly;
+    }
+    std::vector<std::size_t> scan(const double* data, std::size_t n) const override {
+        std::vector<std::size_t> out;
+        if(n <= window) return out;
+        //first pass: rolling median / MAD per index (sorted window slides by one)
+        std::vector<double> center(n, 0.0), scale(n, 0.0);
+        std::vector<double> win(data, data + window);
+        std::sort(win.begin(), win.end());
+        for(std::size_t i = window; i < n; ++i){
+            centerAndScale(win, center[i], scale[i]);
+            eraseSorted(win, data[i - window]);
+            insertSorted(win, data[i]);
+        }
+        //second pass: vectorized threshold test
+        anomaly_kernels::flagOutside(data, center.data(), scale.data(), threshold, window, n, out);
+        return out;
+    }
+    void reset() override {
+        recent.clear();
+        sorted.clear();
+    }
+};
+
+//EWMA control chart for slow drift. The first "warmup" readings set the baseline
+//mean and standard deviation; after that z = alpha*x + (1-alpha)*z is tracked and
+//x[i] is flagged when z leaves baseline +- threshold * sigma * sqrt(alpha / (2 - alpha)).
+class EwmaDriftDetector : public AnomalyDetector{
+    private:
+        double alpha;
+        double threshold;
+        std::size_t warmup;
+        //streaming state
+        std::size_t seen = 0;
+        double baseMean = 0.0;
+        double baseM2 = 0.0;
+        double ewma = 0.0;
+
+        double bandWidth(double m2) const {
+            double sigma = warmup > 1 ? std::sqrt(m2 / (warmup - 1)) : 0.0;
+            return threshold * sigma * std::sqrt(alpha / (2.0 - alpha));
+        }
+    public:
+        EwmaDriftDetector(double a = 0.2, double k = 3.0, std::size_t warm = 30)
+            : alpha(a), threshold(k), warmup(warm > 1 ? warm : 2){}
+
+    std::string name() const override {return "EWMA drift";}
+    bool update(double value) override {
+        if(seen < warmup){
+            ++seen;
+            double delta = value - baseMean;
+            baseMean += delta / seen;
+            baseM2 += delta * (value - baseMean);
+            ewma = baseMean;
+            return false;
+        }
+        ++seen;
+        ewma = alpha * value + (1.0 - alpha) * ewma;
+        return std::fabs(ewma - baseMean) > bandWidth(baseM2);
+    }
+    std::vector<std::size_t> scan(const double* data, std::size_t n) const override {
+        std::vector<std::size_t> out;
+        if(n <= warmup) return out;
+        double mean = 0.0, m2 = 0.0;
+        for(std::size_t i = 0; i < warmup; ++i){
+            double delta = data[i] - mean;
+            mean += delta / (i + 1);
+            m2 += delta * (data[i] - mean);
+        }
+        //the recurrence itself is sequential; the band test is vectorized
+        std::vector<double> z(n), center(n, mean), scale(n, bandWidth(m2));
+        double e = mean;
+        for(std::size_t i = warmup; i < n; ++i){
+            e = alpha * data[i] + (1.0 - alpha) * e;
+            z[i] = e;
+        }
+        anomaly_kernels::flagOutside(z.data(), center.data(), scale.data(), 1.0, warmup, n, out);
+        return out;
+    }
+    void reset() override {
+        seen = 0;
+        baseMean = baseM2 = ewma = 0.0;
+    }
+};
+
+#endif
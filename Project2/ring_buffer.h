@@ -0,0 +1,53 @@
+//ring_buffer.h
+//Fixed-capacity circular buffer. All memory is allocated once in the
+//constructor, push() never allocates: when full, the oldest value is overwritten.
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <vector>
+#include <cstddef> // for std::size_t
+
+template <typename T>
+class RingBuffer{
+    private:
+        std::vector<T> data; //preallocated storage, size() == capacity
+        std::size_t head = 0;  //index of the oldest element
+        std::size_t count = 0; //how many slots are in use
+    public:
+        explicit RingBuffer(std::size_t capacity = 0) : data(capacity){}
+
+    //Add value at the back. Returns true if an old value was pushed out,
+    //and copies it into "evicted" so the caller can archive it.
+    bool push(const T& value, T* evicted = nullptr){
+        if(data.empty()){
+            return false;
+        }
+        if(count < data.size()){
+            data[(head + count) % data.size()] = value;
+            ++count;
+            return false;
+        }
+        if(evicted){
+            *evicted = data[head];
+        }
+        data[head] = value; //overwrite the oldest slot
+        head = (head + 1) % data.size();
+        return true;
+    }
+    //i = 0 is the oldest retained value, i = size()-1 the newest
+    const T& operator[](std::size_t i) const {
+        return data[(head + i) % data.size()];
+    }
+    const T& front() const {return data[head];}
+    const T& back() const {return (*this)[count - 1];}
+    std::size_t size() const {return count;}
+    std::size_t capacity() const {return data.size();}
+    bool empty() const {return count == 0;}
+    bool full() const {return count == data.size();}
+    void clear(){
+        head = 0;
+        count = 0;
+    }
+};
+
+#endif
@@ -0,0 +1,134 @@
+//sample_engine.h
+//Batch sampling for synthetic sensor data.
+//Fills N frames for every channel at once into structure-of-arrays buffers
+//(one contiguous column per channel) instead of drawing one value per call.
+//
+//Random numbers come from xoshiro256+ (https://prng.di.unimi.it/), run as 4
+//independent lanes side by side so the compiler can vectorize the loop.
+//Seeding is reproducible: the same (seed, stream) always gives the same data,
+//and every stream id is a separate, non-overlapping sequence (2^192 values apart),
+//so each thread can own its own engine.
+#ifndef SAMPLE_ENGINE_H
+#define SAMPLE_ENGINE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <string>
+
+//SplitMix64, only used to turn one 64-bit seed into a full xoshiro state
+inline std::uint64_t splitMix64(std::uint64_t& x){
+    std::uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+//Min/max of one synthetic channel
+struct ChannelRange{
+    std::string name;
+    double low;
+    double high;
+};
+
+//Preallocated frames, one column per channel
+struct SampleBatch{
+    std::vector<std::vector<double>> columns;
+    std::size_t frames = 0; //frames filled by the last SampleEngine::fill()
+
+    SampleBatch(std::size_t channels, std::size_t capacity)
+        : columns(channels, std::vector<double>(capacity)){}
+    std::size_t capacity() const {return columns.empty() ? 0 : columns[0].size();}
+};
+
+class SampleEngine{
+    private:
+        static const int LANES = 4;
+        //state word k of lane l is s[k][l], so one operation updates all lanes
+        std::uint64_t s[4][LANES];
+        std::vector<ChannelRange> channels;
+
+        static std::uint64_t rotl(std::uint64_t x, int k){
+            return (x << k) | (x >> (64 - k));
+        }
+        //One xoshiro256+ step of a single lane
+        void step(int lane){
+            std::uint64_t t = s[1][lane] << 17;
+            s[2][lane] ^= s[0][lane];
+            s[3][lane] ^= s[1][lane];
+            s[1][lane] ^= s[2][lane];
+            s[0][lane] ^= s[3][lane];
+            s[2][lane] ^= t;
+            s[3][lane] = rotl(s[3][lane], 45);
+        }
+        //Advance every lane once; out[l] gets lane l's next value
+        void next(std::uint64_t out[LANES]){
+            for(int l = 0; l < LANES; ++l){
+                out[l] = s[0][l] + s[3][l];
+                step(l);
+            }
+        }
+        //Top 53 bits as a double in [0, 1)
+        static double toUnit(std::uint64_t x){
+            return (x >> 11) * 0x1.0p-53;
+        }
+        //Jump one lane ahead by 2^128 steps (official xoshiro256 jump polynomial)
+        void jump(int lane, const std::uint64_t (&poly)[4]){
+            std::uint64_t t[4] = {0, 0, 0, 0};
+            for(std::uint64_t word : poly){
+                for(int b = 0; b < 64; ++b){
+                    if(word & (1ull << b)){
+                        for(int k = 0; k < 4; ++k) t[k] ^= s[k][lane];
+                    }
+                    step(lane);
+                }
+            }
+            for(int k = 0; k < 4; ++k) s[k][lane] = t[k];
+        }
+    public:
+        //stream: which independent sequence to use (e.g. the thread index)
+        SampleEngine(std::vector<ChannelRange> ranges, std::uint64_t seed, std::uint32_t stream = 0)
+            : channels(std::move(ranges)){
+            static const std::uint64_t JUMP[4] = {0x180EC6D33CFD0ABAull, 0xD5A61266F0C9392Cull,
+                                                  0xA9582618E03FC9AAull, 0x39ABDC4529B1661Cull};
+            static const std::uint64_t LONG_JUMP[4] = {0x76E15D3EFEFDCBBFull, 0xC5004E441C522FB3ull,
+                                                       0x77710069854EE241ull, 0x39109BB02ACBE635ull};
+            std::uint64_t sm = seed;
+            for(int k = 0; k < 4; ++k) s[k][0] = splitMix64(sm);
+            //stream n starts n long-jumps (2^192) in, lane l a further l jumps (2^128)
+            for(std::uint32_t i = 0; i < stream; ++i) jump(0, LONG_JUMP);
+            for(int l = 1; l < LANES; ++l){
+                for(int k = 0; k < 4; ++k) s[k][l] = s[k][l - 1];
+                jump(l, JUMP);
+            }
+        }
+
+    std::size_t channelCount() const {return channels.size();}
+    const ChannelRange& channel(std::size_t c) const {return channels[c];}
+
+    //Fill the first "frames" frames of every column (clamped to the batch capacity)
+    void fill(SampleBatch& batch, std::size_t frames){
+        if(frames > batch.capacity()) frames = batch.capacity();
+        std::size_t count = channels.size() < batch.columns.size() ? channels.size() : batch.columns.size();
+        for(std::size_t c = 0; c < count; ++c){
+            fillColumn(batch.columns[c].data(), frames, channels[c].low, channels[c].high);
+        }
+        batch.frames = frames;
+    }
+    //Fill one column with uniform values in [low, high)
+    void fillColumn(double* out, std::size_t n, double low, double high){
+        const double span = high - low;
+        std::uint64_t r[LANES];
+        std::size_t i = 0;
+        for(; i + LANES <= n; i += LANES){
+            next(r);
+            for(int l = 0; l < LANES; ++l) out[i + l] = low + span * toUnit(r[l]);
+        }
+        if(i < n){ //tail: the unused lanes' values are simply dropped
+            next(r);
+            for(int l = 0; i < n; ++l, ++i) out[i] = low + span * toUnit(r[l]);
+        }
+    }
+};
+
+#endif
@@ -4,7 +4,18 @@
 #include <iomanip> // for formating (setprecision), to fix the dec point
 #include <cstdlib> // for rand()
 #include <random> //modern way to create random number
+#include <memory> // for std::unique_ptr
 #include <ctime> // for time()
+#include <cmath> // for std::sqrt
+#include <chrono> // for log timestamps
+#include "ring_buffer.h" // fixed-capacity history storage
+#include "sensor_log_format.h" // binary column log + mmap reader
+#include "anomaly_detector.h" // z-score / MAD / EWMA detectors
+#include "sample_engine.h" // batch multi-channel sampling
+#include "../Common/async_logger.h" // LOG_INFO: printing happens on a background thread
+#include "../Common/scenario_file.h" // headless batch runs: sensor_data_logger --scenario file
+#include "../Common/timed_stream.h" // timestamped samples + time-aligned fusion
+#include "../Common/metrics.h" // timers/histograms, only with -DMETRICS_ENABLED=1
 void takeReading(std::vector<double>& tempReadings, std::vector<double>& distReadings, std::vector<double>& lightReadings, int& battery){
     //Check battery
     if(battery <= 10){
@@ -76,50 +87,191 @@ void displayStatus(const int& positionX, const int& positionY, const int& batter
     std::cout << "positionY : " << positionY << std::endl;
     std::cout << "Battery : " << battery << std::endl;
 }
+//Running statistics, updated one sample at a time (Welford's method)
+//every query is O(1), no matter how many readings were added
+class RunningStats{
+    private:
+        long long n = 0;
+        double mean = 0.0;
+        double m2 = 0.0; //sum of squared distances from the mean
+        double minValue = 0.0;
+        double maxValue = 0.0;
+    public:
+    void add(double value){
+        ++n;
+        double delta = value - mean;
+        mean += delta / n;
+        m2 += delta * (value - mean); //uses old and new mean, numerically stable
+        if(n == 1 || value < minValue) minValue = value;
+        if(n == 1 || value > maxValue) maxValue = value;
+    }
+    void reset(){
+        *this = RunningStats();
+    }
+    long long count() const {return n;}
+    double getMean() const {return mean;}
+    //sample variance (n-1), 0 until we have two readings
+    double variance() const {return n > 1 ? m2 / (n - 1) : 0.0;}
+    double stddev() const {return std::sqrt(variance());}
+    double getMin() const {return minValue;}
+    double getMax() const {return maxValue;}
+};
 class Sensor{
     private:
         std::string name;
         std::string unit;
-        std::vector<double> readings;
+        std::vector<double> readings; //unbounded mode (capacity == 0)
+        RunningStats stats; //kept in sync by addReading(), covers the whole lifetime
+        //Bounded mode: only the newest "capacity" readings are kept
+        bool bounded = false;
+        RingBuffer<double> window;
+        double windowSum = 0.0; //sum of the values in window, for O(1) average
+        std::size_t pushesSinceResum = 0;
+        //Optional archive tier: every "archiveFactor" readings that fall out of
+        //the window are averaged into one archived value
+        std::size_t archiveFactor = 0;
+        RingBuffer<double> archive;
+        double archiveSum = 0.0;
+        std::size_t archivePending = 0;
+        //Optional pluggable detector, fed by addReading()
+        std::unique_ptr<AnomalyDetector> detector;
+        bool latestFlagged = false;
+        long long anomalyCount = 0; //readings the detector flagged so far
+        //Optional timestamped copy of every reading, to line it up with other data
+        TimedStream* stream = nullptr;
+
+        void archiveValue(double oldValue){
+            if(archiveFactor == 0){
+                return; //no archive, old data is simply dropped
+            }
+            archiveSum += oldValue;
+            if(++archivePending == archiveFactor){
+                archive.push(archiveSum / archiveFactor);
+                archiveSum = 0.0;
+                archivePending = 0;
+            }
+        }
     public:
         Sensor(std::string n,std::string u):name(n),unit(u){
 
+        }
+        //Bounded constructor: keeps the newest "capacity" readings in a ring buffer.
+        //If archiveEvery > 0, older readings are downsampled (mean of archiveEvery
+        //readings) into an archive of up to archiveCapacity values.
+        Sensor(std::string n,std::string u,std::size_t capacity,
+               std::size_t archiveEvery = 0,std::size_t archiveCapacity = 0)
+            :name(n),unit(u),bounded(capacity > 0),window(capacity),
+             archiveFactor(archiveCapacity > 0 ? archiveEvery : 0),archive(archiveCapacity){
+
         }
     //Add new readings
     void addReading(double value){
-        readings.push_back(value);
+        METRICS_SCOPE("sensor_add_reading");
+        stats.add(value);
+        if(detector){
+            latestFlagged = detector->update(value);
+            anomalyCount += latestFlagged;
+            METRICS_COUNT("sensor_anomalies", latestFlagged);
+        }
+        if(!bounded){
+            readings.push_back(value);
+            return;
+        }
+        double oldValue = 0.0;
+        if(window.push(value, &oldValue)){
+            windowSum -= oldValue;
+            archiveValue(oldValue);
+        }
+        windowSum += value;
+        //re-add the window once per lap so rounding errors can't build up
+        if(++pushesSinceResum == window.capacity()){
+            windowSum = 0.0;
+            for(std::size_t i = 0; i < window.size(); ++i) windowSum += window[i];
+            pushesSinceResum = 0;
+        }
+    }
+    //Add a reading taken at timeUs (timedNowUs() clock); also goes to the attached stream
+    void addReading(double value, std::int64_t timeUs){
+        addReading(value);
+        if(stream) stream->push(timeUs, value);
+    }
+    //Keep a timestamped copy of every reading in s (nullptr = stop)
+    void attachStream(TimedStream* s){
+        stream = s;
+    }
+    //Number of readings currently retained
+    std::size_t historySize() const {
+        return bounded ? window.size() : readings.size();
+    }
+    //i = 0 is the oldest retained reading
+    double historyAt(std::size_t i) const {
+        return bounded ? window[i] : readings[i];
     }
     //Show history
     void showHistory()const{
-        std::cout << "\n === " << name << " History (" << readings.size() << " readings) ===\n";
-        if(readings.empty()){
+        std::cout << "\n === " << name << " History (" << historySize() << " readings) ===\n";
+        if(!archive.empty()){
+            std::cout << "Archived (mean of every " << archiveFactor << " readings):\n";
+            for(std::size_t i = 0; i < archive.size(); ++i){
+                std::cout << name << " ~ " << archive[i] << " " << unit << "\n";
+            }
+        }
+        if(historySize() == 0){
             std::cout << "No data yet.\n";
             return;
         }
-        //Method 1: range base for loop
-        for (double value : readings){
-            std::cout << name << " : " << value << " " << unit << "\n";
+        //Method 1: index loop over the retained readings
+        for (std::size_t i = 0; i < historySize(); ++i){
+            std::cout << name << " : " << historyAt(i) << " " << unit << "\n";
         }
     }
-    // Calculate average
+    // Calculate average over the retained readings, O(1)
     double getAverage() const {
-        if (readings.empty()) return 0.0;
-        double sum = 0.0;
-        for (double v : readings) sum += v;
-        return sum / readings.size();
+        if(bounded){
+            return window.empty() ? 0.0 : windowSum / window.size();
+        }
+        return stats.getMean();
+    }
+    // Full statistics over every reading ever added (count, mean, variance, min, max)
+    const RunningStats& getStats() const {
+        return stats;
+    }
+    long long getAnomalyCount() const {return anomalyCount;}
+    //Use a detector instead of the simple threshold rule in detcetAnomaly()
+    void setDetector(std::unique_ptr<AnomalyDetector> d){
+        detector = std::move(d);
+        latestFlagged = false;
+    }
+    //Re-screen the whole retained history with the detector, returns every
+    //anomalous index (0 = oldest retained reading)
+    std::vector<std::size_t> screenHistory() const {
+        if(!detector){
+            return {};
+        }
+        std::vector<double> values(historySize());
+        for(std::size_t i = 0; i < values.size(); ++i) values[i] = historyAt(i);
+        return detector->scan(values.data(), values.size());
     }
     // Return true if latest reading is anomaly
     bool detcetAnomaly(double threshold = 2.0)const{
-        if(readings.size() < 2){
+        if(historySize() < 2){
             return false;
         }
         double avg = getAverage();
-        double latest = readings.back();
+        double latest = historyAt(historySize() - 1);
+        if(detector){
+            //the detector already judged the latest reading in addReading()
+            if(latestFlagged){
+                LOG_WARN("ANOMALY DETECTED in ", name, " (", detector->name(), ")",
+                         ": ", latest, " ", unit, " (avg: ", avg, ")");
+            }
+            return latestFlagged;
+        }
         // Simple rule: if latest > threshold * average
         if (latest > threshold * avg || latest < avg / threshold) {
-            std::cout << "ANOMALY DETECTED in " << name 
-                      << ": " << latest << " " << unit 
-                      << " (avg: " << avg << ")\n";
+            LOG_WARN("ANOMALY DETECTED in ", name,
+                     ": ", latest, " ", unit,
+                     " (avg: ", avg, ")");
             return true;
         }
         return false;
@@ -130,43 +282,293 @@ class Sensor{
     }
 
 };
-void ctakeReading(Sensor& temp_readings,Sensor& dist_readings,Sensor& light_readings,Sensor& weight_readings, int& battery){
+//Channel ranges for the synthetic readings
+std::vector<ChannelRange> sensorChannels(){
+    return {{"Temperature", 20.0, 40.0},    //20-40 C
+            {"Distance", 10.0, 200.0},      //10-200 cm
+            {"Light", 100.0, 1000.0},       //100-1000 lux
+            {"Weight", 30000.0, 80000.0}};  //30-80 kg in g
+}
+//Load-test helper: generate "frames" readings per channel in one batch and
+//feed them to the sensors without any printing
+void generateReadings(SampleEngine& engine, SampleBatch& batch, std::size_t frames, Sensor* sensors[4]){
+    while(frames > 0){
+        engine.fill(batch, frames);
+        if(batch.frames == 0) return; //empty batch, nothing can be generated
+        for(int c = 0; c < 4; ++c){
+            const double* column = batch.columns[c].data();
+            for(std::size_t i = 0; i < batch.frames; ++i) sensors[c]->addReading(column[i]);
+        }
+        frames -= batch.frames;
+    }
+}
+void ctakeReading(Sensor& temp_readings,Sensor& dist_readings,Sensor& light_readings,Sensor& weight_readings, int& battery, SensorLogWriter* log = nullptr){
         //Check battery
         if(battery <= 10){
-            std::cout << "Battery too low for sensing!\n";
+            LOG_WARN("Battery too low for sensing!");
             return;
         }
         
+        //Method 1 (old version): one std::mt19937 draw per channel per call
+        //Method 2: batch engine, fills every channel at once (see sample_engine.h)
         static std::random_device random;
-        //create Mersenne Twister engine
-        static std::mt19937 gen(random()); // seed with random device
-        //create distribution
-        static std::uniform_real_distribution<double> ctemp_ran(20.0,40.0);
-        static std::uniform_real_distribution<double> cdist_ran(10.0,200.0);
-        static std::uniform_real_distribution<double> clight_ran(100.0,1000.0);
-        static std::uniform_real_distribution<double> cweight_ran(30000.0,80000.0);
+        static SampleEngine engine(sensorChannels(), random()); // seed with random device
+        static SampleBatch batch(4, 1);
+        engine.fill(batch, 1);
+
+        double ctemp = batch.columns[0][0]; //20-40 C
+        double cdist = batch.columns[1][0]; //10-200 cm
+        double clight = batch.columns[2][0]; //100-1000 lux
+        double cweight = batch.columns[3][0];
 
-        double ctemp = ctemp_ran(gen); //20-40 C
-        double cdist = cdist_ran(gen); //10-200 cm
-        double clight = clight_ran(gen); //100-1000 lux
-        double cweight = cweight_ran(gen);
+        //one timestamp for the whole frame, on the clock every stream shares
+        const std::int64_t takenUs = timedNowUs();
+        temp_readings.addReading(ctemp, takenUs);
+        dist_readings.addReading(cdist, takenUs);
+        light_readings.addReading(clight, takenUs);
+        weight_readings.addReading(cweight, takenUs);
 
-        temp_readings.addReading(ctemp);
-        dist_readings.addReading(cdist);
-        light_readings.addReading(clight);
-        weight_readings.addReading(cweight);
+        //persist the frame, timestamp = microseconds since the first reading
+        if(log){
+            static const auto start = std::chrono::steady_clock::now();
+            std::int64_t us = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count();
+            double frame[4] = {ctemp, cdist, clight, cweight};
+            log->append(us, frame);
+        }
 
         battery -= 5;
 
-        std::cout << "New readings taken!\n";
-        std::cout << "Temp : " << ctemp << " °C\n";
-        std::cout << "Dist : " << cdist << " cm\n";
-        std::cout << "Light : " << clight << " lux\n";
-        std::cout << "Weight : " << cweight << " g\n";
+        LOG_INFO("New readings taken!");
+        LOG_INFO("Temp : ", ctemp, " °C");
+        LOG_INFO("Dist : ", cdist, " cm");
+        LOG_INFO("Light : ", clight, " lux");
+        LOG_INFO("Weight : ", cweight, " g");
 
 
     }
-int main() {
+//Read a log file back through the memory-mapped reader
+void replayLog(const std::string& path){
+    SensorLogReader reader(path);
+    if(!reader.isOpen()){
+        std::cout << "No log file found at " << path << "\n";
+        return;
+    }
+    std::cout << "\n === Log " << path << " ===\n";
+    std::cout << reader.frameCount() << " frames in " << reader.blockCount() << " blocks, "
+              << reader.verify() << " damaged blocks\n";
+    //whole-file min/max straight from the block summaries, no data scanned
+    for(std::uint32_t c = 0; c < reader.channelCount(); ++c){
+        double lo = 0.0;
+        double hi = 0.0;
+        for(std::size_t b = 0; b < reader.blockCount(); ++b){
+            const LogBlockHeader& block = reader.block(b);
+            if(b == 0 || block.minValue[c] < lo) lo = block.minValue[c];
+            if(b == 0 || block.maxValue[c] > hi) hi = block.maxValue[c];
+        }
+        std::cout << reader.channelName(c) << " : min " << lo << ", max " << hi << "\n";
+    }
+    for(const LogSlice& slice : reader.range(INT64_MIN, INT64_MAX)){
+        for(std::size_t i = 0; i < slice.timestamps.size(); ++i){
+            std::cout << "t=" << slice.timestamps[i] / 1000000.0 << "s";
+            for(std::uint32_t c = 0; c < reader.channelCount(); ++c){
+                std::cout << "  " << slice.channels[c][i];
+            }
+            std::cout << "\n";
+        }
+    }
+}
+//Fusion load test (scenario key fusion_robots N > 0): N simulated robots, each
+//with the four sensor channels sampled at their own rates with jitter, are
+//lined up on one common clock by StreamFusion. Time is simulated, so the run is
+//deterministic; the report says how much faster than real time it ran. Keys:
+//  fusion_robots N       robots (4 streams each)
+//  fusion_seconds S      simulated time (default 10)
+//  fusion_hz H           rate of the common clock (default 50)
+//  fusion_mode M         linear or hold (default linear)
+//  fusion_max_gap_ms G   samples older than this give no value (default 0 = no limit)
+//  seed S                random seed (default 1)
+int runFusionScenario(const ScenarioFile& sc){
+    const long long robots = sc.getInt("fusion_robots", 0, 0);
+    const double simSeconds = sc.getDouble("fusion_seconds", 0, 10.0);
+    const double hz = sc.getDouble("fusion_hz", 0, 50.0);
+    const bool linear = sc.getString("fusion_mode", 0, "linear") != "hold";
+    const std::int64_t maxGapUs = static_cast<std::int64_t>(sc.getDouble("fusion_max_gap_ms", 0, 0.0) * 1000.0);
+    std::mt19937_64 rng(static_cast<std::uint64_t>(sc.getInt("seed", 0, 1)));
+    if(robots <= 0 || robots > 1000000 || simSeconds <= 0 || hz <= 0 || maxGapUs < 0){
+        std::cout << sc.path() << ": fusion_robots, fusion_seconds, fusion_hz or fusion_max_gap_ms out of range\n";
+        return 1;
+    }
+    //every channel has its own sample period (us): temperature is slow, distance fast
+    const std::int64_t PERIOD_US[4] = {100000, 10000, 50000, 200000};
+    const std::vector<ChannelRange> ranges = sensorChannels();
+    struct Source{
+        std::int64_t nextUs; //time of its next sample
+        double value;
+    };
+    const std::size_t streamsCount = static_cast<std::size_t>(robots) * 4;
+    std::vector<TimedStream> streams(streamsCount);
+    std::vector<Source> sources(streamsCount);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::normal_distribution<double> walk(0.0, 1.0);
+    for(std::size_t i = 0; i < streamsCount; ++i){
+        const ChannelRange& r = ranges[i % 4];
+        sources[i].nextUs = static_cast<std::int64_t>(unit(rng) * PERIOD_US[i % 4]); //robots are out of phase
+        sources[i].value = r.low + (r.high - r.low) * unit(rng);
+    }
+    const std::int64_t clockUs = static_cast<std::int64_t>(1e6 / hz);
+    StreamFusion fusion(0, clockUs, linear ? Resample::Linear : Resample::Hold, maxGapUs);
+    for(TimedStream& st : streams) fusion.addStream(st);
+
+    //simulate 100 ms at a time: every source produces its samples, then the
+    //fusion emits the frames that no later sample can change any more
+    const std::int64_t endUs = static_cast<std::int64_t>(simSeconds * 1e6);
+    const std::int64_t CHUNK_US = 100000;
+    FusedBatch batch;
+    long long samples = 0;
+    long long frames = 0;
+    long long missing = 0;
+    std::uint64_t hash = fnv1a(nullptr, 0);
+    auto start = std::chrono::steady_clock::now();
+    for(std::int64_t chunkEnd = CHUNK_US; ; chunkEnd += CHUNK_US){
+        const bool last = chunkEnd >= endUs;
+        if(last) chunkEnd = endUs;
+        for(std::size_t i = 0; i < streamsCount; ++i){
+            Source& src = sources[i];
+            const ChannelRange& r = ranges[i % 4];
+            const std::int64_t period = PERIOD_US[i % 4];
+            while(src.nextUs <= chunkEnd){
+                src.value = std::min(r.high, std::max(r.low, src.value + walk(rng) * (r.high - r.low) * 0.01));
+                streams[i].push(src.nextUs, src.value);
+                ++samples;
+                //next sample one period later, +-10% jitter
+                src.nextUs += period + static_cast<std::int64_t>((unit(rng) - 0.5) * 0.2 * period);
+            }
+        }
+        {
+            METRICS_SCOPE("fusion_emit");
+            frames += static_cast<long long>(fusion.emitUntil(last ? endUs : fusion.watermark(), batch));
+        }
+        for(double v : batch.values) missing += std::isnan(v);
+        hash = fnv1a(batch.values.data(), batch.values.size() * sizeof(double), hash);
+        batch.clear();
+        if(last) break;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if(seconds <= 0) seconds = 1e-9;
+
+    std::cout << "=== Fusion scenario " << sc.path() << " ===\n";
+    std::cout << robots << " robots x 4 channels = " << streamsCount << " streams, "
+              << simSeconds << " s simulated, clock " << hz << " Hz, "
+              << (linear ? "linear" : "hold") << " resampling\n";
+    std::cout << "elapsed " << seconds << " s (" << simSeconds / seconds << "x real time)\n";
+    std::cout << "samples in " << samples << " (" << samples / seconds << " /s)\n";
+    std::cout << "frames out " << frames << ", aligned values/s " << frames * static_cast<double>(streamsCount) / seconds
+              << ", missing " << missing << "\n";
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+    std::cout << "final state hash " << hex << "\n";
+    metricsExport("sensor_data_logger");
+    return 0;
+}
+//Headless batch run: sensor_data_logger --scenario file.txt
+//Generates readings in batches with no console output and reports the
+//throughput plus a hash of the final statistics. Keys:
+//  frames N          readings per channel (default 1000000)
+//  batch N           frames generated per engine call (default 4096)
+//  seed S            random seed (default 1)
+//  capacity N        history kept per sensor (default 1000)
+//  archive_every N   archive downsampling factor (default 10, 0 = no archive)
+//  detectors on|off  attach the anomaly detectors (default on)
+//  log PATH          also write every frame to a binary log
+//  fusion_robots N   run the fusion load test instead (see runFusionScenario)
+int runScenario(const std::string& path){
+    ScenarioFile sc;
+    if(!sc.load(path)) return 1;
+    if(sc.getInt("fusion_robots", 0, 0) > 0) return runFusionScenario(sc);
+    const long long frames = sc.getInt("frames", 0, 1000000);
+    const long long batchFrames = sc.getInt("batch", 0, 4096);
+    const std::uint64_t seed = static_cast<std::uint64_t>(sc.getInt("seed", 0, 1));
+    const long long capacity = sc.getInt("capacity", 0, 1000);
+    const long long archiveEvery = sc.getInt("archive_every", 0, 10);
+    const bool detectors = sc.getString("detectors", 0, "on") != "off";
+    const std::string logPath = sc.getString("log", 0, "");
+    if(frames < 0 || batchFrames <= 0 || capacity < 0 || archiveEvery < 0){
+        std::cout << path << ": frames, batch, capacity or archive_every out of range\n";
+        return 1;
+    }
+    std::size_t cap = static_cast<std::size_t>(capacity);
+    std::size_t every = static_cast<std::size_t>(archiveEvery);
+    Sensor temperature("Temperature","°C",cap,every,cap);
+    Sensor distance("Distance","cm",cap,every,cap);
+    Sensor light("Light","lux",cap,every,cap);
+    Sensor weight("Weight","g",cap,every,cap);
+    if(detectors){
+        temperature.setDetector(std::make_unique<EwmaDriftDetector>(0.2, 3.0, 10));
+        distance.setDetector(std::make_unique<MadDetector>(9, 3.5));
+        light.setDetector(std::make_unique<RollingZScoreDetector>(10, 3.0));
+        weight.setDetector(std::make_unique<EwmaDriftDetector>(0.2, 3.0, 10));
+    }
+    Sensor* sensors[4] = {&temperature, &distance, &light, &weight};
+    std::unique_ptr<SensorLogWriter> writer;
+    if(!logPath.empty()){
+        writer = std::make_unique<SensorLogWriter>(logPath,
+            std::vector<std::string>{"Temperature","Distance","Light","Weight"}, 4096);
+    }
+
+    SampleEngine engine(sensorChannels(), seed);
+    SampleBatch batch(4, static_cast<std::size_t>(batchFrames));
+    long long done = 0;
+    auto start = std::chrono::steady_clock::now();
+    while(done < frames){
+        std::size_t n = static_cast<std::size_t>(std::min(batchFrames, frames - done));
+        generateReadings(engine, batch, n, sensors);
+        if(writer){
+            for(std::size_t i = 0; i < batch.frames; ++i){
+                double frame[4] = {batch.columns[0][i], batch.columns[1][i], batch.columns[2][i], batch.columns[3][i]};
+                writer->append(done + static_cast<long long>(i), frame);
+            }
+        }
+        done += static_cast<long long>(n);
+    }
+    if(writer) writer->flush();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if(seconds <= 0) seconds = 1e-9;
+
+    std::cout << "=== Scenario " << path << " ===\n";
+    std::cout << frames << " frames x 4 channels, batch " << batchFrames << ", detectors "
+              << (detectors ? "on" : "off") << (writer ? ", logged to " + logPath : std::string()) << "\n";
+    std::cout << "elapsed " << seconds << " s\n";
+    std::cout << "frames/s " << frames / seconds << "\n";
+    std::cout << "samples/s " << frames * 4 / seconds << "\n";
+    //hash of the final statistics and the retained history of every channel
+    std::uint64_t hash = fnv1a(nullptr, 0);
+    for(const Sensor* sensor : sensors){
+        const RunningStats& st = sensor->getStats();
+        double summary[4] = {st.getMean(), st.stddev(), st.getMin(), st.getMax()};
+        long long anomalies = sensor->getAnomalyCount();
+        hash = fnv1a(summary, sizeof(summary), hash);
+        hash = fnv1a(&anomalies, sizeof(anomalies), hash);
+        for(std::size_t i = 0; i < sensor->historySize(); ++i){
+            double v = sensor->historyAt(i);
+            hash = fnv1a(&v, sizeof(v), hash);
+        }
+        std::cout << sensor->getName() << ": mean " << st.getMean() << ", stddev " << st.stddev()
+                  << ", anomalies " << anomalies << "\n";
+    }
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+    std::cout << "final state hash " << hex << "\n";
+    metricsExport("sensor_data_logger");
+    return 0;
+}
+//the benchmarks (Benchmark/) include this file and bring their own main
+#ifndef BENCHMARK_BUILD
+int main(int argc, char* argv[]) {
+    //headless batch mode: sensor_data_logger --scenario file.txt
+    if(argc >= 3 && std::string(argv[1]) == "--scenario"){
+        return runScenario(argv[2]);
+    }
     int positionX = 0;
     int positionY = 0;
     int battery  = 100;
@@ -183,18 +585,34 @@ int main() {
     */
 
     //Method 2: use class to initial Sensor object, no duplicated code
-    Sensor temperature("Temperature","°C");
-    Sensor distance("Distance","cm");
-    Sensor light("Light","lux");
-    Sensor weight("Weight","g");
+    //Method 3: bounded history, keep the newest 1000 readings and archive
+    //older ones as the mean of every 10 readings (up to 1000 archived values)
+    const std::size_t HISTORY_CAPACITY = 1000;
+    const std::size_t ARCHIVE_EVERY = 10;
+    Sensor temperature("Temperature","°C",HISTORY_CAPACITY,ARCHIVE_EVERY,HISTORY_CAPACITY);
+    Sensor distance("Distance","cm",HISTORY_CAPACITY,ARCHIVE_EVERY,HISTORY_CAPACITY);
+    Sensor light("Light","lux",HISTORY_CAPACITY,ARCHIVE_EVERY,HISTORY_CAPACITY);
+    Sensor weight("Weight","g",HISTORY_CAPACITY,ARCHIVE_EVERY,HISTORY_CAPACITY);
+    //detectors: robust MAD for distance (spiky), EWMA drift for the slow channels
+    temperature.setDetector(std::make_unique<EwmaDriftDetector>(0.2, 3.0, 10));
+    distance.setDetector(std::make_unique<MadDetector>(9, 3.5));
+    light.setDetector(std::make_unique<RollingZScoreDetector>(10, 3.0));
+    weight.setDetector(std::make_unique<EwmaDriftDetector>(0.2, 3.0, 10));
+
+    //every reading is also saved to a binary log (written in blocks of 64 frames)
+    const std::string LOG_PATH = "sensor_log.bin";
+    auto logWriter = std::make_unique<SensorLogWriter>(LOG_PATH,
+        std::vector<std::string>{"Temperature","Distance","Light","Weight"}, 64);
 
     std::cout << std::fixed << std::setprecision(2);
+    AsyncLogger::instance().setFixedPrecision(2); //same number format for log lines
     std::cout << "\n\n=== Sensor Data Logger Robot ===\n";
     std::cout << "Starting up...\n\n";
     
     
 
     do{
+        logFlush(); //let queued log lines out before the menu
         std::cout << "=== Main Menu ===\n";
         std::cout << "1. Take new readings\n";
         std::cout << "2. Show temperature readings\n";
@@ -207,7 +625,8 @@ int main() {
         std::cout << "9. Show weight average\n";
         std::cout << "10. Detect anomaly\n";
         std::cout << "11. Show robot status\n";
-        std::cout << "12. Quit\n";
+        std::cout << "12. Replay saved log\n";
+        std::cout << "13. Quit\n";
         if (!(std::cin >> choice)) {
             std::cin.clear();                  // clear error flag
             std::cin.ignore(10000, '\n');      // discard bad input
@@ -217,7 +636,7 @@ int main() {
         switch(choice){
             case 1 :
                 //takeReading(tempReadings,distReadings,lightReadings,battery);
-                ctakeReading(temperature,distance,light,weight,battery);
+                ctakeReading(temperature,distance,light,weight,battery,logWriter.get());
                 break;
             case 2 :
                 //showHistory(tempReadings,"temperature");
@@ -258,23 +677,33 @@ int main() {
                 distance.detcetAnomaly();
                 light.detcetAnomaly();
                 weight.detcetAnomaly();
+                //re-screen everything still in history, not only the latest reading
+                for(const Sensor* sensor : {&temperature, &distance, &light, &weight}){
+                    LOG_INFO(sensor->getName(), " history: ",
+                             sensor->screenHistory().size(), " anomalous readings");
+                }
                 break;
             case 11 :
                 displayStatus(positionX,positionY,battery);
                 break;
             case 12 :
+                logWriter->flush(); //write the pending block first
+                replayLog(LOG_PATH);
+                break;
+            case 13 :
                 std::cout << "Shutting down simulator. Goodbye!\n" ;
                 break;
             default :
-                std::cout << "Invalid choice! Please enter 1-12.\n";
+                std::cout << "Invalid choice! Please enter 1-13.\n";
                 break;
         }
-        if(battery < 10 && choice != 12){
-            std::cout << "\n === CRITICAL !!!===\nBattery is " << battery << "%!" << " Recharge immediately!\n" ; 
+        if(battery < 10 && choice != 13){
+            LOG_WARN("\n === CRITICAL !!!===\nBattery is ", battery, "%!", " Recharge immediately!");
         }
 
     }
-    while(choice!= 12);
+    while(choice!= 13);
+    metricsExport("sensor_data_logger");
 
     /*testing
     
@@ -286,4 +715,5 @@ int main() {
     std::cout << "Average temperature: " << temp_avg << "°C\n";
     */
     return 0;
-}
\ No newline at end of file
+}
+#endif
@@ -0,0 +1,328 @@
+//sensor_log_format.h
+//Compact binary log for sensor data, one column per channel.
+//
+//File layout (native little-endian, every section 8-byte aligned):
+//  LogFileHeader                       magic, version, channel names
+//  block 0: LogBlockHeader             frame count, time range, CRC32, min/max per channel
+//           int64_t timestamps[n]      column of timestamps (microseconds)
+//           double  channel0[n]        one column per channel
+//           double  channel1[n] ...
+//  block 1: ...
+//
+//The writer collects frames in memory and writes a whole block at once.
+//The reader maps the file into memory (mmap / MapViewOfFile) and returns
+//pointers straight into the mapping, so nothing is parsed or copied.
+#ifndef SENSOR_LOG_FORMAT_H
+#define SENSOR_LOG_FORMAT_H
+
+#include <cstdint>
+#include <cstring>   // for std::memcpy, std::strncpy
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm> // for std::lower_bound, std::upper_bound
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX //keep std::min / std::max usable
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>     // for open()
+#include <sys/mman.h>  // for mmap()
+#include <sys/stat.h>  // for fstat()
+#include <unistd.h>    // for close()
+#endif
+
+const int LOG_MAX_CHANNELS = 8;
+const int LOG_NAME_LENGTH = 16;
+const std::uint32_t LOG_VERSION = 1;
+const std::uint32_t LOG_BLOCK_MAGIC = 0x314B4C42; // "BLK1"
+
+struct LogFileHeader{
+    char magic[8];             // "SENSLOG\0"
+    std::uint32_t version;
+    std::uint32_t channelCount;
+    std::uint32_t blockFrames; // frames per full block (the last block may be shorter)
+    std::uint32_t reserved;
+    char channelNames[LOG_MAX_CHANNELS][LOG_NAME_LENGTH];
+};
+struct LogBlockHeader{
+    std::uint32_t magic;
+    std::uint32_t frameCount;
+    std::uint32_t checksum;    // CRC32 of the columns that follow
+    std::uint32_t reserved;
+    std::int64_t firstTime;
+    std::int64_t lastTime;
+    double minValue[LOG_MAX_CHANNELS]; // block summaries, lets queries skip whole blocks
+    double maxValue[LOG_MAX_CHANNELS];
+};
+static_assert(sizeof(LogFileHeader) % 8 == 0, "header must keep columns 8-byte aligned");
+static_assert(sizeof(LogBlockHeader) % 8 == 0, "block header must keep columns 8-byte aligned");
+
+//CRC32 (same polynomial as zip/png), table built once on first use
+//(a function-local static is initialised exactly once, even with threads)
+inline std::uint32_t logCrc32(const void* data, std::size_t length, std::uint32_t crc = 0){
+    struct Table{std::uint32_t entry[256];};
+    static const Table table = []{
+        Table t;
+        for(std::uint32_t i = 0; i < 256; ++i){
+            std::uint32_t c = i;
+            for(int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t.entry[i] = c;
+        }
+        return t;
+    }();
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    crc = ~crc;
+    for(std::size_t i = 0; i < length; ++i){
+        crc = table.entry[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+//Read-only view of count elements, like C++20 std::span
+template <typename T>
+struct LogSpan{
+    const T* ptr = nullptr;
+    std::size_t count = 0;
+    const T* begin() const {return ptr;}
+    const T* end() const {return ptr + count;}
+    std::size_t size() const {return count;}
+    bool empty() const {return count == 0;}
+    const T& operator[](std::size_t i) const {return ptr[i];}
+};
+//Part of one block that falls inside a queried time range
+struct LogSlice{
+    LogSpan<std::int64_t> timestamps;
+    LogSpan<double> channels[LOG_MAX_CHANNELS];
+    const LogBlockHeader* block = nullptr; // min/max summary of the whole block
+};
+
+//=== Writer ===
+class SensorLogWriter{
+    private:
+        std::ofstream file;
+        std::uint32_t channelCount = 0;
+        std::uint32_t blockFrames = 0;
+        std::vector<std::int64_t> times;           // pending block, one vector per column
+        std::vector<std::vector<double>> columns;
+        std::int64_t lastTime = INT64_MIN;
+    public:
+        SensorLogWriter(const std::string& path, const std::vector<std::string>& channelNames,
+                        std::uint32_t framesPerBlock = 4096)
+            : file(path, std::ios::binary | std::ios::trunc),
+              channelCount(static_cast<std::uint32_t>(std::min<std::size_t>(channelNames.size(), LOG_MAX_CHANNELS))),
+              blockFrames(framesPerBlock > 0 ? framesPerBlock : 1),
+              columns(channelCount){
+            times.reserve(blockFrames);
+            for(auto& col : columns) col.reserve(blockFrames);
+            LogFileHeader header{};
+            std::memcpy(header.magic, "SENSLOG", 8);
+            header.version = LOG_VERSION;
+            header.channelCount = channelCount;
+            header.blockFrames = blockFrames;
+            for(std::uint32_t c = 0; c < channelCount; ++c){
+                std::strncpy(header.channelNames[c], channelNames[c].c_str(), LOG_NAME_LENGTH - 1);
+            }
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        }
+        ~SensorLogWriter(){
+            flush();
+        }
+        SensorLogWriter(const SensorLogWriter&) = delete;
+        SensorLogWriter& operator=(const SensorLogWriter&) = delete;
+
+    bool isOpen() const {return file.good();}
+    //Add one frame: a timestamp plus one value per channel.
+    //Timestamps must not go backwards, otherwise the frame is rejected.
+    bool append(std::int64_t timestamp, const double* values){
+        if(!file || timestamp < lastTime){
+            return false;
+        }
+        lastTime = timestamp;
+        times.push_back(timestamp);
+        for(std::uint32_t c = 0; c < channelCount; ++c){
+            columns[c].push_back(values[c]);
+        }
+        if(times.size() == blockFrames){
+            flush();
+        }
+        return true;
+    }
+    //Write the pending frames as one block
+    void flush(){
+        if(times.empty() || !file){
+            return;
+        }
+        std::uint32_t n = static_cast<std::uint32_t>(times.size());
+        LogBlockHeader block{};
+        block.magic = LOG_BLOCK_MAGIC;
+        block.frameCount = n;
+        block.firstTime = times.front();
+        block.lastTime = times.back();
+        std::uint32_t crc = logCrc32(times.data(), n * sizeof(std::int64_t));
+        for(std::uint32_t c = 0; c < channelCount; ++c){
+            const auto& col = columns[c];
+            auto [lo, hi] = std::minmax_element(col.begin(), col.end());
+            block.minValue[c] = *lo;
+            block.maxValue[c] = *hi;
+            crc = logCrc32(col.data(), n * sizeof(double), crc);
+        }
+        block.checksum = crc;
+        file.write(reinterpret_cast<const char*>(&block), sizeof(block));
+        file.write(reinterpret_cast<const char*>(times.data()), n * sizeof(std::int64_t));
+        for(const auto& col : columns){
+            file.write(reinterpret_cast<const char*>(col.data()), n * sizeof(double));
+        }
+        file.flush();
+        times.clear(); // keeps capacity, no reallocation for the next block
+        for(auto& col : columns) col.clear();
+    }
+};
+
+//=== Memory-mapped reader ===
+class SensorLogReader{
+    private:
+        const unsigned char* base = nullptr;
+        std::size_t length = 0;
+#ifdef _WIN32
+        HANDLE fileHandle = INVALID_HANDLE_VALUE;
+        HANDLE mapHandle = nullptr;
+#else
+        int fd = -1;
+#endif
+        const LogFileHeader* header = nullptr;
+        std::vector<const LogBlockHeader*> blocks; // index built once at open
+        std::size_t totalFrames = 0;
+
+        bool mapFile(const std::string& path){
+#ifdef _WIN32
+            //the writer may still have the file open (replay while logging)
+            fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                                     OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if(fileHandle == INVALID_HANDLE_VALUE) return false;
+            LARGE_INTEGER size;
+            if(!GetFileSizeEx(fileHandle, &size) || size.QuadPart == 0) return false;
+            length = static_cast<std::size_t>(size.QuadPart);
+            mapHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if(!mapHandle) return false;
+            base = static_cast<const unsigned char*>(MapViewOfFile(mapHandle, FILE_MAP_READ, 0, 0, 0));
+            return base != nullptr;
+#else
+            fd = ::open(path.c_str(), O_RDONLY);
+            if(fd < 0) return false;
+            struct stat st;
+            if(fstat(fd, &st) != 0 || st.st_size == 0) return false;
+            length = static_cast<std::size_t>(st.st_size);
+            void* p = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+            if(p == MAP_FAILED) return false;
+            base = static_cast<const unsigned char*>(p);
+            return true;
+#endif
+        }
+        void unmapFile(){
+#ifdef _WIN32
+            if(base) UnmapViewOfFile(base);
+            if(mapHandle) CloseHandle(mapHandle);
+            if(fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+            mapHandle = nullptr;
+            fileHandle = INVALID_HANDLE_VALUE;
+#else
+            if(base) munmap(const_cast<unsigned char*>(base), length);
+            if(fd >= 0) ::close(fd);
+            fd = -1;
+#endif
+            base = nullptr;
+            length = 0;
+        }
+        std::size_t blockBytes(const LogBlockHeader* b) const {
+            return sizeof(LogBlockHeader) + b->frameCount * (sizeof(std::int64_t) + header->channelCount * sizeof(double));
+        }
+        //Walk the block headers once; stops at the first truncated or damaged block
+        void buildIndex(){
+            std::size_t offset = sizeof(LogFileHeader);
+            while(offset + sizeof(LogBlockHeader) <= length){
+                const auto* b = reinterpret_cast<const LogBlockHeader*>(base + offset);
+                if(b->magic != LOG_BLOCK_MAGIC || b->frameCount == 0 || offset + blockBytes(b) > length){
+                    break;
+                }
+                blocks.push_back(b);
+                totalFrames += b->frameCount;
+                offset += blockBytes(b);
+            }
+        }
+        const std::int64_t* timesOf(const LogBlockHeader* b) const {
+            return reinterpret_cast<const std::int64_t*>(b + 1);
+        }
+        const double* columnOf(const LogBlockHeader* b, std::uint32_t channel) const {
+            return reinterpret_cast<const double*>(timesOf(b) + b->frameCount) + channel * b->frameCount;
+        }
+    public:
+        explicit SensorLogReader(const std::string& path){
+            if(!mapFile(path) || length < sizeof(LogFileHeader)){
+                unmapFile();
+                return;
+            }
+            header = reinterpret_cast<const LogFileHeader*>(base);
+            if(std::memcmp(header->magic, "SENSLOG", 8) != 0 || header->version != LOG_VERSION
+               || header->channelCount > LOG_MAX_CHANNELS){
+                header = nullptr;
+                unmapFile();
+                return;
+            }
+            buildIndex();
+        }
+        ~SensorLogReader(){
+            unmapFile();
+        }
+        SensorLogReader(const SensorLogReader&) = delete;
+        SensorLogReader& operator=(const SensorLogReader&) = delete;
+
+    bool isOpen() const {return header != nullptr;}
+    std::uint32_t channelCount() const {return header ? header->channelCount : 0;}
+    std::string channelName(std::uint32_t c) const {
+        const char* name = header->channelNames[c];
+        return std::string(name, std::find(name, name + LOG_NAME_LENGTH, '\0'));
+    }
+    std::size_t frameCount() const {return totalFrames;}
+    std::size_t blockCount() const {return blocks.size();}
+    const LogBlockHeader& block(std::size_t i) const {return *blocks[i];}
+    //Check every block against its CRC32. Returns the number of damaged blocks.
+    std::size_t verify() const {
+        std::size_t bad = 0;
+        for(const auto* b : blocks){
+            std::size_t payload = blockBytes(b) - sizeof(LogBlockHeader);
+            if(logCrc32(b + 1, payload) != b->checksum) ++bad;
+        }
+        return bad;
+    }
+    //All frames with from <= timestamp <= to, as zero-copy slices (one per block touched)
+    std::vector<LogSlice> range(std::int64_t from, std::int64_t to) const {
+        std::vector<LogSlice> result;
+        if(!header || from > to) return result;
+        //first block that ends at or after "from"; blocks are sorted by time
+        auto it = std::lower_bound(blocks.begin(), blocks.end(), from,
+            [](const LogBlockHeader* b, std::int64_t t){ return b->lastTime < t; });
+        for(; it != blocks.end() && (*it)->firstTime <= to; ++it){
+            const LogBlockHeader* b = *it;
+            const std::int64_t* t = timesOf(b);
+            const std::int64_t* first = std::lower_bound(t, t + b->frameCount, from);
+            const std::int64_t* last = std::upper_bound(first, t + b->frameCount, to);
+            if(first == last) continue;
+            LogSlice slice;
+            slice.block = b;
+            std::size_t start = static_cast<std::size_t>(first - t);
+            std::size_t count = static_cast<std::size_t>(last - first);
+            slice.timestamps = {first, count};
+            for(std::uint32_t c = 0; c < header->channelCount; ++c){
+                slice.channels[c] = {columnOf(b, c) + start, count};
+            }
+            result.push_back(slice);
+        }
+        return result;
+    }
+};
+
+#endif
@@ -0,0 +1,622 @@
+//chunked_world.h
+//Obstacle map for worlds far bigger than memory (1M x 1M cells and more).
+//The world is cut into tiles of 64 x 64 cells (one 64-bit word per tile row)
+//and the tiles into regions of 32 x 32 tiles (2048 x 2048 cells).
+//Regions and tiles have a summary state - all free, all blocked or mixed -
+//so open floor and solid walls cost nothing and are answered without
+//touching any cell data. Only mixed tiles hold a bitmap.
+//
+//The map lives in a compact file (writeChunkedMap) that is mapped into memory
+//read-only (mmap / MapViewOfFile). Identical tiles and identical regions are
+//stored once, so a regular layout such as a warehouse stays a few KB.
+//
+//Tiles near the robots are copied out of the file into a tile cache
+//(track() + trim(), once per tick); the least recently used tiles are dropped
+//when the cache is over its budget. A cell of a tile that is not in the cache is read
+//straight from the mapped file, so the answer never depends on what is cached,
+//only the speed. Edited tiles (set / clear) stay in memory for good.
+//Memory therefore follows the area around the robots, not the world area.
+//
+//isBlocked() never changes anything and can be called from many threads;
+//track(), trim(), set() and clear() must not run at the same time as other calls.
+#ifndef CHUNKED_WORLD_H
+#define CHUNKED_WORLD_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX //keep std::min / std::max usable
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>     // for open()
+#include <sys/mman.h>  // for mmap()
+#include <sys/stat.h>  // for fstat()
+#include <unistd.h>    // for close()
+#endif
+
+enum class ChunkState : std::uint8_t {Free, Blocked, Mixed};
+
+const int CHUNK_TILE_BITS = 6;                     //tile side = 64 cells
+const int CHUNK_TILE = 1 << CHUNK_TILE_BITS;
+const int CHUNK_REGION_BITS = 5;                   //region side = 32 tiles
+const int CHUNK_REGION_TILES = 1 << (2 * CHUNK_REGION_BITS); //1024 tiles per region
+const char CHUNKED_MAP_MAGIC[8] = {'R', 'O', 'B', 'O', 'M', 'A', 'P', '1'};
+
+//=== File layout ===
+//header
+//region table: one uint64 per region (row by row): 0 free, 1 blocked,
+//              otherwise 2 + index of its tile table
+//tile tables:  1024 uint32 per table (tile rows of the region): 0 free,
+//              1 blocked, otherwise 2 + index of the tile in the tile pool
+//tile pool:    64 uint64 per tile, word = one row, bit x = cell x
+struct ChunkedMapHeader{
+    char magic[8];
+    std::uint32_t tileBits;
+    std::uint32_t regionBits;
+    std::int32_t width;
+    std::int32_t height;
+    std::uint64_t blockedCells;
+    std::uint64_t tableCount;
+    std::uint64_t tileCount;
+    std::uint64_t tablesOffset;
+    std::uint64_t poolOffset;
+};
+
+inline std::uint64_t chunkHash(const void* data, std::size_t words64){
+    std::uint64_t h = 0x9E3779B97F4A7C15ull;
+    const auto* p = static_cast<const unsigned char*>(data);
+    for(std::size_t i = 0; i < words64; ++i){
+        std::uint64_t w;
+        std::memcpy(&w, p + i * 8, 8);
+        h = (h ^ w) * 0xFF51AFD7ED558CCDull;
+        h ^= h >> 32;
+    }
+    return h;
+}
+
+//Write a map file for a width x height world.
+//  regionState(rx, ry) -> ChunkState: Free / Blocked regions are stored as one
+//                         entry, for Mixed every tile of the region is asked
+//  fillTile(tx, ty, std::uint64_t rows[64]) -> ChunkState: fills the rows of a
+//                         mixed tile (cells outside the world are ignored)
+//The unique tiles and tile tables are kept in memory until the end.
+template <typename RegionFn, typename TileFn>
+bool writeChunkedMap(const std::string& path, int width, int height, RegionFn regionState, TileFn fillTile){
+    if(width <= 0 || height <= 0) return false;
+    const int regionCells = CHUNK_TILE << CHUNK_REGION_BITS;
+    const std::size_t regionsX = (static_cast<std::size_t>(width) + regionCells - 1) / regionCells;
+    const std::size_t regionsY = (static_cast<std::size_t>(height) + regionCells - 1) / regionCells;
+    std::vector<std::uint64_t> regionTable(regionsX * regionsY, 0);
+    std::vector<std::uint32_t> tables; //unique tile tables, back to back
+    std::vector<std::uint64_t> pool;   //unique tiles, back to back
+    std::unordered_map<std::uint64_t, std::vector<std::uint32_t>> tableIndex, tileIndex; //hash -> indices
+    std::uint64_t blocked = 0;
+
+    //index of `data` in `store` (blocks of `words` values), added if new
+    auto intern = [](auto& store, auto& index, const auto* data, std::size_t words, std::size_t hashWords64){
+        std::uint64_t h = chunkHash(data, hashWords64);
+        for(std::uint32_t i : index[h]){
+            if(std::memcmp(store.data() + static_cast<std::size_t>(i) * words, data, words * sizeof(*data)) == 0) return i;
+        }
+        std::uint32_t i = static_cast<std::uint32_t>(store.size() / words);
+        store.insert(store.end(), data, data + words);
+        index[h].push_back(i);
+        return i;
+    };
+
+    std::vector<std::uint32_t> table(CHUNK_REGION_TILES);
+    std::uint64_t rows[CHUNK_TILE];
+    for(std::size_t ry = 0; ry < regionsY; ++ry){
+        for(std::size_t rx = 0; rx < regionsX; ++rx){
+            const int x0 = static_cast<int>(rx) * regionCells;
+            const int y0 = static_cast<int>(ry) * regionCells;
+            const std::uint64_t regionArea = static_cast<std::uint64_t>(std::min(regionCells, width - x0))
+                                           * static_cast<std::uint64_t>(std::min(regionCells, height - y0));
+            ChunkState rs = regionState(static_cast<int>(rx), static_cast<int>(ry));
+            std::uint64_t& entry = regionTable[ry * regionsX + rx];
+            if(rs != ChunkState::Mixed){
+                entry = rs == ChunkState::Blocked ? 1 : 0;
+                if(rs == ChunkState::Blocked) blocked += regionArea;
+                continue;
+            }
+            bool allFree = true;
+            bool allBlocked = true;
+            for(int t = 0; t < CHUNK_REGION_TILES; ++t){
+                const int tx = static_cast<int>(rx << CHUNK_REGION_BITS) + (t & ((1 << CHUNK_REGION_BITS) - 1));
+                const int ty = static_cast<int>(ry << CHUNK_REGION_BITS) + (t >> CHUNK_REGION_BITS);
+                const int cols = std::min(CHUNK_TILE, width - tx * CHUNK_TILE);
+                const int validRows = std::min(CHUNK_TILE, height - ty * CHUNK_TILE);
+                if(cols <= 0 || validRows <= 0){
+                    table[t] = 0; //outside the world
+                    continue;
+                }
+                std::memset(rows, 0, sizeof(rows));
+                ChunkState ts = fillTile(tx, ty, rows);
+                const std::uint64_t area = static_cast<std::uint64_t>(cols) * validRows;
+                if(ts == ChunkState::Mixed){
+                    //only cells inside the world count, the rest are stored as free
+                    const std::uint64_t colMask = cols == 64 ? ~0ull : (1ull << cols) - 1;
+                    std::uint64_t count = 0;
+                    for(int r = 0; r < CHUNK_TILE; ++r){
+                        rows[r] = r < validRows ? rows[r] & colMask : 0;
+                        count += static_cast<std::uint64_t>(__builtin_popcountll(rows[r]));
+                    }
+                    if(count == 0) ts = ChunkState::Free;
+                    else if(count == area) ts = ChunkState::Blocked;
+                    else blocked += count;
+                }
+                if(ts == ChunkState::Free){
+                    table[t] = 0;
+                    allBlocked = false;
+                }
+                else if(ts == ChunkState::Blocked){
+                    table[t] = 1;
+                    blocked += area;
+                    allFree = false;
+                }
+                else{
+                    table[t] = 2 + intern(pool, tileIndex, rows, CHUNK_TILE, CHUNK_TILE);
+                    allFree = allBlocked = false;
+                }
+            }
+            if(allFree) entry = 0;
+            else if(allBlocked) entry = 1;
+            else entry = 2 + intern(tables, tableIndex, table.data(), CHUNK_REGION_TILES, CHUNK_REGION_TILES / 2);
+        }
+    }
+
+    ChunkedMapHeader header;
+    std::memcpy(header.magic, CHUNKED_MAP_MAGIC, sizeof(header.magic));
+    header.tileBits = CHUNK_TILE_BITS;
+    header.regionBits = CHUNK_REGION_BITS;
+    header.width = width;
+    header.height = height;
+    header.blockedCells = blocked;
+    header.tableCount = tables.size() / CHUNK_REGION_TILES;
+    header.tileCount = pool.size() / CHUNK_TILE;
+    header.tablesOffset = sizeof(ChunkedMapHeader) + regionTable.size() * sizeof(std::uint64_t);
+    header.poolOffset = header.tablesOffset + tables.size() * sizeof(std::uint32_t);
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if(!out) return false;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(regionTable.data()), regionTable.size() * sizeof(std::uint64_t));
+    out.write(reinterpret_cast<const char*>(tables.data()), tables.size() * sizeof(std::uint32_t));
+    out.write(reinterpret_cast<const char*>(pool.data()), pool.size() * sizeof(std::uint64_t));
+    return static_cast<bool>(out);
+}
+
+class ChunkedWorld{
+    private:
+        //tile summaries and cache slots of one region, only while it has cached tiles
+        struct RegionPage{
+            ChunkState state[CHUNK_REGION_TILES];
+            std::int32_t slot[CHUNK_REGION_TILES]; //tile cache slot, -1 = not cached
+            std::uint32_t cached = 0;
+            bool pinned = false;                   //holds edits, never dropped
+        };
+        struct CachedTile{
+            std::uint64_t rows[CHUNK_TILE];
+            std::int32_t prev = -1;   //LRU list, most recent first
+            std::int32_t next = -1;
+            std::uint32_t region = 0;
+            std::uint32_t tile = 0;
+            std::uint32_t stamp = 0;  //last track() that needed it
+            bool pinned = false;      //edited: not in the LRU list
+        };
+
+        int width = 0;
+        int height = 0;
+        int regionsX = 0;
+        int regionsY = 0;
+        std::vector<ChunkState> regionState;
+        std::vector<std::unique_ptr<RegionPage>> pages;
+        std::vector<CachedTile> tiles;
+        std::vector<std::int32_t> freeSlots;
+        std::int32_t lruHead = -1;
+        std::int32_t lruTail = -1;
+        std::size_t budget;            //unpinned tiles kept in the cache
+        std::size_t cachedCount = 0;   //pinned included
+        std::size_t pinnedCount = 0;
+        std::size_t pageCount = 0;
+        std::uint64_t blockedCells = 0;
+        std::uint32_t stamp = 0;
+        std::uint64_t loadCount = 0;
+        std::uint64_t evictCount = 0;
+
+        //mapped file, nullptr for a world built in memory
+        const unsigned char* base = nullptr;
+        std::size_t length = 0;
+#ifdef _WIN32
+        HANDLE fileHandle = INVALID_HANDLE_VALUE;
+        HANDLE mapHandle = nullptr;
+#else
+        int fd = -1;
+#endif
+        ChunkedMapHeader header{};
+
+        bool mapFile(const std::string& path){
+#ifdef _WIN32
+            fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                     OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if(fileHandle == INVALID_HANDLE_VALUE) return false;
+            LARGE_INTEGER size;
+            if(!GetFileSizeEx(fileHandle, &size) || size.QuadPart == 0) return false;
+            length = static_cast<std::size_t>(size.QuadPart);
+            mapHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if(!mapHandle) return false;
+            base = static_cast<const unsigned char*>(MapViewOfFile(mapHandle, FILE_MAP_READ, 0, 0, 0));
+            return base != nullptr;
+#else
+            fd = ::open(path.c_str(), O_RDONLY);
+            if(fd < 0) return false;
+            struct stat st;
+            if(fstat(fd, &st) != 0 || st.st_size == 0) return false;
+            length = static_cast<std::size_t>(st.st_size);
+            void* p = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+            if(p == MAP_FAILED) return false;
+            base = static_cast<const unsigned char*>(p);
+            return true;
+#endif
+        }
+        void unmapFile(){
+#ifdef _WIN32
+            if(base) UnmapViewOfFile(base);
+            if(mapHandle) CloseHandle(mapHandle);
+            if(fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+            mapHandle = nullptr;
+            fileHandle = INVALID_HANDLE_VALUE;
+#else
+            if(base) munmap(const_cast<unsigned char*>(base), length);
+            if(fd >= 0) ::close(fd);
+            fd = -1;
+#endif
+            base = nullptr;
+            length = 0;
+        }
+        //Check the header and every table entry once, so lookups need no checks
+        bool validate(){
+            if(length < sizeof(ChunkedMapHeader)) return false;
+            std::memcpy(&header, base, sizeof(header));
+            if(std::memcmp(header.magic, CHUNKED_MAP_MAGIC, sizeof(header.magic)) != 0
+               || header.tileBits != CHUNK_TILE_BITS || header.regionBits != CHUNK_REGION_BITS
+               || header.width <= 0 || header.height <= 0){
+                return false;
+            }
+            setSize(header.width, header.height);
+            const std::uint64_t regions = regionState.size();
+            if(header.tablesOffset != sizeof(ChunkedMapHeader) + regions * sizeof(std::uint64_t)
+               || header.poolOffset != header.tablesOffset + header.tableCount * CHUNK_REGION_TILES * sizeof(std::uint32_t)
+               || header.poolOffset + header.tileCount * CHUNK_TILE * sizeof(std::uint64_t) > length){
+                return false;
+            }
+            for(std::uint64_t r = 0; r < regions; ++r){
+                std::uint64_t e = regionEntry(static_cast<std::uint32_t>(r));
+                if(e >= 2 + header.tableCount) return false;
+                regionState[r] = e == 0 ? ChunkState::Free : e == 1 ? ChunkState::Blocked : ChunkState::Mixed;
+            }
+            const std::uint32_t* t = reinterpret_cast<const std::uint32_t*>(base + header.tablesOffset);
+            for(std::uint64_t i = 0; i < header.tableCount * CHUNK_REGION_TILES; ++i){
+                if(t[i] >= 2 + header.tileCount) return false;
+            }
+            blockedCells = header.blockedCells;
+            return true;
+        }
+        void setSize(int w, int h){
+            width = w;
+            height = h;
+            const int regionCells = CHUNK_TILE << CHUNK_REGION_BITS;
+            regionsX = (w + regionCells - 1) / regionCells;
+            regionsY = (h + regionCells - 1) / regionCells;
+            const std::size_t regions = static_cast<std::size_t>(regionsX) * regionsY;
+            regionState.assign(regions, ChunkState::Free);
+            pages.clear();
+            pages.resize(regions);
+        }
+
+        std::uint32_t regionOf(int x, int y) const {
+            const int shift = CHUNK_TILE_BITS + CHUNK_REGION_BITS;
+            return static_cast<std::uint32_t>(y >> shift) * static_cast<std::uint32_t>(regionsX)
+                 + static_cast<std::uint32_t>(x >> shift);
+        }
+        static std::uint32_t tileOf(int x, int y){
+            const int mask = (1 << CHUNK_REGION_BITS) - 1;
+            return static_cast<std::uint32_t>(((y >> CHUNK_TILE_BITS) & mask) << CHUNK_REGION_BITS)
+                 | static_cast<std::uint32_t>((x >> CHUNK_TILE_BITS) & mask);
+        }
+        std::uint64_t regionEntry(std::uint32_t r) const {
+            return reinterpret_cast<const std::uint64_t*>(base + sizeof(ChunkedMapHeader))[r];
+        }
+        //Entry of tile t in the file's table of a mixed region (0 / 1 / 2 + pool index)
+        std::uint32_t fileTile(std::uint32_t r, std::uint32_t t) const {
+            const std::uint64_t table = regionEntry(r) - 2;
+            return reinterpret_cast<const std::uint32_t*>(base + header.tablesOffset)[table * CHUNK_REGION_TILES + t];
+        }
+        const std::uint64_t* poolTile(std::uint32_t entry) const {
+            return reinterpret_cast<const std::uint64_t*>(base + header.poolOffset) + static_cast<std::uint64_t>(entry - 2) * CHUNK_TILE;
+        }
+        //State of a tile of a mixed region, from its page or from the file
+        ChunkState tileState(std::uint32_t r, std::uint32_t t) const {
+            if(const RegionPage* page = pages[r].get()) return page->state[t];
+            std::uint32_t e = fileTile(r, t);
+            return e == 0 ? ChunkState::Free : e == 1 ? ChunkState::Blocked : ChunkState::Mixed;
+        }
+
+        RegionPage& page(std::uint32_t r){
+            if(!pages[r]){
+                auto p = std::make_unique<RegionPage>();
+                for(std::uint32_t t = 0; t < CHUNK_REGION_TILES; ++t){
+                    //a region without a file table is free or blocked as a whole
+                    p->state[t] = regionState[r] == ChunkState::Mixed ? tileState(r, t) : regionState[r];
+                    p->slot[t] = -1;
+                }
+                pages[r] = std::move(p);
+                ++pageCount;
+            }
+            return *pages[r];
+        }
+        void unlink(std::int32_t s){
+            CachedTile& c = tiles[s];
+            if(c.prev >= 0) tiles[c.prev].next = c.next;
+            else lruHead = c.next;
+            if(c.next >= 0) tiles[c.next].prev = c.prev;
+            else lruTail = c.prev;
+            c.prev = c.next = -1;
+        }
+        void pushFront(std::int32_t s){
+            CachedTile& c = tiles[s];
+            c.prev = -1;
+            c.next = lruHead;
+            if(lruHead >= 0) tiles[lruHead].prev = s;
+            lruHead = s;
+            if(lruTail < 0) lruTail = s;
+        }
+        //Copy tile t of region r into the cache, returns its slot
+        std::int32_t load(std::uint32_t r, std::uint32_t t){
+            RegionPage& p = page(r);
+            std::int32_t s;
+            if(!freeSlots.empty()){
+                s = freeSlots.back();
+                freeSlots.pop_back();
+            }
+            else{
+                s = static_cast<std::int32_t>(tiles.size());
+                tiles.emplace_back();
+            }
+            CachedTile& c = tiles[s];
+            if(p.state[t] == ChunkState::Mixed) std::memcpy(c.rows, poolTile(fileTile(r, t)), sizeof(c.rows));
+            else std::memset(c.rows, p.state[t] == ChunkState::Blocked ? 0xFF : 0, sizeof(c.rows));
+            c.region = r;
+            c.tile = t;
+            c.stamp = stamp;
+            c.pinned = false;
+            pushFront(s);
+            p.slot[t] = s;
+            ++p.cached;
+            ++cachedCount;
+            ++loadCount;
+            return s;
+        }
+        void evict(std::int32_t s){
+            CachedTile& c = tiles[s];
+            unlink(s);
+            RegionPage& p = *pages[c.region];
+            p.slot[c.tile] = -1;
+            --cachedCount;
+            ++evictCount;
+            freeSlots.push_back(s);
+            if(--p.cached == 0 && !p.pinned){
+                pages[c.region].reset();
+                --pageCount;
+            }
+        }
+        static int bitCount(std::uint64_t v){
+            int n = 0;
+            for(; v; v &= v - 1) ++n;
+            return n;
+        }
+        //Row word of cell (x, y) in a cached, pinned tile, for edits
+        std::uint64_t& editRow(int x, int y){
+            const std::uint32_t r = regionOf(x, y);
+            const std::uint32_t t = tileOf(x, y);
+            RegionPage& p = page(r);
+            p.pinned = true;
+            regionState[r] = ChunkState::Mixed;
+            std::int32_t s = p.slot[t];
+            if(s < 0) s = load(r, t);
+            CachedTile& c = tiles[s];
+            if(!c.pinned){
+                unlink(s);
+                c.pinned = true;
+                ++pinnedCount;
+            }
+            if(p.state[t] != ChunkState::Mixed){
+                //a blocked tile at the world edge only has its cells inside the world set
+                const int cols = std::min(CHUNK_TILE, width - (x & ~(CHUNK_TILE - 1)));
+                const int validRows = std::min(CHUNK_TILE, height - (y & ~(CHUNK_TILE - 1)));
+                const std::uint64_t colMask = cols == 64 ? ~0ull : (1ull << cols) - 1;
+                for(int row = 0; row < CHUNK_TILE; ++row) c.rows[row] = row < validRows ? c.rows[row] & colMask : 0;
+                p.state[t] = ChunkState::Mixed;
+            }
+            return c.rows[y & (CHUNK_TILE - 1)];
+        }
+    public:
+        //An all-free world of w x h cells
+        ChunkedWorld(int w, int h, std::size_t maxCachedTiles = 65536) : budget(maxCachedTiles){
+            setSize(w > 0 ? w : 0, h > 0 ? h : 0);
+        }
+        //A world from a map file; check isOpen()
+        explicit ChunkedWorld(const std::string& path, std::size_t maxCachedTiles = 65536) : budget(maxCachedTiles){
+            if(!mapFile(path) || !validate()){
+                unmapFile();
+                setSize(0, 0);
+            }
+        }
+        ~ChunkedWorld(){unmapFile();}
+        ChunkedWorld(const ChunkedWorld&) = delete;
+        ChunkedWorld& operator=(const ChunkedWorld&) = delete;
+
+    bool isOpen() const {return base != nullptr;}
+    int getWidth() const {return width;}
+    int getHeight() const {return height;}
+    std::size_t blocked() const {return static_cast<std::size_t>(blockedCells);}
+    //(x, y) must be inside the world
+    bool isBlocked(int x, int y) const {
+        const std::uint32_t r = regionOf(x, y);
+        const ChunkState rs = regionState[r];
+        if(rs != ChunkState::Mixed) return rs == ChunkState::Blocked;
+        const std::uint32_t t = tileOf(x, y);
+        const int bx = x & (CHUNK_TILE - 1);
+        const int by = y & (CHUNK_TILE - 1);
+        if(const RegionPage* p = pages[r].get()){
+            const ChunkState ts = p->state[t];
+            if(ts != ChunkState::Mixed) return ts == ChunkState::Blocked;
+            if(p->slot[t] >= 0) return (tiles[p->slot[t]].rows[by] >> bx) & 1u;
+        }
+        const std::uint32_t e = fileTile(r, t);
+        if(e < 2) return e == 1;
+        return (poolTile(e)[by] >> bx) & 1u;
+    }
+    //(x, y) inside the world; returns false if already blocked
+    bool set(int x, int y){
+        if(isBlocked(x, y)) return false;
+        editRow(x, y) |= 1ull << (x & (CHUNK_TILE - 1));
+        ++blockedCells;
+        return true;
+    }
+    //(x, y) inside the world; returns false if it was not blocked
+    bool clear(int x, int y){
+        if(!isBlocked(x, y)) return false;
+        editRow(x, y) &= ~(1ull << (x & (CHUNK_TILE - 1)));
+        --blockedCells;
+        return true;
+    }
+    //Everything free; the file is no longer used
+    void clearAll(){
+        unmapFile();
+        setSize(width, height);
+        tiles.clear();
+        freeSlots.clear();
+        lruHead = lruTail = -1;
+        cachedCount = pinnedCount = pageCount = 0;
+        blockedCells = 0;
+    }
+    //Cache the tiles within `margin` cells of these robots (margin = the
+    //longest single move). Call for every group of robots, then trim() once per tick.
+    void track(const int* xs, const int* ys, std::size_t n, int margin){
+        for(std::size_t i = 0; i < n; ++i){
+            const int x0 = std::max(0, xs[i] - margin) >> CHUNK_TILE_BITS;
+            const int x1 = std::min(width - 1, xs[i] + margin) >> CHUNK_TILE_BITS;
+            const int y0 = std::max(0, ys[i] - margin) >> CHUNK_TILE_BITS;
+            const int y1 = std::min(height - 1, ys[i] + margin) >> CHUNK_TILE_BITS;
+            for(int ty = y0; ty <= y1; ++ty){
+                for(int tx = x0; tx <= x1; ++tx){
+                    const int cx = tx << CHUNK_TILE_BITS;
+                    const int cy = ty << CHUNK_TILE_BITS;
+                    const std::uint32_t r = regionOf(cx, cy);
+                    if(regionState[r] != ChunkState::Mixed) continue; //summary is enough
+                    const std::uint32_t t = tileOf(cx, cy);
+                    if(tileState(r, t) != ChunkState::Mixed) continue;
+                    std::int32_t s = pages[r] ? pages[r]->slot[t] : -1;
+                    if(s < 0){
+                        load(r, t);
+                        continue;
+                    }
+                    CachedTile& c = tiles[s];
+                    if(c.pinned || c.stamp == stamp) continue;
+                    c.stamp = stamp;
+                    unlink(s);
+                    pushFront(s);
+                }
+            }
+        }
+    }
+    //Drop least recently used tiles beyond the budget. Tiles tracked since the
+    //last trim() stay even over the budget: the robots are standing on them.
+    void trim(){
+        while(cachedCount - pinnedCount > budget && lruTail >= 0 && tiles[lruTail].stamp != stamp){
+            evict(lruTail);
+        }
+        ++stamp;
+    }
+    void setTileBudget(std::size_t maxCachedTiles){budget = maxCachedTiles;}
+    std::size_t cachedTiles() const {return cachedCount;}
+    std::size_t pinnedTiles() const {return pinnedCount;}
+    std::uint64_t loads() const {return loadCount;}
+    std::uint64_t evictions() const {return evictCount;}
+    //Bytes held for cached tiles, region pages and the region summary
+    std::size_t memoryBytes() const {
+        return tiles.capacity() * sizeof(CachedTile) + pageCount * sizeof(RegionPage)
+             + regionState.capacity() * (sizeof(ChunkState) + sizeof(std::unique_ptr<RegionPage>));
+    }
+    std::size_t fileBytes() const {return length;}
+    //Visit every blocked cell as fn(x, y); walks the whole map
+    template <typename Fn>
+    void forEachBlocked(Fn fn) const {
+        const int regionCells = CHUNK_TILE << CHUNK_REGION_BITS;
+        for(int ry = 0; ry < regionsY; ++ry){
+            for(int rx = 0; rx < regionsX; ++rx){
+                const std::uint32_t r = static_cast<std::uint32_t>(ry) * regionsX + rx;
+                const int x0 = rx * regionCells;
+                const int y0 = ry * regionCells;
+                if(regionState[r] == ChunkState::Free) continue;
+                if(regionState[r] == ChunkState::Blocked){
+                    for(int y = y0; y < std::min(height, y0 + regionCells); ++y){
+                        for(int x = x0; x < std::min(width, x0 + regionCells); ++x) fn(x, y);
+                    }
+                    continue;
+                }
+                for(std::uint32_t t = 0; t < CHUNK_REGION_TILES; ++t){
+                    const int tx0 = x0 + static_cast<int>(t & ((1 << CHUNK_REGION_BITS) - 1)) * CHUNK_TILE;
+                    const int ty0 = y0 + static_cast<int>(t >> CHUNK_REGION_BITS) * CHUNK_TILE;
+                    if(tx0 >= width || ty0 >= height) continue;
+                    const ChunkState ts = tileState(r, t);
+                    if(ts == ChunkState::Free) continue;
+                    for(int y = ty0; y < std::min(height, ty0 + CHUNK_TILE); ++y){
+                        for(int x = tx0; x < std::min(width, tx0 + CHUNK_TILE); ++x){
+                            if(ts == ChunkState::Blocked || isBlocked(x, y)) fn(x, y);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    //Edited tiles as fn(x0, y0, rows): the tile's first cell and its 64 row words.
+    //On top of the map file they are everything that changed.
+    template <typename Fn>
+    void forEachEditedTile(Fn fn) const {
+        const int regionCells = CHUNK_TILE << CHUNK_REGION_BITS;
+        const std::uint32_t mask = (1u << CHUNK_REGION_BITS) - 1;
+        for(const CachedTile& c : tiles){
+            if(!c.pinned) continue;
+            const int x0 = static_cast<int>(c.region % regionsX) * regionCells + static_cast<int>(c.tile & mask) * CHUNK_TILE;
+            const int y0 = static_cast<int>(c.region / regionsX) * regionCells + static_cast<int>(c.tile >> CHUNK_REGION_BITS) * CHUNK_TILE;
+            fn(x0, y0, c.rows);
+        }
+    }
+    //Overwrite the tile whose first cell is (x0, y0) with these rows, as an edit
+    //(restores a tile from forEachEditedTile). False if (x0, y0) starts no tile.
+    bool writeTile(int x0, int y0, const std::uint64_t* rows){
+        if(x0 < 0 || y0 < 0 || x0 >= width || y0 >= height || (x0 | y0) & (CHUNK_TILE - 1)) return false;
+        const int cols = std::min(CHUNK_TILE, width - x0);
+        const std::uint64_t colMask = cols == 64 ? ~0ull : (1ull << cols) - 1;
+        for(int row = 0; row < CHUNK_TILE && y0 + row < height; ++row){
+            std::uint64_t& word = editRow(x0, y0 + row);
+            blockedCells -= bitCount(word);
+            word = rows[row] & colMask;
+            blockedCells += bitCount(word);
+        }
+        return true;
+    }
+};
+
+#endif
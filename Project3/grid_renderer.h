@@ -0,0 +1,238 @@
+//grid_renderer.h
+//Frame-buffer renderer for the grid world.
+//The renderer only looks at the cells inside its viewport, so drawing cost
+//depends on the terminal size, not on the world size. With zoom > 1 one
+//character stands for a zoom x zoom block of cells.
+//Two ways to show a frame:
+//  frameText() - the whole view as plain text (rows top to bottom, "c c c ")
+//  update() + present() - live mode: keeps the previous frame and sends only
+//                the cells that changed, using ANSI cursor positioning, in one write
+//                (check ansiSupported() first, it also switches Windows consoles
+//                to escape-sequence mode)
+//Drawing order decides who wins a character: draw robots first, obstacles last.
+#ifndef GRID_RENDERER_H
+#define GRID_RENDERER_H
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "occupancy_grid.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX //keep std::min / std::max usable
+#endif
+#include <windows.h>
+#ifndef ENABLE_VIRTUAL_TERMINAL_PROCESSING //missing from older MinGW headers
+#define ENABLE_VIRTUAL_TERMINAL_PROCESSING 0x0004
+#endif
+#endif
+
+class GridRenderer{
+    private:
+        int viewCols;
+        int viewRows;
+        int originX = 0; //world cell shown in the bottom-left character
+        int originY = 0;
+        int zoom = 1;    //world cells per character, in both directions
+        std::vector<char> current;  //view row 0 = bottom row
+        std::vector<char> previous; //what the terminal shows now (live mode)
+        bool screenValid = false;   //false = next update() redraws everything
+        std::string out;
+        int statusRow = 1;
+        int parkRow = 1;
+
+        char& at(int col, int row){return current[static_cast<std::size_t>(row) * viewCols + col];}
+        //terminal position of a view character (1-based, top row first)
+        void moveCursor(int col, int row, int top){
+            out += "\x1b[";
+            out += std::to_string(top + (viewRows - 1 - row));
+            out += ';';
+            out += std::to_string(1 + col * 2);
+            out += 'H';
+        }
+    public:
+        GridRenderer(int cols = 40, int rows = 20)
+            : viewCols(cols > 0 ? cols : 1), viewRows(rows > 0 ? rows : 1),
+              current(static_cast<std::size_t>(viewCols) * viewRows, '.'){}
+
+    int getCols() const {return viewCols;}
+    int getRows() const {return viewRows;}
+    int getZoom() const {return zoom;}
+    int getOriginX() const {return originX;}
+    int getOriginY() const {return originY;}
+    //World cells covered by the view
+    int spanX() const {return viewCols * zoom;}
+    int spanY() const {return viewRows * zoom;}
+
+    //Resize the view in characters (clamped to the world when it is smaller)
+    void resize(int cols, int rows){
+        viewCols = cols > 0 ? cols : 1;
+        viewRows = rows > 0 ? rows : 1;
+        current.assign(static_cast<std::size_t>(viewCols) * viewRows, '.');
+        screenValid = false;
+    }
+    //Fit the view to the world if it is smaller than the terminal
+    void fitTo(const OccupancyGrid& world, int maxCols, int maxRows){
+        resize(std::min(maxCols, (world.getWidth() + zoom - 1) / zoom),
+               std::min(maxRows, (world.getHeight() + zoom - 1) / zoom));
+    }
+    void setZoom(int z){
+        zoom = z > 0 ? z : 1;
+        screenValid = false;
+    }
+    //Scrolling needs no full redraw: update() compares with what is on screen
+    void setOrigin(int x, int y){
+        originX = x;
+        originY = y;
+    }
+    //Put (x, y) in the middle of the view, without showing space outside the world
+    void centerOn(int x, int y, const OccupancyGrid& world){
+        int ox = std::max(0, std::min(x - spanX() / 2, world.getWidth() - spanX()));
+        int oy = std::max(0, std::min(y - spanY() / 2, world.getHeight() - spanY()));
+        setOrigin(ox, oy);
+    }
+    //Next update() redraws the whole screen (after something else printed)
+    void invalidate(){screenValid = false;}
+
+    // === composing a frame ===
+    void clear(char background = '.'){std::fill(current.begin(), current.end(), background);}
+    //Draw one world cell; cells outside the view are ignored
+    void plot(int x, int y, char c){
+        int dx = x - originX;
+        int dy = y - originY;
+        if(dx < 0 || dy < 0) return;
+        int col = dx / zoom;
+        int row = dy / zoom;
+        if(col >= viewCols || row >= viewRows) return;
+        at(col, row) = c;
+    }
+    //Blocked cells inside the view. Sparse worlds with few obstacles walk the
+    //obstacle set. Dense worlds scan the visible rows 64 cells at a time and
+    //skip the rest of a character once it is marked. Crowded sparse and chunked
+    //worlds test one cell per character (exact at zoom 1), so zooming out
+    //never costs more than the view itself.
+    void drawObstacles(const OccupancyGrid& world, char c = '#'){
+        int x0 = std::max(0, originX);
+        int y0 = std::max(0, originY);
+        int x1 = std::min(world.getWidth(), originX + spanX());
+        int y1 = std::min(world.getHeight(), originY + spanY());
+        if(x0 >= x1 || y0 >= y1) return;
+        std::size_t visible = static_cast<std::size_t>(x1 - x0) * (y1 - y0);
+        if(world.getMode() == OccupancyMode::Sparse && world.blocked() < visible){
+            world.forEachBlocked([&](int x, int y){ plot(x, y, c); });
+            return;
+        }
+        if(world.getMode() == OccupancyMode::Dense){
+            for(int y = y0; y < y1; ++y){
+                int x = world.firstBlockedInRow(y, x0, x1);
+                while(x < x1){
+                    plot(x, y, c);
+                    //start of the next character
+                    int next = originX + ((x - originX) / zoom + 1) * zoom;
+                    x = world.firstBlockedInRow(y, next, x1);
+                }
+            }
+            return;
+        }
+        for(int row = 0; row < viewRows; ++row){
+            int by = originY + row * zoom; //the character's block starts here
+            if(by + zoom <= y0 || by >= y1) continue;
+            int y = std::max(y0, std::min(by + zoom / 2, y1 - 1));
+            for(int col = 0; col < viewCols; ++col){
+                int bx = originX + col * zoom;
+                if(bx + zoom <= x0 || bx >= x1) continue;
+                if(world.isBlocked(std::max(x0, std::min(bx + zoom / 2, x1 - 1)), y)) at(col, row) = c;
+            }
+        }
+    }
+
+    // === showing a frame ===
+    //True if the terminal understands the ANSI escapes live mode sends. A Windows
+    //console only does after virtual terminal processing is switched on, which the
+    //first call does. False (old console, output not a console): use frameText().
+    static bool ansiSupported(){
+        static const bool supported = []{
+#ifdef _WIN32
+            HANDLE console = GetStdHandle(STD_OUTPUT_HANDLE);
+            DWORD mode = 0;
+            if(console == INVALID_HANDLE_VALUE || !GetConsoleMode(console, &mode)) return false;
+            if(mode & ENABLE_VIRTUAL_TERMINAL_PROCESSING) return true;
+            return SetConsoleMode(console, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING) != 0;
+#else
+            return true;
+#endif
+        }();
+        return supported;
+    }
+    //Plain text, top row first, every character followed by a space
+    std::string frameText() const {
+        std::string text;
+        text.reserve(static_cast<std::size_t>(viewCols * 2 + 1) * viewRows);
+        for(int row = viewRows - 1; row >= 0; --row){
+            for(int col = 0; col < viewCols; ++col){
+                text += current[static_cast<std::size_t>(row) * viewCols + col];
+                text += ' ';
+            }
+            text += '\n';
+        }
+        return text;
+    }
+    //Live mode, step 1: collect the characters that changed since the last frame.
+    //The frame starts on terminal row `top` (the status line is on top - 1).
+    //Returns how many grid characters will be sent.
+    std::size_t update(int top = 2){
+        out.clear();
+        statusRow = top > 1 ? top - 1 : 1;
+        parkRow = top + viewRows;
+        std::size_t changed = 0;
+        if(!screenValid){
+            out += "\x1b[2J"; //clear screen, then draw every row
+            for(int row = viewRows - 1; row >= 0; --row){
+                moveCursor(0, row, top);
+                for(int col = 0; col < viewCols; ++col){
+                    out += current[static_cast<std::size_t>(row) * viewCols + col];
+                    out += ' ';
+                }
+            }
+            changed = current.size();
+            previous = current;
+            screenValid = true;
+        }
+        else{
+            for(int row = 0; row < viewRows; ++row){
+                int cursorCol = -1; //column the cursor is at after the last write, -1 = unknown
+                for(int col = 0; col < viewCols; ++col){
+                    std::size_t i = static_cast<std::size_t>(row) * viewCols + col;
+                    if(current[i] == previous[i]) continue;
+                    if(col != cursorCol) moveCursor(col, row, top);
+                    out += current[i];
+                    out += ' ';
+                    previous[i] = current[i];
+                    cursorCol = col + 1;
+                    ++changed;
+                }
+            }
+        }
+        return changed;
+    }
+    //Live mode, step 2: add the status line and write everything with one
+    //fwrite + fflush
+    void present(const std::string& status){
+        out += "\x1b[";
+        out += std::to_string(statusRow);
+        out += ";1H";
+        out += status;
+        out += "\x1b[K"; //erase the rest of the old status
+        out += "\x1b[";
+        out += std::to_string(parkRow);
+        out += ";1H"; //park the cursor below the frame
+        std::fwrite(out.data(), 1, out.size(), stdout);
+        std::fflush(stdout);
+    }
+    //Bytes sent by the last present()
+    std::size_t lastBytes() const {return out.size();}
+};
+
+#endif
@@ -0,0 +1,95 @@
+//monotonic_arena.h
+//Bump allocator for temporaries that all die at the same moment, e.g. the
+//scratch arrays of one simulation tick. allocate() only moves a pointer;
+//nothing is freed one by one, reset() makes the whole arena reusable at once.
+//When a tick needs more than the arena holds, an extra block is added; the
+//next reset() merges everything into one block of the high-water size, so
+//after the first few ticks no tick allocates at all.
+//Only for trivial types: no constructors or destructors are run.
+#ifndef MONOTONIC_ARENA_H
+#define MONOTONIC_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+class MonotonicArena{
+    private:
+        struct Block{
+            std::unique_ptr<unsigned char[]> data;
+            std::size_t size;
+        };
+        std::vector<Block> blocks;
+        std::size_t offset = 0;   //bytes used in blocks.back()
+        std::size_t usedBefore = 0; //bytes handed out from the earlier blocks
+        std::size_t highWater = 0;
+
+        void addBlock(std::size_t atLeast){
+            std::size_t size = blocks.empty() ? 4096 : blocks.back().size * 2;
+            while(size < atLeast) size *= 2;
+            if(!blocks.empty()) usedBefore += offset;
+            blocks.push_back({std::unique_ptr<unsigned char[]>(new unsigned char[size]), size});
+            offset = 0;
+        }
+    public:
+        explicit MonotonicArena(std::size_t initialBytes = 0){
+            if(initialBytes > 0) addBlock(initialBytes);
+        }
+        MonotonicArena(const MonotonicArena&) = delete;
+        MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+    //Raw memory, `align` must be a power of two
+    void* allocate(std::size_t bytes, std::size_t align = alignof(std::max_align_t)){
+        if(!blocks.empty()){
+            Block& b = blocks.back();
+            std::uintptr_t base = reinterpret_cast<std::uintptr_t>(b.data.get());
+            std::size_t start = ((base + offset + align - 1) & ~(std::uintptr_t(align) - 1)) - base;
+            if(start + bytes <= b.size){
+                offset = start + bytes;
+                return b.data.get() + start;
+            }
+        }
+        addBlock(bytes + align);
+        return allocate(bytes, align);
+    }
+    //n uninitialised values
+    template <typename T>
+    T* allocArray(std::size_t n){
+        static_assert(std::is_trivially_destructible<T>::value, "the arena never runs destructors");
+        return static_cast<T*>(allocate(n * sizeof(T) > 0 ? n * sizeof(T) : 1, alignof(T)));
+    }
+    //n values set to all-zero bytes
+    template <typename T>
+    T* allocZeroed(std::size_t n){
+        T* p = allocArray<T>(n);
+        std::memset(static_cast<void*>(p), 0, n * sizeof(T));
+        return p;
+    }
+    //Forget everything handed out so far; earlier pointers must not be used after this
+    void reset(){
+        std::size_t used = usedBefore + offset;
+        if(used > highWater) highWater = used;
+        if(blocks.size() > 1){
+            //one block big enough for the busiest tick so far
+            std::size_t size = blocks.front().size;
+            while(size < highWater) size *= 2;
+            blocks.clear();
+            blocks.push_back({std::unique_ptr<unsigned char[]>(new unsigned char[size]), size});
+        }
+        offset = 0;
+        usedBefore = 0;
+    }
+    //Bytes handed out since the last reset()
+    std::size_t used() const {return usedBefore + offset;}
+    //Bytes owned by the arena
+    std::size_t capacity() const {
+        std::size_t total = 0;
+        for(const Block& b : blocks) total += b.size;
+        return total;
+    }
+};
+
+#endif
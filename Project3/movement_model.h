@@ -0,0 +1,80 @@
+//movement_model.h
+//Movement rules as compile-time policies.
+//Every robot kind moves the same way and differs only in how far one move goes
+//and what it costs, so a kind is one line of ROBOT_KINDS below. That list
+//makes WheeledMovement = MovementModel<1, 5> etc. here, and RobotKind, the
+//kind table and the per-kind columns in robot_fleet.h and the pool in
+//robot_sim.cpp.
+//Step and cost are template arguments and the direction table is constexpr,
+//so each kind gets its own kernel where they are plain constants. With a
+//direction known at compile time (move<Direction::Right>) the table lookup
+//disappears as well.
+//Used by the Robot classes in robot_sim.cpp and by the fleet columns in robot_fleet.h.
+#ifndef MOVEMENT_MODEL_H
+#define MOVEMENT_MODEL_H
+
+#include <cstddef>
+#include "occupancy_grid.h"
+
+enum class Direction {Up, Down, Left, Right};
+enum class MoveResult {Moved, LowBattery, Boundary, Blocked};
+const int LOW_BATTERY = 10; //no movement below this level
+
+template <int Step, int Cost>
+struct MovementModel{
+    static constexpr int STEP = Step; //cells per move
+    static constexpr int COST = Cost; //battery per move
+    //indexed by Direction: Up, Down, Left, Right
+    static constexpr int DX[4] = {0, 0, -Step, Step};
+    static constexpr int DY[4] = {Step, -Step, 0, 0};
+
+    //One move of one robot; x, y and battery change only if it moved
+    static MoveResult move(int& x, int& y, int& battery, Direction dir, const OccupancyGrid& world){
+        if(battery < LOW_BATTERY) return MoveResult::LowBattery;
+        int nx = x + DX[static_cast<int>(dir)];
+        int ny = y + DY[static_cast<int>(dir)];
+        if(!world.inBounds(nx, ny)) return MoveResult::Boundary;
+        if(world.isBlocked(nx, ny)) return MoveResult::Blocked;
+        x = nx;
+        y = ny;
+        battery -= Cost;
+        return MoveResult::Moved;
+    }
+    template <Direction Dir>
+    static MoveResult move(int& x, int& y, int& battery, const OccupancyGrid& world){
+        return move(x, y, battery, Dir, world);
+    }
+    //Every robot in the columns one move in Dir. Written without branches so the
+    //compiler can keep the loop tight. Returns how many robots moved.
+    template <Direction Dir>
+    static std::size_t moveAll(int* xs, int* ys, int* bat, std::size_t n, const OccupancyGrid& world){
+        constexpr int dx = DX[static_cast<int>(Dir)];
+        constexpr int dy = DY[static_cast<int>(Dir)];
+        std::size_t moved = 0;
+        for(std::size_t i = 0; i < n; ++i){
+            int nx = xs[i] + dx;
+            int ny = ys[i] + dy;
+            bool ok = bat[i] >= LOW_BATTERY && world.inBounds(nx, ny) && !world.isBlocked(nx, ny);
+            xs[i] = ok ? nx : xs[i];
+            ys[i] = ok ? ny : ys[i];
+            bat[i] -= ok ? Cost : 0;
+            moved += ok;
+        }
+        return moved;
+    }
+};
+
+//The robot kinds of the simulator, one X(...) per kind:
+//  X(Name, step, cost, map symbol, fleet AI)
+//The fleet AI is one of the FleetAi values in robot_fleet.h. A new kind is one
+//line here plus a NameRobot class with its interactive AI in robot_sim.cpp.
+#define ROBOT_KINDS(X) \
+    X(Wheeled, 1, 5, 'W', Right) \
+    X(Legged, 1, 10, 'L', Legged) \
+    X(Flying, 3, 18, 'F', Up)
+
+#define ROBOT_KIND_MODEL(name, step, cost, symbol, ai) using name##Movement = MovementModel<step, cost>;
+ROBOT_KINDS(ROBOT_KIND_MODEL)
+#undef ROBOT_KIND_MODEL
+
+#endif
@@ -0,0 +1,270 @@
+//occupancy_grid.h
+//Which cells of the world are blocked, answered in O(1).
+//Three storage modes:
+//  Dense   - one bit per cell, packed 64 per word (10000 x 10000 = 12.5 MB)
+//  Sparse  - open-addressing hash set of blocked cells, memory grows with the
+//            number of obstacles instead of the world area
+//  Chunked - tiles streamed from a map file (chunked_world.h), memory grows
+//            with the area around the robots; for warehouse-scale maps
+//The world size is chosen at runtime.
+#ifndef OCCUPANCY_GRID_H
+#define OCCUPANCY_GRID_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <utility>
+#include "chunked_world.h"
+
+#if defined(__GNUC__)
+#define OCCUPANCY_NOINLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define OCCUPANCY_NOINLINE __declspec(noinline)
+#else
+#define OCCUPANCY_NOINLINE
+#endif
+
+enum class OccupancyMode {Dense, Sparse, Chunked};
+
+//Hash set of 64-bit cell keys with linear probing, no per-element allocation
+class SparseCellSet{
+    private:
+        static constexpr std::uint64_t EMPTY = ~0ull;
+        static constexpr std::uint64_t ERASED = ~0ull - 1;
+        std::vector<std::uint64_t> slots; //size is always a power of two
+        std::size_t used = 0;  //live keys
+        std::size_t filled = 0; //live keys + erased markers
+
+        static std::uint64_t hash(std::uint64_t key){
+            key ^= key >> 33;
+            key *= 0xFF51AFD7ED558CCDull;
+            key ^= key >> 33;
+            return key;
+        }
+        void rehash(std::size_t newSize){
+            std::vector<std::uint64_t> old;
+            old.swap(slots);
+            slots.assign(newSize, EMPTY);
+            used = filled = 0;
+            for(std::uint64_t key : old){
+                if(key != EMPTY && key != ERASED) insert(key);
+            }
+        }
+    public:
+        SparseCellSet() : slots(16, EMPTY){}
+
+    bool contains(std::uint64_t key) const {
+        std::size_t mask = slots.size() - 1;
+        for(std::size_t i = hash(key) & mask; ; i = (i + 1) & mask){
+            if(slots[i] == key) return true;
+            if(slots[i] == EMPTY) return false;
+        }
+    }
+    //Returns true if the key was not there before
+    bool insert(std::uint64_t key){
+        if((filled + 1) * 2 > slots.size()){ //keep load factor under 1/2
+            rehash(used * 4 > slots.size() ? slots.size() * 2 : slots.size());
+        }
+        std::size_t mask = slots.size() - 1;
+        std::size_t firstErased = slots.size();
+        for(std::size_t i = hash(key) & mask; ; i = (i + 1) & mask){
+            if(slots[i] == key) return false;
+            if(slots[i] == ERASED && firstErased == slots.size()) firstErased = i;
+            if(slots[i] == EMPTY){
+                if(firstErased != slots.size()){
+                    slots[firstErased] = key; //reuse a tombstone
+                }
+                else{
+                    slots[i] = key;
+                    ++filled;
+                }
+                ++used;
+                return true;
+            }
+        }
+    }
+    //Returns true if the key was there
+    bool erase(std::uint64_t key){
+        std::size_t mask = slots.size() - 1;
+        for(std::size_t i = hash(key) & mask; ; i = (i + 1) & mask){
+            if(slots[i] == key){
+                slots[i] = ERASED;
+                --used;
+                return true;
+            }
+            if(slots[i] == EMPTY) return false;
+        }
+    }
+    void reserve(std::size_t keys){
+        std::size_t size = slots.size();
+        while(size < keys * 2) size *= 2;
+        if(size != slots.size()) rehash(size);
+    }
+    std::size_t size() const {return used;}
+    void clear(){
+        slots.assign(16, EMPTY);
+        used = filled = 0;
+    }
+    template <typename Fn>
+    void forEach(Fn fn) const {
+        for(std::uint64_t key : slots){
+            if(key != EMPTY && key != ERASED) fn(key);
+        }
+    }
+};
+
+class OccupancyGrid{
+    private:
+        int width = 0;
+        int height = 0;
+        OccupancyMode mode = OccupancyMode::Dense;
+        std::vector<std::uint64_t> bits; //dense mode
+        SparseCellSet cells;             //sparse mode
+        std::unique_ptr<ChunkedWorld> chunks; //chunked mode
+        std::size_t blockedCount = 0;
+
+        std::uint64_t key(int x, int y) const {
+            return static_cast<std::uint64_t>(y) * static_cast<std::uint64_t>(width) + static_cast<std::uint64_t>(x);
+        }
+        //Kept out of line so the tile cache code doesn't bloat the dense fast path
+        OCCUPANCY_NOINLINE bool chunkBlocked(int x, int y) const {return chunks->isBlocked(x, y);}
+    public:
+        OccupancyGrid(int w = 0, int h = 0, OccupancyMode m = OccupancyMode::Dense)
+            : width(w > 0 ? w : 0), height(h > 0 ? h : 0), mode(m){
+            if(mode == OccupancyMode::Dense){
+                std::uint64_t cellsTotal = static_cast<std::uint64_t>(width) * static_cast<std::uint64_t>(height);
+                bits.assign((cellsTotal + 63) / 64, 0);
+            }
+            if(mode == OccupancyMode::Chunked) chunks = std::make_unique<ChunkedWorld>(width, height);
+        }
+        //Chunked world, e.g. ChunkedWorld from a map file
+        explicit OccupancyGrid(std::unique_ptr<ChunkedWorld> world)
+            : width(world->getWidth()), height(world->getHeight()), mode(OccupancyMode::Chunked), chunks(std::move(world)){}
+        //Dense when the bitset is small or the map is crowded, sparse otherwise
+        static OccupancyMode chooseMode(int w, int h, std::size_t expectedObstacles){
+            std::uint64_t bitsetBytes = static_cast<std::uint64_t>(w) * static_cast<std::uint64_t>(h) / 8;
+            std::uint64_t hashBytes = static_cast<std::uint64_t>(expectedObstacles) * 2 * sizeof(std::uint64_t);
+            return (bitsetBytes <= (64u << 20) || bitsetBytes <= hashBytes) ? OccupancyMode::Dense : OccupancyMode::Sparse;
+        }
+
+    int getWidth() const {return width;}
+    int getHeight() const {return height;}
+    OccupancyMode getMode() const {return mode;}
+    std::size_t blocked() const {return chunks ? chunks->blocked() : blockedCount;}
+    //The tile store of a chunked world (tile cache, track()), nullptr otherwise
+    ChunkedWorld* chunked() {return chunks.get();}
+    const ChunkedWorld* chunked() const {return chunks.get();}
+    bool inBounds(int x, int y) const {
+        return x >= 0 && x < width && y >= 0 && y < height;
+    }
+    //Out-of-bounds cells are not obstacles; callers check inBounds() for walls
+    bool isBlocked(int x, int y) const {
+        if(!inBounds(x, y)) return false;
+        if(mode == OccupancyMode::Dense){
+            std::uint64_t k = key(x, y);
+            return (bits[k >> 6] >> (k & 63)) & 1u;
+        }
+        if(mode == OccupancyMode::Sparse) return cells.contains(key(x, y));
+        return chunkBlocked(x, y);
+    }
+    //Mark a cell blocked; returns false if out of bounds or already blocked
+    bool set(int x, int y){
+        if(!inBounds(x, y)) return false;
+        if(mode == OccupancyMode::Chunked) return chunks->set(x, y);
+        std::uint64_t k = key(x, y);
+        bool added;
+        if(mode == OccupancyMode::Dense){
+            std::uint64_t bit = 1ull << (k & 63);
+            added = (bits[k >> 6] & bit) == 0;
+            bits[k >> 6] |= bit;
+        }
+        else{
+            added = cells.insert(k);
+        }
+        if(added) ++blockedCount;
+        return added;
+    }
+    //Mark a cell free; returns false if it was not blocked
+    bool clear(int x, int y){
+        if(!inBounds(x, y)) return false;
+        if(mode == OccupancyMode::Chunked) return chunks->clear(x, y);
+        std::uint64_t k = key(x, y);
+        bool removed;
+        if(mode == OccupancyMode::Dense){
+            std::uint64_t bit = 1ull << (k & 63);
+            removed = (bits[k >> 6] & bit) != 0;
+            bits[k >> 6] &= ~bit;
+        }
+        else{
+            removed = cells.erase(k);
+        }
+        if(removed) --blockedCount;
+        return removed;
+    }
+    //Bulk versions, return how many cells actually changed
+    std::size_t insert(const std::vector<std::pair<int,int>>& list){
+        if(mode == OccupancyMode::Sparse) cells.reserve(cells.size() + list.size());
+        std::size_t changed = 0;
+        for(const auto& [x, y] : list) changed += set(x, y);
+        return changed;
+    }
+    std::size_t remove(const std::vector<std::pair<int,int>>& list){
+        std::size_t changed = 0;
+        for(const auto& [x, y] : list) changed += clear(x, y);
+        return changed;
+    }
+    void clearAll(){
+        if(mode == OccupancyMode::Dense) bits.assign(bits.size(), 0);
+        else if(mode == OccupancyMode::Chunked) chunks->clearAll();
+        else cells.clear();
+        blockedCount = 0;
+    }
+    //First blocked x in [x0, x1) of row y, or x1 if there is none.
+    //Dense worlds test 64 cells per step.
+    int firstBlockedInRow(int y, int x0, int x1) const {
+        x0 = std::max(x0, 0);
+        x1 = std::min(x1, width);
+        if(y < 0 || y >= height || x0 >= x1) return x1;
+        if(mode != OccupancyMode::Dense){
+            for(int x = x0; x < x1; ++x) if(isBlocked(x, y)) return x;
+            return x1;
+        }
+        const std::uint64_t k0 = key(x0, y);
+        const std::uint64_t k1 = key(x1 - 1, y) + 1;
+        for(std::uint64_t w = k0 >> 6; w <= (k1 - 1) >> 6; ++w){
+            std::uint64_t word = bits[w];
+            if(w == k0 >> 6) word &= ~0ull << (k0 & 63);
+            if(word){
+                std::uint64_t k = w * 64 + static_cast<std::uint64_t>(__builtin_ctzll(word));
+                return k < k1 ? static_cast<int>(k - k0) + x0 : x1;
+            }
+        }
+        return x1;
+    }
+    //Visit every blocked cell as fn(x, y)
+    template <typename Fn>
+    void forEachBlocked(Fn fn) const {
+        if(mode == OccupancyMode::Chunked){
+            chunks->forEachBlocked(fn);
+            return;
+        }
+        if(mode == OccupancyMode::Dense){
+            for(std::size_t w = 0; w < bits.size(); ++w){
+                std::uint64_t word = bits[w];
+                while(word){
+                    std::uint64_t k = w * 64 + static_cast<std::uint64_t>(__builtin_ctzll(word));
+                    fn(static_cast<int>(k % width), static_cast<int>(k / width));
+                    word &= word - 1;
+                }
+            }
+            return;
+        }
+        cells.forEach([&](std::uint64_t k){
+            fn(static_cast<int>(k % width), static_cast<int>(k / width));
+        });
+    }
+};
+
+#endif
@@ -0,0 +1,198 @@
+//parallel_tick.h
+//Multi-threaded simulation tick where robots also block each other.
+//
+//Each tick has two phases:
+//  1. propose - every robot plans its move from the state at the start of the tick
+//  2. commit  - a move is accepted only if the target cell held no robot at the
+//               start of the tick and no robot with a lower id wants the same cell
+//The commit rule only depends on ids and start-of-tick positions, never on which
+//thread looked at a robot first, so any thread count gives bit-identical results.
+//
+//For the commit phase the world is cut into square tiles. Proposals and current
+//positions are bucketed by tile, and each tile is resolved by one thread on its own.
+//
+//The phases run on a TaskScheduler (Common/task_scheduler.h), either the
+//ticker's own or one shared with the rest of the program.
+#ifndef PARALLEL_TICK_H
+#define PARALLEL_TICK_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include "robot_fleet.h"
+#include "monotonic_arena.h"
+#include "../Common/task_scheduler.h"
+
+class ParallelTicker{
+    private:
+        std::unique_ptr<TaskScheduler> ownPool; //null when the scheduler is shared
+        TaskScheduler& pool;
+        int tileSize;
+        //Everything below lives for one tick only and comes from this arena,
+        //which is reset at the start of every tick
+        MonotonicArena scratch;
+        //per-robot scratch, indexed by fleet id
+        std::int64_t* target = nullptr;   //target cell key, -1 = not moving
+        std::int32_t* targetTile = nullptr;  //tile index, -1 = none
+        std::int32_t* currentTile = nullptr;
+        std::uint32_t* targetCell = nullptr; //cell index inside its tile
+        std::uint32_t* currentCell = nullptr;
+        std::uint8_t* accepted = nullptr;
+        //bucketing by tile (counting sort)
+        std::uint32_t* moverStart = nullptr;    //tiles + 1 offsets into movers
+        std::uint32_t* occupantStart = nullptr;
+        std::uint32_t* movers = nullptr;    //ids grouped by target tile
+        std::uint32_t* occupants = nullptr; //in-tile cell of every robot, grouped by tile
+
+        int tilesX = 0;
+        int tilesY = 0;
+
+        int tileOf(int x, int y) const {
+            return (y / tileSize) * tilesX + (x / tileSize);
+        }
+        std::uint32_t cellInTile(int x, int y) const {
+            return static_cast<std::uint32_t>((y % tileSize) * tileSize + (x % tileSize));
+        }
+        //Stable counting sort of items into tile buckets, in parallel.
+        //tileFn(i) gives the tile of item i or -1 to skip it; writeFn(slot, i) stores it.
+        //Returns the tiles + 1 bucket offsets.
+        template <typename TileFn, typename WriteFn>
+        std::uint32_t* bucket(std::size_t n, TileFn tileFn, WriteFn writeFn){
+            //fixed chunks of the items, one count row each: both passes must cut
+            //the items the same way, whichever thread ends up running a chunk
+            const std::size_t chunks = pool.size();
+            const std::size_t tiles = static_cast<std::size_t>(tilesX) * tilesY;
+            std::uint32_t* counts = scratch.allocZeroed<std::uint32_t>(chunks * tiles);
+            pool.parallelFor(chunks, [&](std::size_t c0, std::size_t c1, unsigned){
+                for(std::size_t c = c0; c < c1; ++c){
+                    std::uint32_t* count = counts + c * tiles;
+                    for(std::size_t i = n * c / chunks; i < n * (c + 1) / chunks; ++i){
+                        int tile = tileFn(i);
+                        if(tile >= 0) ++count[tile];
+                    }
+                }
+            }, 1);
+            //offsets: tile-major, then chunk order (keeps the sort stable)
+            std::uint32_t* start = scratch.allocArray<std::uint32_t>(tiles + 1);
+            std::uint32_t sum = 0;
+            for(std::size_t tile = 0; tile < tiles; ++tile){
+                start[tile] = sum;
+                for(std::size_t c = 0; c < chunks; ++c){
+                    std::uint32_t count = counts[c * tiles + tile];
+                    counts[c * tiles + tile] = sum;
+                    sum += count;
+                }
+            }
+            start[tiles] = sum;
+            pool.parallelFor(chunks, [&](std::size_t c0, std::size_t c1, unsigned){
+                for(std::size_t c = c0; c < c1; ++c){
+                    std::uint32_t* offset = counts + c * tiles;
+                    for(std::size_t i = n * c / chunks; i < n * (c + 1) / chunks; ++i){
+                        int tile = tileFn(i);
+                        if(tile >= 0) writeFn(offset[tile]++, i);
+                    }
+                }
+            }, 1);
+            return start;
+        }
+    public:
+        //threads includes the calling thread, so 1 means "no extra threads"
+        explicit ParallelTicker(unsigned threads, int tile = 64)
+            : ownPool(std::make_unique<TaskScheduler>(threads)), pool(*ownPool), tileSize(tile > 0 ? tile : 64){}
+        //Run on a scheduler shared with other work
+        explicit ParallelTicker(TaskScheduler& shared, int tile = 64)
+            : pool(shared), tileSize(tile > 0 ? tile : 64){}
+
+    unsigned threadCount() const {return pool.size();}
+    //The scheduler the tick runs on, free to use between ticks
+    TaskScheduler& threadPool() {return pool;}
+
+    //One tick with robot-robot blocking. Returns how many robots moved.
+    std::size_t tick(RobotFleet& fleet, const OccupancyGrid& world){
+        const std::size_t n = fleet.size();
+        const int width = world.getWidth();
+        tilesX = (width + tileSize - 1) / tileSize;
+        tilesY = (world.getHeight() + tileSize - 1) / tileSize;
+        if(n == 0) return 0;
+        scratch.reset();
+        target = scratch.allocArray<std::int64_t>(n);
+        targetTile = scratch.allocArray<std::int32_t>(n);
+        currentTile = scratch.allocArray<std::int32_t>(n);
+        targetCell = scratch.allocArray<std::uint32_t>(n);
+        currentCell = scratch.allocArray<std::uint32_t>(n);
+        accepted = scratch.allocZeroed<std::uint8_t>(n);
+
+        //phase 1: propose
+        pool.parallelFor(n, [&](std::size_t begin, std::size_t end, unsigned){
+            for(std::size_t i = begin; i < end; ++i){
+                std::uint32_t id = static_cast<std::uint32_t>(i);
+                int nx, ny;
+                int x = fleet.getX(id);
+                int y = fleet.getY(id);
+                bool ok = planMove(fleet.kind(id), x, y, fleet.getBattery(id), world, nx, ny);
+                target[i] = ok ? static_cast<std::int64_t>(ny) * width + nx : -1;
+                targetTile[i] = ok ? tileOf(nx, ny) : -1;
+                targetCell[i] = ok ? cellInTile(nx, ny) : 0;
+                bool inside = world.inBounds(x, y);
+                currentTile[i] = inside ? tileOf(x, y) : -1;
+                currentCell[i] = inside ? cellInTile(x, y) : 0;
+            }
+        });
+
+        //bucket movers by target tile and every robot's current cell by tile
+        movers = scratch.allocArray<std::uint32_t>(n);
+        moverStart = bucket(n,
+               [&](std::size_t i){ return targetTile[i]; },
+               [&](std::uint32_t slot, std::size_t i){ movers[slot] = static_cast<std::uint32_t>(i); });
+        occupants = scratch.allocArray<std::uint32_t>(n);
+        occupantStart = bucket(n,
+               [&](std::size_t i){ return currentTile[i]; },
+               [&](std::uint32_t slot, std::size_t i){ occupants[slot] = currentCell[i]; });
+
+        //phase 2: commit, one tile at a time. Each thread marks cells in a
+        //tileSize x tileSize scratch array: OCCUPIED, or lowest claiming id + 1.
+        const std::size_t tiles = static_cast<std::size_t>(tilesX) * tilesY;
+        const std::uint32_t OCCUPIED = ~0u;
+        const std::size_t cellsPerTile = static_cast<std::size_t>(tileSize) * tileSize;
+        std::uint32_t* cells = scratch.allocZeroed<std::uint32_t>(cellsPerTile * pool.size());
+        pool.parallelFor(tiles, [&](std::size_t begin, std::size_t end, unsigned t){
+            std::uint32_t* cell = cells + t * cellsPerTile;
+            for(std::size_t tile = begin; tile < end; ++tile){
+                if(moverStart[tile] == moverStart[tile + 1]) continue;
+                for(std::uint32_t k = occupantStart[tile]; k < occupantStart[tile + 1]; ++k){
+                    cell[occupants[k]] = OCCUPIED;
+                }
+                for(std::uint32_t k = moverStart[tile]; k < moverStart[tile + 1]; ++k){
+                    std::uint32_t& c = cell[targetCell[movers[k]]];
+                    if(c != OCCUPIED && (c == 0 || movers[k] + 1 < c)) c = movers[k] + 1;
+                }
+                for(std::uint32_t k = moverStart[tile]; k < moverStart[tile + 1]; ++k){
+                    accepted[movers[k]] = cell[targetCell[movers[k]]] == movers[k] + 1;
+                }
+                //reset only the cells we touched
+                for(std::uint32_t k = occupantStart[tile]; k < occupantStart[tile + 1]; ++k) cell[occupants[k]] = 0;
+                for(std::uint32_t k = moverStart[tile]; k < moverStart[tile + 1]; ++k) cell[targetCell[movers[k]]] = 0;
+            }
+        });
+
+        //apply
+        std::size_t* movedPerThread = scratch.allocZeroed<std::size_t>(pool.size());
+        pool.parallelFor(n, [&](std::size_t begin, std::size_t end, unsigned t){
+            for(std::size_t i = begin; i < end; ++i){
+                if(!accepted[i]) continue;
+                std::uint32_t id = static_cast<std::uint32_t>(i);
+                int cost = kindRules(fleet.kind(id)).cost;
+                fleet.setState(id, static_cast<int>(target[i] % width), static_cast<int>(target[i] / width),
+                               fleet.getBattery(id) - cost);
+                ++movedPerThread[t];
+            }
+        });
+        std::size_t moved = 0;
+        for(unsigned t = 0; t < pool.size(); ++t) moved += movedPerThread[t];
+        return moved;
+    }
+};
+
+#endif
@@ -0,0 +1,348 @@
+//path_planner.h
+//Goal-directed planning on the occupancy grid.
+//
+//A robot with step size s moves s cells up/down/left/right per move and only
+//the landing cell has to be free (a FlyingRobot jumps 3 cells over obstacles).
+//
+//  findPath()       single query: A* with Jump Point Search. Straight runs are
+//                   scanned without pushing every cell into the open list.
+//  DistanceField    BFS from a goal over the whole grid: distance (in moves) from
+//                   every cell. Any number of robots heading to the same goal share one.
+//  PathPlanner      owns a small cache of fields (least recently used is dropped)
+//                   and repairs cached fields locally when an obstacle is added or
+//                   removed, instead of throwing them away.
+#ifndef PATH_PLANNER_H
+#define PATH_PLANNER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>   // for std::abs
+#include <vector>
+#include <deque>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+#include <algorithm>
+#include "occupancy_grid.h"
+
+const std::uint32_t UNREACHABLE = ~0u;
+
+//Cells a robot can stand on
+inline bool walkable(const OccupancyGrid& world, int x, int y){
+    return world.inBounds(x, y) && !world.isBlocked(x, y);
+}
+
+//=== A* + Jump Point Search (4-connected, any step size) ===
+class JumpPointSearch{
+    private:
+        const OccupancyGrid& world;
+        int s; //step size
+        int goalX, goalY;
+
+        bool free(int x, int y) const {return walkable(world, x, y);}
+        //Scan horizontally; stop at the goal or where a vertical move becomes
+        //necessary (the cell behind us above/below was blocked, this one is free)
+        bool jumpHorizontal(int x, int y, int dx, int& jx, int& jy) const {
+            while(true){
+                int px = x;
+                x += dx * s;
+                if(!free(x, y)) return false;
+                if(x == goalX && y == goalY) break;
+                if(free(x, y + s) && !free(px, y + s)) break;
+                if(free(x, y - s) && !free(px, y - s)) break;
+            }
+            jx = x;
+            jy = y;
+            return true;
+        }
+        //Scan vertically; stop at the goal or wherever a horizontal scan finds something
+        bool jumpVertical(int x, int y, int dy, int& jx, int& jy) const {
+            int hx, hy;
+            while(true){
+                y += dy * s;
+                if(!free(x, y)) return false;
+                if(x == goalX && y == goalY) break;
+                if(jumpHorizontal(x, y, 1, hx, hy) || jumpHorizontal(x, y, -1, hx, hy)) break;
+            }
+            jx = x;
+            jy = y;
+            return true;
+        }
+        std::uint64_t key(int x, int y) const {
+            return static_cast<std::uint64_t>(y) * static_cast<std::uint64_t>(world.getWidth()) + static_cast<std::uint64_t>(x);
+        }
+        int heuristic(int x, int y) const {
+            return (std::abs(x - goalX) + std::abs(y - goalY)) / s;
+        }
+    public:
+        JumpPointSearch(const OccupancyGrid& w, int step) : world(w), s(step > 0 ? step : 1), goalX(0), goalY(0){}
+
+    //Every cell visited, start first and goal last; empty if there is no path
+    std::vector<std::pair<int,int>> findPath(int sx, int sy, int gx, int gy){
+        goalX = gx;
+        goalY = gy;
+        std::vector<std::pair<int,int>> path;
+        if(!free(sx, sy) || !free(gx, gy)) return path;
+        if((gx - sx) % s != 0 || (gy - sy) % s != 0) return path; //never lands on the goal
+        struct Node{
+            int f, g, x, y, dx, dy;
+            bool operator>(const Node& o) const {return f != o.f ? f > o.f : g < o.g;}
+        };
+        struct Visit{
+            int g;
+            std::uint64_t parent;
+        };
+        std::priority_queue<Node, std::vector<Node>, std::greater<Node>> open;
+        std::unordered_map<std::uint64_t, Visit> seen;
+        seen[key(sx, sy)] = {0, key(sx, sy)};
+        open.push({heuristic(sx, sy), 0, sx, sy, 0, 0});
+        bool found = false;
+        while(!open.empty()){
+            Node n = open.top();
+            open.pop();
+            if(n.g > seen[key(n.x, n.y)].g) continue; //stale entry
+            if(n.x == gx && n.y == gy){
+                found = true;
+                break;
+            }
+            //pruned directions: from the start all four, after a vertical move keep
+            //going vertically or turn, after a horizontal move only go on or take a forced turn
+            int dirs[4][2];
+            int count = 0;
+            auto add = [&](int dx, int dy){ dirs[count][0] = dx; dirs[count][1] = dy; ++count; };
+            if(n.dx == 0 && n.dy == 0){
+                add(1, 0); add(-1, 0); add(0, 1); add(0, -1);
+            }
+            else if(n.dy != 0){
+                add(0, n.dy); add(1, 0); add(-1, 0);
+            }
+            else{
+                add(n.dx, 0);
+                int px = n.x - n.dx * s;
+                if(free(n.x, n.y + s) && !free(px, n.y + s)) add(0, 1);
+                if(free(n.x, n.y - s) && !free(px, n.y - s)) add(0, -1);
+            }
+            for(int d = 0; d < count; ++d){
+                int jx, jy;
+                bool ok = dirs[d][1] == 0 ? jumpHorizontal(n.x, n.y, dirs[d][0], jx, jy)
+                                          : jumpVertical(n.x, n.y, dirs[d][1], jx, jy);
+                if(!ok) continue;
+                int g = n.g + (std::abs(jx - n.x) + std::abs(jy - n.y)) / s;
+                auto it = seen.find(key(jx, jy));
+                if(it != seen.end() && it->second.g <= g) continue;
+                seen[key(jx, jy)] = {g, key(n.x, n.y)};
+                open.push({g + heuristic(jx, jy), g, jx, jy, dirs[d][0], dirs[d][1]});
+            }
+        }
+        if(!found) return path;
+        //walk back over the jump points, filling in every single move
+        const int width = world.getWidth();
+        std::uint64_t k = key(gx, gy);
+        path.push_back({gx, gy});
+        while(k != key(sx, sy)){
+            std::uint64_t parent = seen[k].parent;
+            int x = static_cast<int>(k % width);
+            int y = static_cast<int>(k / width);
+            int px = static_cast<int>(parent % width);
+            int py = static_cast<int>(parent / width);
+            int dx = (px > x) - (px < x);
+            int dy = (py > y) - (py < y);
+            while(x != px || y != py){
+                x += dx * s;
+                y += dy * s;
+                path.push_back({x, y});
+            }
+            k = parent;
+        }
+        std::reverse(path.begin(), path.end());
+        return path;
+    }
+};
+
+//Convenience wrapper
+inline std::vector<std::pair<int,int>> findPath(const OccupancyGrid& world, int sx, int sy, int gx, int gy, int step = 1){
+    JumpPointSearch search(world, step);
+    return search.findPath(sx, sy, gx, gy);
+}
+
+//=== Distance fields ===
+struct DistanceField{
+    int goalX = 0;
+    int goalY = 0;
+    int step = 1;
+    int width = 0;
+    int height = 0;
+    std::vector<std::uint32_t> dist; //moves to the goal, UNREACHABLE if none
+    std::uint64_t lastUse = 0;
+
+    std::uint32_t at(int x, int y) const {
+        if(x < 0 || x >= width || y < 0 || y >= height) return UNREACHABLE;
+        return dist[static_cast<std::size_t>(y) * width + x];
+    }
+};
+
+class PathPlanner{
+    private:
+        OccupancyGrid& world;
+        std::size_t capacity;
+        std::vector<DistanceField> fields;
+        std::uint64_t clock = 0;
+        static constexpr int DX[4] = {1, -1, 0, 0};
+        static constexpr int DY[4] = {0, 0, 1, -1};
+
+        std::size_t index(const DistanceField& f, int x, int y) const {
+            return static_cast<std::size_t>(y) * f.width + x;
+        }
+        void build(DistanceField& f){
+            f.width = world.getWidth();
+            f.height = world.getHeight();
+            f.dist.assign(static_cast<std::size_t>(f.width) * f.height, UNREACHABLE);
+            if(!walkable(world, f.goalX, f.goalY)) return;
+            std::deque<std::pair<int,int>> queue;
+            f.dist[index(f, f.goalX, f.goalY)] = 0;
+            queue.push_back({f.goalX, f.goalY});
+            relax(f, queue);
+        }
+        //BFS from the cells in the queue, lowering distances where possible
+        void relax(DistanceField& f, std::deque<std::pair<int,int>>& queue){
+            while(!queue.empty()){
+                auto [x, y] = queue.front();
+                queue.pop_front();
+                std::uint32_t next = f.dist[index(f, x, y)] + 1;
+                for(int d = 0; d < 4; ++d){
+                    int nx = x + DX[d] * f.step;
+                    int ny = y + DY[d] * f.step;
+                    if(!walkable(world, nx, ny)) continue;
+                    std::uint32_t& nd = f.dist[index(f, nx, ny)];
+                    if(next < nd){
+                        nd = next;
+                        queue.push_back({nx, ny});
+                    }
+                }
+            }
+        }
+        //Obstacle added at (cx, cy): drop the distances that depended on it,
+        //then refill just that region from its still-valid border
+        void repairAfterBlock(DistanceField& f, int cx, int cy){
+            std::uint32_t old = f.at(cx, cy);
+            if(old == UNREACHABLE) return;
+            f.dist[index(f, cx, cy)] = UNREACHABLE;
+            std::vector<std::pair<int,int>> lost;
+            std::deque<std::pair<int,int>> check;
+            for(int d = 0; d < 4; ++d) check.push_back({cx + DX[d] * f.step, cy + DY[d] * f.step});
+            while(!check.empty()){
+                auto [x, y] = check.front();
+                check.pop_front();
+                std::uint32_t dxy = f.at(x, y);
+                if(dxy == UNREACHABLE || dxy == 0) continue;
+                bool supported = false;
+                for(int d = 0; d < 4 && !supported; ++d){
+                    supported = f.at(x + DX[d] * f.step, y + DY[d] * f.step) == dxy - 1;
+                }
+                if(supported) continue;
+                f.dist[index(f, x, y)] = UNREACHABLE;
+                lost.push_back({x, y});
+                for(int d = 0; d < 4; ++d){
+                    int nx = x + DX[d] * f.step;
+                    int ny = y + DY[d] * f.step;
+                    if(f.at(nx, ny) == dxy + 1) check.push_back({nx, ny});
+                }
+            }
+            //reseed the lost cells from their valid neighbours, closest first
+            using Entry = std::pair<std::uint32_t, std::pair<int,int>>;
+            std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> seeds;
+            for(auto [x, y] : lost){
+                std::uint32_t best = UNREACHABLE;
+                for(int d = 0; d < 4; ++d){
+                    std::uint32_t nd = f.at(x + DX[d] * f.step, y + DY[d] * f.step);
+                    if(nd != UNREACHABLE && nd + 1 < best) best = nd + 1;
+                }
+                if(best != UNREACHABLE) seeds.push({best, {x, y}});
+            }
+            while(!seeds.empty()){
+                auto [value, cell] = seeds.top();
+                seeds.pop();
+                std::uint32_t& cur = f.dist[index(f, cell.first, cell.second)];
+                if(value >= cur) continue;
+                cur = value;
+                for(int d = 0; d < 4; ++d){
+                    int nx = cell.first + DX[d] * f.step;
+                    int ny = cell.second + DY[d] * f.step;
+                    if(walkable(world, nx, ny) && value + 1 < f.at(nx, ny)) seeds.push({value + 1, {nx, ny}});
+                }
+            }
+        }
+        //Obstacle removed at (cx, cy): distances can only go down, spread from there
+        void repairAfterClear(DistanceField& f, int cx, int cy){
+            if(cx == f.goalX && cy == f.goalY){
+                build(f); //the goal itself came back
+                return;
+            }
+            std::uint32_t best = UNREACHABLE;
+            for(int d = 0; d < 4; ++d){
+                std::uint32_t nd = f.at(cx + DX[d] * f.step, cy + DY[d] * f.step);
+                if(nd != UNREACHABLE && nd + 1 < best) best = nd + 1;
+            }
+            if(best == UNREACHABLE) return;
+            f.dist[index(f, cx, cy)] = best;
+            std::deque<std::pair<int,int>> queue;
+            queue.push_back({cx, cy});
+            relax(f, queue);
+        }
+    public:
+        PathPlanner(OccupancyGrid& w, std::size_t maxFields = 8) : world(w), capacity(maxFields > 0 ? maxFields : 1){}
+
+    //Shared distance field for (goal, step); built once, then reused
+    const DistanceField& field(int goalX, int goalY, int step = 1){
+        for(auto& f : fields){
+            if(f.goalX == goalX && f.goalY == goalY && f.step == step
+               && f.width == world.getWidth() && f.height == world.getHeight()){
+                f.lastUse = ++clock;
+                return f;
+            }
+        }
+        if(fields.size() >= capacity){ //drop the least recently used field
+            auto oldest = std::min_element(fields.begin(), fields.end(),
+                [](const DistanceField& a, const DistanceField& b){ return a.lastUse < b.lastUse; });
+            fields.erase(oldest);
+        }
+        fields.emplace_back();
+        DistanceField& f = fields.back();
+        f.goalX = goalX;
+        f.goalY = goalY;
+        f.step = step > 0 ? step : 1;
+        f.lastUse = ++clock;
+        build(f);
+        return f;
+    }
+    //Best next move from (x, y) towards the goal: fills dx, dy in {-1, 0, 1}.
+    //Returns false if the robot is at the goal or can't reach it.
+    bool nextMove(int x, int y, int goalX, int goalY, int step, int& dx, int& dy){
+        const DistanceField& f = field(goalX, goalY, step);
+        std::uint32_t here = f.at(x, y);
+        if(here == 0 || here == UNREACHABLE) return false;
+        for(int d = 0; d < 4; ++d){
+            if(f.at(x + DX[d] * f.step, y + DY[d] * f.step) == here - 1){
+                dx = DX[d];
+                dy = DY[d];
+                return true;
+            }
+        }
+        return false;
+    }
+    //Change the world through the planner so cached fields stay correct
+    bool addObstacle(int x, int y){
+        if(!world.set(x, y)) return false;
+        for(auto& f : fields) repairAfterBlock(f, x, y);
+        return true;
+    }
+    bool removeObstacle(int x, int y){
+        if(!world.clear(x, y)) return false;
+        for(auto& f : fields) repairAfterClear(f, x, y);
+        return true;
+    }
+    std::size_t cachedFields() const {return fields.size();}
+    void clearCache(){fields.clear();}
+};
+
+#endif
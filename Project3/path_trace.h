@@ -0,0 +1,293 @@
+//path_trace.h
+//Compact path history for robots.
+//A std::vector<std::pair<int,int>> costs 8 bytes per position. Robots only move
+//one axis at a time by 1 or 3 cells, so every step fits in a 4-bit code:
+//  0 stay   1 right   2 left   3 up   4 down       (1 cell)
+//           5 right   6 left   7 up   8 down       (3 cells)
+//  15 jump: the next 16 codes hold the new x and y as raw 32-bit values
+//Codes are packed two per byte into fixed-size blocks taken from a shared
+//PathArena, so many robots share a few big allocations.
+//Every KEY_EVERY positions a keyframe stores the absolute position and where
+//its codes start, so at(i) decodes at most KEY_EVERY codes.
+//
+//Trace file (streaming export, native little-endian):
+//  PathTraceFileHeader                 magic "PTRACE1", keyframe spacing
+//  chunk: PathTraceChunk               trace id, first index, its position, code count
+//         uint8_t codes[(n + 1) / 2]   same 4-bit codes as in memory
+//  chunk: ...
+//Each export writes only the positions added since the previous export.
+//A trace id belongs to one path: a robot that starts over (PathTrace::clear)
+//must export under a new id, because a trace only ever grows.
+#ifndef PATH_TRACE_H
+#define PATH_TRACE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <fstream>
+
+//Fixed-size blocks shared by all traces; freed blocks are reused
+class PathArena{
+    private:
+        std::size_t blockBytes;
+        std::vector<std::unique_ptr<std::uint8_t[]>> blocks;
+        std::vector<std::uint32_t> freeList;
+    public:
+        explicit PathArena(std::size_t bytesPerBlock = 256) : blockBytes(bytesPerBlock){}
+        PathArena(const PathArena&) = delete;
+        PathArena& operator=(const PathArena&) = delete;
+
+    std::size_t blockSize() const {return blockBytes;}
+    std::uint32_t allocate(){
+        if(!freeList.empty()){
+            std::uint32_t id = freeList.back();
+            freeList.pop_back();
+            return id;
+        }
+        blocks.emplace_back(new std::uint8_t[blockBytes]());
+        return static_cast<std::uint32_t>(blocks.size() - 1);
+    }
+    void release(std::uint32_t id){freeList.push_back(id);}
+    std::uint8_t* data(std::uint32_t id) const {return blocks[id].get();}
+    //Bytes held by the arena, used or free
+    std::size_t reservedBytes() const {return blocks.size() * blockBytes;}
+};
+
+class PathTraceFile;
+
+class PathTrace{
+    public:
+        static constexpr std::size_t KEY_EVERY = 1024;
+        static constexpr std::uint8_t CODE_STAY = 0;
+        static constexpr std::uint8_t CODE_JUMP = 15;
+    private:
+        struct Keyframe{
+            std::uint64_t code; //index of the first code after this position
+            int x;
+            int y;
+        };
+        PathArena* arena;
+        std::vector<std::uint32_t> blocks;
+        std::vector<Keyframe> keys;
+        std::uint64_t codes = 0;     //codes written
+        std::size_t count = 0;       //positions stored
+        int lastX = 0;
+        int lastY = 0;
+        std::size_t exported = 0;    //positions already in the trace file
+        std::uint64_t exportedCode = 0;
+
+        void putCode(std::uint8_t c){
+            std::size_t perBlock = arena->blockSize() * 2;
+            if(codes / perBlock >= blocks.size()) blocks.push_back(arena->allocate());
+            std::uint8_t* block = arena->data(blocks[codes / perBlock]);
+            std::size_t inBlock = codes % perBlock;
+            std::uint8_t& byte = block[inBlock / 2];
+            byte = (inBlock & 1) ? static_cast<std::uint8_t>((byte & 0x0F) | (c << 4))
+                                 : static_cast<std::uint8_t>((byte & 0xF0) | c);
+            ++codes;
+        }
+        std::uint8_t getCode(std::uint64_t i) const {
+            std::size_t perBlock = arena->blockSize() * 2;
+            const std::uint8_t* block = arena->data(blocks[i / perBlock]);
+            std::size_t inBlock = i % perBlock;
+            return (block[inBlock / 2] >> ((inBlock & 1) * 4)) & 0x0F;
+        }
+        void putRaw(std::uint32_t value){
+            for(int k = 0; k < 8; ++k) putCode(static_cast<std::uint8_t>((value >> (k * 4)) & 0x0F));
+        }
+        static std::uint8_t encode(int dx, int dy){
+            if(dy == 0){
+                if(dx == 0) return CODE_STAY;
+                if(dx == 1) return 1;
+                if(dx == -1) return 2;
+                if(dx == 3) return 5;
+                if(dx == -3) return 6;
+            }
+            else if(dx == 0){
+                if(dy == 1) return 3;
+                if(dy == -1) return 4;
+                if(dy == 3) return 7;
+                if(dy == -3) return 8;
+            }
+            return CODE_JUMP;
+        }
+    public:
+        //Apply the code at position `i` of the stream to (x, y); returns the next code index
+        template <typename CodeAt>
+        static std::uint64_t decodeStep(CodeAt codeAt, std::uint64_t i, int& x, int& y){
+            static const int DX[9] = {0, 1, -1, 0, 0, 3, -3, 0, 0};
+            static const int DY[9] = {0, 0, 0, 1, -1, 0, 0, 3, -3};
+            std::uint8_t c = codeAt(i);
+            if(c == CODE_JUMP){
+                std::uint32_t rx = 0, ry = 0;
+                for(int k = 0; k < 8; ++k) rx |= static_cast<std::uint32_t>(codeAt(i + 1 + k)) << (k * 4);
+                for(int k = 0; k < 8; ++k) ry |= static_cast<std::uint32_t>(codeAt(i + 9 + k)) << (k * 4);
+                x = static_cast<int>(rx);
+                y = static_cast<int>(ry);
+                return i + 17;
+            }
+            if(c < 9){
+                x += DX[c];
+                y += DY[c];
+            }
+            return i + 1;
+        }
+
+        explicit PathTrace(PathArena& a) : arena(&a){}
+        ~PathTrace(){clear();}
+        PathTrace(const PathTrace&) = delete;
+        PathTrace& operator=(const PathTrace&) = delete;
+
+    //Append a position (the first one is the start)
+    void push(int x, int y){
+        if(count > 0){
+            std::uint8_t c = encode(x - lastX, y - lastY);
+            putCode(c);
+            if(c == CODE_JUMP){
+                putRaw(static_cast<std::uint32_t>(x));
+                putRaw(static_cast<std::uint32_t>(y));
+            }
+        }
+        if(count % KEY_EVERY == 0) keys.push_back({codes, x, y});
+        lastX = x;
+        lastY = y;
+        ++count;
+    }
+    std::size_t size() const {return count;}
+    bool empty() const {return count == 0;}
+    std::pair<int,int> back() const {return {lastX, lastY};}
+    //Position i, decoding from the nearest keyframe before it
+    std::pair<int,int> at(std::size_t i) const {
+        const Keyframe& key = keys[i / KEY_EVERY];
+        int x = key.x;
+        int y = key.y;
+        std::uint64_t c = key.code;
+        auto codeAt = [this](std::uint64_t k){ return getCode(k); };
+        for(std::size_t j = i - i % KEY_EVERY; j < i; ++j) c = decodeStep(codeAt, c, x, y);
+        return {x, y};
+    }
+    //Visit positions [from, size()) in order as fn(x, y)
+    template <typename Fn>
+    void forEach(Fn fn, std::size_t from = 0) const {
+        if(from >= count) return;
+        const std::size_t start = from - from % KEY_EVERY;
+        const Keyframe& key = keys[start / KEY_EVERY];
+        int x = key.x;
+        int y = key.y;
+        std::uint64_t c = key.code;
+        auto codeAt = [this](std::uint64_t k){ return getCode(k); };
+        for(std::size_t i = start; i < count; ++i){
+            if(i > start) c = decodeStep(codeAt, c, x, y);
+            if(i >= from) fn(x, y);
+        }
+    }
+    void clear(){
+        for(std::uint32_t id : blocks) arena->release(id);
+        blocks.clear();
+        keys.clear();
+        codes = 0;
+        count = 0;
+        exported = 0;
+        exportedCode = 0;
+    }
+    //Memory used by this trace (blocks + keyframes), compare with size() * 8
+    std::size_t bytesUsed() const {
+        return blocks.size() * arena->blockSize() + keys.capacity() * sizeof(Keyframe);
+    }
+    //Append the positions added since the last call to a trace file
+    void exportTo(PathTraceFile& file, std::uint32_t robotId);
+};
+
+struct PathTraceFileHeader{
+    char magic[8];          // "PTRACE1\0"
+    std::uint32_t keyEvery; // keyframe spacing used by the writer (information only)
+    std::uint32_t reserved;
+};
+struct PathTraceChunk{
+    std::uint32_t magic;      // "PCHK"
+    std::uint32_t robot;      // trace id (one per robot life)
+    std::uint64_t firstIndex; // index of the position below (0 = start of the path)
+    std::int32_t x;
+    std::int32_t y;
+    std::uint64_t codeCount;  // 4-bit codes after the header, two per byte
+};
+const std::uint32_t PATH_CHUNK_MAGIC = 0x4B484350; // "PCHK"
+
+//Streaming writer: chunks are appended as robots move
+class PathTraceFile{
+    private:
+        std::ofstream out;
+        std::uint64_t bytes = 0;
+    public:
+        explicit PathTraceFile(const std::string& path) : out(path, std::ios::binary | std::ios::trunc){
+            PathTraceFileHeader header{};
+            std::memcpy(header.magic, "PTRACE1", 8);
+            header.keyEvery = static_cast<std::uint32_t>(PathTrace::KEY_EVERY);
+            write(&header, sizeof(header));
+        }
+    bool isOpen() const {return out.is_open();}
+    void write(const void* data, std::size_t size){
+        out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        bytes += size;
+    }
+    void flush(){out.flush();}
+    std::uint64_t bytesWritten() const {return bytes;}
+};
+
+inline void PathTrace::exportTo(PathTraceFile& file, std::uint32_t robotId){
+    if(count == 0 || exported == count) return;
+    //the chunk restarts from the last exported position, or from the start
+    std::size_t first = exported > 0 ? exported - 1 : 0;
+    std::pair<int,int> start = at(first);
+    PathTraceChunk chunk{};
+    chunk.magic = PATH_CHUNK_MAGIC;
+    chunk.robot = robotId;
+    chunk.firstIndex = first;
+    chunk.x = start.first;
+    chunk.y = start.second;
+    chunk.codeCount = codes - exportedCode;
+    std::vector<std::uint8_t> packed((chunk.codeCount + 1) / 2, 0);
+    for(std::uint64_t i = 0; i < chunk.codeCount; ++i){
+        packed[i / 2] |= static_cast<std::uint8_t>(getCode(exportedCode + i) << ((i & 1) * 4));
+    }
+    file.write(&chunk, sizeof(chunk));
+    if(!packed.empty()) file.write(packed.data(), packed.size());
+    exported = count;
+    exportedCode = codes;
+}
+
+//Read a trace file back; traces[id] gets every position of trace id.
+//Returns false if the file is missing or damaged (traces read so far are kept).
+inline bool loadPathTraces(const std::string& path, PathArena& arena, std::vector<std::unique_ptr<PathTrace>>& traces){
+    std::ifstream in(path, std::ios::binary);
+    PathTraceFileHeader header;
+    if(!in.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, "PTRACE1", 8) != 0){
+        return false;
+    }
+    PathTraceChunk chunk;
+    std::vector<std::uint8_t> packed;
+    while(in.read(reinterpret_cast<char*>(&chunk), sizeof(chunk))){
+        if(chunk.magic != PATH_CHUNK_MAGIC) return false;
+        packed.resize((chunk.codeCount + 1) / 2);
+        if(!packed.empty() && !in.read(reinterpret_cast<char*>(packed.data()), packed.size())) return false;
+        while(traces.size() <= chunk.robot) traces.push_back(std::make_unique<PathTrace>(arena));
+        PathTrace& trace = *traces[chunk.robot];
+        if(chunk.firstIndex == 0 && trace.empty()) trace.push(chunk.x, chunk.y);
+        else if(chunk.firstIndex + 1 != trace.size()) return false; //chunks out of order
+        int x = chunk.x;
+        int y = chunk.y;
+        auto codeAt = [&](std::uint64_t i) -> std::uint8_t { return (packed[i / 2] >> ((i & 1) * 4)) & 0x0F; };
+        std::uint64_t i = 0;
+        while(i < chunk.codeCount){
+            i = PathTrace::decodeStep(codeAt, i, x, y);
+            trace.push(x, y);
+        }
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,411 @@
+//proximity_grid.h
+//Broadphase index over robot positions: "which robots are near this point?"
+//without checking every pair.
+//
+//Space is cut into square cells of cellSize x cellSize world cells (a power of
+//two, so finding a robot's cell is a shift, not a division). build()
+//counting-sorts the robots by cell into one flat array, so the robots of a
+//cell sit next to each other and a query only reads the few cells around it.
+//The cell table covers the box around the robots, row by row, so one row of a
+//query is one contiguous run. When that box has far more cells than there are
+//robots (a few robots in a huge world), cells are found through a hash table
+//sized to the robot count instead, so memory never grows with the world.
+//Rebuilding every tick is a few linear passes over the robots. That is cheaper
+//than tracking moves, because most robots change position every tick.
+//
+//Queries (distances are Euclidean, in world cells):
+//  robotsAt()        - robots on one exact cell
+//  forEachInRadius() - every robot within r of a point
+//  nearest()         - the k closest robots to a point
+//  radiusAll(), nearestAll() - the same for every indexed robot at once,
+//                      optionally spread over a TaskScheduler
+//Results are ordered by (distance, id), so ties and thread counts never change them.
+#ifndef PROXIMITY_GRID_H
+#define PROXIMITY_GRID_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "robot_fleet.h"
+#include "parallel_tick.h"
+
+//One robot found by a query
+struct ProximityHit{
+    std::int64_t dist2; //squared distance to the query point
+    std::uint32_t id;
+    bool operator<(const ProximityHit& o) const {
+        return dist2 != o.dist2 ? dist2 < o.dist2 : id < o.id;
+    }
+};
+
+//Results of a batch query, one list per query (compressed rows):
+//the hits of query q are hits[start[q] .. start[q + 1])
+struct ProximityResult{
+    std::vector<std::uint32_t> start;
+    std::vector<ProximityHit> hits;
+
+    std::size_t queries() const {return start.empty() ? 0 : start.size() - 1;}
+    std::size_t count(std::size_t q) const {return start[q + 1] - start[q];}
+    const ProximityHit* begin(std::size_t q) const {return hits.data() + start[q];}
+    const ProximityHit* end(std::size_t q) const {return hits.data() + start[q + 1];}
+};
+
+class ProximityGrid{
+    private:
+        int cellBits = 0;
+        int cellSize = 1;
+        bool hashed = false;    //false = row-major table over the cell box
+        unsigned tableBits = 0; //hashed: log2 of the table size
+        std::size_t cols = 0;   //row-major: cells per row
+        std::vector<std::uint32_t> bucketStart; //table size + 1 offsets into the sorted arrays
+        //robots sorted by bucket (stable, so by id inside a bucket)
+        std::vector<int> sortedX;
+        std::vector<int> sortedY;
+        std::vector<std::uint32_t> sortedId;
+        std::vector<std::uint64_t> sortedCell; //hashed: packed cell, tells apart cells sharing a bucket
+        //positions by id, for the batch queries
+        std::vector<int> posX;
+        std::vector<int> posY;
+        std::vector<std::uint32_t> bucketOf; //build scratch
+        int minCellX = 0, maxCellX = -1;
+        int minCellY = 0, maxCellY = -1;
+
+        int cellOf(int v) const {return v >> cellBits;} //arithmetic shift = floor division
+        static std::uint64_t packCell(int cx, int cy){
+            return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(cx)) << 32) | static_cast<std::uint32_t>(cy);
+        }
+        std::uint32_t bucket(int cx, int cy) const {
+            if(!hashed) return static_cast<std::uint32_t>(static_cast<std::size_t>(cy - minCellY) * cols + (cx - minCellX));
+            std::uint64_t h = static_cast<std::uint64_t>(static_cast<std::uint32_t>(cx)) * 0x9E3779B97F4A7C15ull
+                            ^ static_cast<std::uint64_t>(static_cast<std::uint32_t>(cy)) * 0xC2B2AE3D27D4EB4Full;
+            return static_cast<std::uint32_t>(h >> (64 - tableBits));
+        }
+        static std::int64_t distance2(int ax, int ay, int bx, int by){
+            std::int64_t dx = static_cast<std::int64_t>(ax) - bx;
+            std::int64_t dy = static_cast<std::int64_t>(ay) - by;
+            return dx * dx + dy * dy;
+        }
+        //Visit fn(slot) for every robot stored in cells cx0..cx1 of row cy
+        template <typename Fn>
+        void forEachInRow(int cy, int cx0, int cx1, Fn&& fn) const {
+            if(cy < minCellY || cy > maxCellY) return;
+            cx0 = std::max(cx0, minCellX);
+            cx1 = std::min(cx1, maxCellX);
+            if(cx0 > cx1) return;
+            if(!hashed){
+                const std::uint32_t end = bucketStart[bucket(cx1, cy) + 1];
+                for(std::uint32_t i = bucketStart[bucket(cx0, cy)]; i < end; ++i) fn(i);
+                return;
+            }
+            for(int cx = cx0; cx <= cx1; ++cx){
+                const std::uint32_t b = bucket(cx, cy);
+                const std::uint64_t key = packCell(cx, cy);
+                for(std::uint32_t i = bucketStart[b]; i < bucketStart[b + 1]; ++i){
+                    if(sortedCell[i] == key) fn(i);
+                }
+            }
+        }
+        //Keep the k best hits in a max-heap (worst on top)
+        static void offer(std::vector<ProximityHit>& heap, std::size_t k, ProximityHit hit){
+            if(heap.size() < k){
+                heap.push_back(hit);
+                std::push_heap(heap.begin(), heap.end());
+            }
+            else if(hit < heap.front()){
+                std::pop_heap(heap.begin(), heap.end());
+                heap.back() = hit;
+                std::push_heap(heap.begin(), heap.end());
+            }
+        }
+        //Run query(q, list, thread) for every q in [0, count) and pack the hit lists in
+        //q order. A query appends its hits to the end of list.
+        //Queries run in the order given by `order` (all of [0, count), or null for
+        //0, 1, 2...). That order is cut into fixed chunks; each chunk collects its
+        //hits in its own list, then copies them to their place in out. Idle
+        //threads take whole chunks, so uneven queries still spread out.
+        template <typename Query>
+        void batch(std::size_t count, const std::uint32_t* order, ProximityResult& out, TaskScheduler* pool,
+                   Query query) const {
+            const std::size_t chunks = pool && pool->size() > 1 ? std::min<std::size_t>(count, pool->size() * 8) : 1;
+            std::vector<std::vector<ProximityHit>> parts(std::max<std::size_t>(chunks, 1));
+            out.start.assign(count + 1, 0);
+            auto work = [&](std::size_t c0, std::size_t c1, unsigned t){
+                for(std::size_t c = c0; c < c1; ++c){
+                    std::vector<ProximityHit>& part = parts[c];
+                    for(std::size_t j = count * c / chunks; j < count * (c + 1) / chunks; ++j){
+                        std::size_t q = order ? order[j] : j;
+                        std::size_t before = part.size();
+                        query(q, part, t);
+                        out.start[q + 1] = static_cast<std::uint32_t>(part.size() - before);
+                    }
+                }
+            };
+            auto place = [&](std::size_t c0, std::size_t c1, unsigned){
+                for(std::size_t c = c0; c < c1; ++c){
+                    const ProximityHit* from = parts[c].data();
+                    for(std::size_t j = count * c / chunks; j < count * (c + 1) / chunks; ++j){
+                        std::size_t q = order ? order[j] : j;
+                        std::uint32_t n = out.start[q + 1] - out.start[q];
+                        std::copy(from, from + n, out.hits.begin() + out.start[q]);
+                        from += n;
+                    }
+                }
+            };
+            if(pool) pool->parallelFor(chunks, work, 1);
+            else work(0, chunks, 0);
+            for(std::size_t q = 0; q < count; ++q) out.start[q + 1] += out.start[q];
+            out.hits.resize(out.start[count]);
+            if(pool) pool->parallelFor(chunks, place, 1);
+            else place(0, chunks, 0);
+        }
+        //nearestAll() on this grid's own cells
+        void nearestEach(std::size_t k, ProximityResult& out, TaskScheduler* pool) const {
+            std::vector<std::vector<ProximityHit>> heaps(pool ? pool->size() : 1);
+            batch(size(), sortedId.data(), out, pool, [&](std::size_t q, std::vector<ProximityHit>& list, unsigned t){
+                std::uint32_t id = static_cast<std::uint32_t>(q);
+                std::vector<ProximityHit>& heap = heaps[t]; //starts empty, so not the end of list
+                nearest(posX[id], posY[id], k, heap, id);
+                list.insert(list.end(), heap.begin(), heap.end());
+            });
+        }
+    public:
+        //cell is rounded up to a power of two
+        explicit ProximityGrid(int cell = 4){setCellSize(cell);}
+
+    int getCellSize() const {return cellSize;}
+    //Takes effect at the next build()
+    void setCellSize(int cell){
+        cellBits = 0;
+        while(cellBits < 30 && (1 << cellBits) < cell) ++cellBits;
+        cellSize = 1 << cellBits;
+    }
+    std::size_t size() const {return posX.size();}
+
+    //Index n robots; robot i is at (xs[i], ys[i]) and gets id i
+    void build(const int* xs, const int* ys, std::size_t n){
+        posX.assign(xs, xs + n);
+        posY.assign(ys, ys + n);
+        minCellX = minCellY = 0;
+        maxCellX = maxCellY = -1;
+        if(n > 0){
+            minCellX = maxCellX = cellOf(xs[0]);
+            minCellY = maxCellY = cellOf(ys[0]);
+        }
+        for(std::size_t i = 0; i < n; ++i){
+            int cx = cellOf(xs[i]);
+            int cy = cellOf(ys[i]);
+            minCellX = std::min(minCellX, cx);
+            maxCellX = std::max(maxCellX, cx);
+            minCellY = std::min(minCellY, cy);
+            maxCellY = std::max(maxCellY, cy);
+        }
+        //a row-major table while it stays within 16 entries (64 bytes) per robot
+        const std::uint64_t boxCells = n == 0 ? 0 : static_cast<std::uint64_t>(maxCellX - minCellX + 1)
+                                                   * static_cast<std::uint64_t>(maxCellY - minCellY + 1);
+        hashed = boxCells > n * 16 + 1024;
+        std::size_t tableSize;
+        if(hashed){
+            //about two buckets per robot keeps most buckets to one cell
+            tableBits = 4;
+            while((std::size_t(1) << tableBits) < n * 2 && tableBits < 31) ++tableBits;
+            tableSize = std::size_t(1) << tableBits;
+        }
+        else{
+            cols = n == 0 ? 0 : static_cast<std::size_t>(maxCellX - minCellX + 1);
+            tableSize = static_cast<std::size_t>(boxCells);
+        }
+        bucketStart.assign(tableSize + 1, 0);
+        bucketOf.resize(n);
+        //count
+        for(std::size_t i = 0; i < n; ++i){
+            bucketOf[i] = bucket(cellOf(xs[i]), cellOf(ys[i]));
+            ++bucketStart[bucketOf[i] + 1];
+        }
+        for(std::size_t b = 0; b < tableSize; ++b) bucketStart[b + 1] += bucketStart[b];
+        //place, bucketStart[b] walks up to the start of bucket b + 1
+        sortedX.resize(n);
+        sortedY.resize(n);
+        sortedId.resize(n);
+        sortedCell.resize(hashed ? n : 0);
+        for(std::size_t i = 0; i < n; ++i){
+            std::uint32_t slot = bucketStart[bucketOf[i]]++;
+            sortedX[slot] = xs[i];
+            sortedY[slot] = ys[i];
+            sortedId[slot] = static_cast<std::uint32_t>(i);
+            if(hashed) sortedCell[slot] = packCell(cellOf(xs[i]), cellOf(ys[i]));
+        }
+        //shift back: bucket b starts where bucket b - 1 ended
+        for(std::size_t b = tableSize; b > 0; --b) bucketStart[b] = bucketStart[b - 1];
+        bucketStart[0] = 0;
+    }
+    //Index a whole fleet; ids are the fleet ids
+    void build(const RobotFleet& fleet){
+        const std::size_t n = fleet.size();
+        std::vector<int> xs(n);
+        std::vector<int> ys(n);
+        for(int k = 0; k < ROBOT_KIND_COUNT; ++k){
+            const FleetColumns& c = fleet.group(static_cast<RobotKind>(k));
+            for(std::size_t row = 0; row < c.size(); ++row){
+                xs[c.id[row]] = c.x[row];
+                ys[c.id[row]] = c.y[row];
+            }
+        }
+        build(xs.data(), ys.data(), n);
+    }
+    int getX(std::uint32_t id) const {return posX[id];}
+    int getY(std::uint32_t id) const {return posY[id];}
+
+    //Visit the ids of the robots on cell (x, y), in id order
+    template <typename Fn>
+    void robotsAt(int x, int y, Fn&& fn) const {
+        if(posX.empty()) return;
+        forEachInRow(cellOf(y), cellOf(x), cellOf(x), [&](std::uint32_t i){
+            if(sortedX[i] == x && sortedY[i] == y) fn(sortedId[i]);
+        });
+    }
+    //Visit fn(id, dist2) for every robot within r of (x, y)
+    template <typename Fn>
+    void forEachInRadius(int x, int y, int r, Fn&& fn) const {
+        if(posX.empty() || r < 0) return;
+        const std::int64_t r2 = static_cast<std::int64_t>(r) * r;
+        const int cx0 = std::max(cellOf(x - r), minCellX);
+        const int cx1 = std::min(cellOf(x + r), maxCellX);
+        const int cy0 = std::max(cellOf(y - r), minCellY);
+        const int cy1 = std::min(cellOf(y + r), maxCellY);
+        if(cx0 > cx1 || cy0 > cy1) return;
+        auto visit = [&](std::uint32_t i){
+            std::int64_t d2 = distance2(x, y, sortedX[i], sortedY[i]);
+            if(d2 <= r2) fn(sortedId[i], d2);
+        };
+        //a radius covering more cells than there are robots: scanning them all is cheaper
+        if(static_cast<std::uint64_t>(cx1 - cx0 + 1) * static_cast<std::uint64_t>(cy1 - cy0 + 1) > sortedId.size()){
+            for(std::uint32_t i = 0; i < sortedId.size(); ++i) visit(i);
+            return;
+        }
+        for(int cy = cy0; cy <= cy1; ++cy) forEachInRow(cy, cx0, cx1, visit);
+    }
+    //Robots within r of (x, y), sorted by (distance, id); `skip` is left out
+    //(pass a robot's own id to get only its neighbours)
+    void inRadius(int x, int y, int r, std::vector<ProximityHit>& out, std::uint32_t skip = ~0u) const {
+        out.clear();
+        appendInRadius(x, y, r, out, skip);
+    }
+    //Same, appended to the end of out
+    void appendInRadius(int x, int y, int r, std::vector<ProximityHit>& out, std::uint32_t skip = ~0u) const {
+        const std::size_t first = out.size();
+        forEachInRadius(x, y, r, [&](std::uint32_t id, std::int64_t d2){
+            if(id != skip) out.push_back({d2, id});
+        });
+        if(out.size() - first > 1) std::sort(out.begin() + static_cast<std::ptrdiff_t>(first), out.end());
+    }
+    //The k robots closest to (x, y), sorted by (distance, id); `skip` is left out.
+    //Searches rings of cells outwards and stops once no closer robot can exist.
+    void nearest(int x, int y, std::size_t k, std::vector<ProximityHit>& out, std::uint32_t skip = ~0u) const {
+        out.clear();
+        if(k == 0 || posX.empty()) return;
+        auto visit = [&](std::uint32_t i){
+            if(sortedId[i] != skip) offer(out, k, {distance2(x, y, sortedX[i], sortedY[i]), sortedId[i]});
+        };
+        const int qx = cellOf(x);
+        const int qy = cellOf(y);
+        //rings needed to reach every indexed cell from the query cell
+        const long long lastRing = std::max({static_cast<long long>(qx) - minCellX, static_cast<long long>(maxCellX) - qx,
+                                             static_cast<long long>(qy) - minCellY, static_cast<long long>(maxCellY) - qy, 0ll});
+        std::uint64_t cellsVisited = 0;
+        for(long long d = 0; d <= lastRing; ++d){
+            //a robot in ring d is at least (d - 1) * cellSize + 1 away along some axis
+            if(d > 0 && out.size() == k){
+                std::int64_t gap = (d - 1) * cellSize + 1;
+                if(gap * gap > out.front().dist2) break;
+            }
+            //sparse robots far away: one pass over all of them is cheaper than more rings
+            cellsVisited += d == 0 ? 1 : static_cast<std::uint64_t>(8 * d);
+            if(cellsVisited > sortedId.size() * 2){
+                out.clear();
+                for(std::uint32_t i = 0; i < sortedId.size(); ++i) visit(i);
+                break;
+            }
+            const int x0 = static_cast<int>(qx - d), x1 = static_cast<int>(qx + d);
+            const int y0 = static_cast<int>(qy - d), y1 = static_cast<int>(qy + d);
+            if(d == 0){
+                forEachInRow(qy, qx, qx, visit);
+                continue;
+            }
+            forEachInRow(y0, x0, x1, visit);
+            forEachInRow(y1, x0, x1, visit);
+            for(int cy = y0 + 1; cy < y1; ++cy){
+                forEachInRow(cy, x0, x0, visit);
+                forEachInRow(cy, x1, x1, visit);
+            }
+        }
+        std::sort_heap(out.begin(), out.end());
+    }
+
+    //Neighbours within r of every indexed robot (itself left out), query = id.
+    //Robots are visited cell by cell, so neighbouring queries share cache lines.
+    void radiusAll(int r, ProximityResult& out, TaskScheduler* pool = nullptr) const {
+        batch(size(), sortedId.data(), out, pool, [&](std::size_t q, std::vector<ProximityHit>& list, unsigned){
+            std::uint32_t id = static_cast<std::uint32_t>(q);
+            appendInRadius(posX[id], posY[id], r, list, id);
+        });
+    }
+    //The k nearest other robots of every indexed robot, query = id.
+    //Robots far sparser than the cells (say 100k robots in a 1M x 1M world with
+    //4-cell cells) would need thousands of rings each, so then the search runs on
+    //a second grid whose cells hold about k robots.
+    void nearestAll(std::size_t k, ProximityResult& out, TaskScheduler* pool = nullptr) const {
+        if(size() > 0){
+            const double boxW = static_cast<double>(maxCellX - minCellX + 1) * cellSize;
+            const double boxH = static_cast<double>(maxCellY - minCellY + 1) * cellSize;
+            const double spacing = std::sqrt(boxW * boxH * static_cast<double>(std::max<std::size_t>(k, 1)) / size());
+            if(spacing > 4.0 * cellSize){
+                ProximityGrid coarse(static_cast<int>(std::min(spacing, 1e9)));
+                coarse.build(posX.data(), posY.data(), size());
+                coarse.nearestEach(k, out, pool);
+                return;
+            }
+        }
+        nearestEach(k, out, pool);
+    }
+    //Robots within r of arbitrary points (e.g. simulated range sensors)
+    void radiusBatch(const int* xs, const int* ys, std::size_t count, int r, ProximityResult& out,
+                     TaskScheduler* pool = nullptr) const {
+        batch(count, nullptr, out, pool, [&](std::size_t q, std::vector<ProximityHit>& list, unsigned){
+            appendInRadius(xs[q], ys[q], r, list);
+        });
+    }
+    //Visit every robot that shares its exact cell with another one, as
+    //fn(x, y, ids, count) once per crowded cell
+    template <typename Fn>
+    void forEachShared(Fn&& fn) const {
+        std::vector<std::uint32_t> ids;
+        const std::size_t tableSize = bucketStart.empty() ? 0 : bucketStart.size() - 1;
+        for(std::size_t b = 0; b < tableSize; ++b){
+            const std::uint32_t first = bucketStart[b];
+            const std::uint32_t last = bucketStart[b + 1];
+            if(last - first < 2) continue;
+            //same cell = same (x, y); small groups, so sort a copy of the bucket
+            std::vector<std::uint32_t> order(last - first);
+            for(std::uint32_t i = first; i < last; ++i) order[i - first] = i;
+            std::sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t c){
+                if(sortedY[a] != sortedY[c]) return sortedY[a] < sortedY[c];
+                if(sortedX[a] != sortedX[c]) return sortedX[a] < sortedX[c];
+                return sortedId[a] < sortedId[c];
+            });
+            for(std::size_t i = 0; i < order.size();){
+                std::size_t j = i;
+                ids.clear();
+                while(j < order.size() && sortedX[order[j]] == sortedX[order[i]] && sortedY[order[j]] == sortedY[order[i]]){
+                    ids.push_back(sortedId[order[j]]);
+                    ++j;
+                }
+                if(ids.size() > 1) fn(sortedX[order[i]], sortedY[order[i]], ids.data(), ids.size());
+                i = j;
+            }
+        }
+    }
+};
+
+#endif
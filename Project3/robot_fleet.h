@@ -0,0 +1,223 @@
+//robot_fleet.h
+//Data-oriented fleet engine for large numbers of robots.
+//Instead of one heap object per robot, each robot kind keeps its robots in
+//structure-of-arrays columns (all x values together, all y values together...).
+//One tick steps every robot of a kind in one tight loop, no virtual calls.
+//Movement rules are the same as the Robot classes in robot_sim.cpp (both use
+//the models in movement_model.h). The kinds come from ROBOT_KINDS there:
+//  Wheeled: step 1, cost 5,  AI = always right
+//  Legged:  step 1, cost 10, AI = right, else up, else left
+//  Flying:  step 3, cost 18, AI = always up
+#ifndef ROBOT_FLEET_H
+#define ROBOT_FLEET_H
+
+#include <cctype>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "occupancy_grid.h"
+#include "movement_model.h"
+
+#define ROBOT_KIND_ENUM(name, step, cost, symbol, ai) name,
+enum class RobotKind : std::uint8_t {ROBOT_KINDS(ROBOT_KIND_ENUM)};
+#undef ROBOT_KIND_ENUM
+#define ROBOT_KIND_ONE(name, step, cost, symbol, ai) + 1
+const int ROBOT_KIND_COUNT = 0 ROBOT_KINDS(ROBOT_KIND_ONE);
+#undef ROBOT_KIND_ONE
+//Longest single move of any kind
+constexpr int maxKindStep(){
+    int longest = 0;
+#define ROBOT_KIND_STEP(name, step, cost, symbol, ai) if(name##Movement::STEP > longest) longest = name##Movement::STEP;
+    ROBOT_KINDS(ROBOT_KIND_STEP)
+#undef ROBOT_KIND_STEP
+    return longest;
+}
+
+//What a kind does on an autonomous tick
+enum class FleetAi {Right, Up, Legged};
+
+struct KindRules{
+    int step;   //cells per move
+    int cost;   //battery per move
+    char symbol;
+    const char* name;
+    FleetAi ai;
+};
+inline const KindRules& kindRules(RobotKind kind){
+    static const KindRules rules[ROBOT_KIND_COUNT] = {
+#define ROBOT_KIND_RULES(name, step, cost, symbol, ai) \
+        {name##Movement::STEP, name##Movement::COST, symbol, #name, FleetAi::ai},
+        ROBOT_KINDS(ROBOT_KIND_RULES)
+#undef ROBOT_KIND_RULES
+    };
+    return rules[static_cast<int>(kind)];
+}
+//Kind from its name, any case ("wheeled", "Flying"); false if there is none
+inline bool kindFromName(const std::string& name, RobotKind& kind){
+    for(int k = 0; k < ROBOT_KIND_COUNT; ++k){
+        const char* known = kindRules(static_cast<RobotKind>(k)).name;
+        std::size_t i = 0;
+        while(i < name.size() && known[i] != '\0' &&
+              std::tolower(static_cast<unsigned char>(name[i])) == std::tolower(static_cast<unsigned char>(known[i]))) ++i;
+        if(i == name.size() && known[i] == '\0'){
+            kind = static_cast<RobotKind>(k);
+            return true;
+        }
+    }
+    return false;
+}
+
+//Direction the Legged AI picks from (x, y): right, else up, else left
+inline void leggedDirection(int x, int y, const OccupancyGrid& world, int& dx, int& dy){
+    dx = 1;
+    dy = 0;
+    if(world.isBlocked(x + 1, y) || x + 1 >= world.getWidth() - 1){
+        dx = 0;
+        dy = 1;
+        if(world.isBlocked(x, y + 1) || y + 1 >= world.getHeight() - 1){
+            dx = -1;
+            dy = 0;
+        }
+    }
+}
+//Where the kind's AI wants to go this tick. Returns false if it can't move
+//(low battery, boundary or obstacle), otherwise fills nx, ny.
+inline bool planMove(RobotKind kind, int x, int y, int battery, const OccupancyGrid& world, int& nx, int& ny){
+    const KindRules& rules = kindRules(kind);
+    int dx = 0;
+    int dy = 0;
+    switch(rules.ai){
+        case FleetAi::Right: dx = 1; break;
+        case FleetAi::Up: dy = 1; break;
+        case FleetAi::Legged: leggedDirection(x, y, world, dx, dy); break;
+    }
+    nx = x + dx * rules.step;
+    ny = y + dy * rules.step;
+    return battery >= LOW_BATTERY && world.inBounds(nx, ny) && !world.isBlocked(nx, ny);
+}
+
+//All robots of one kind, one column per field
+struct FleetColumns{
+    std::vector<int> x;
+    std::vector<int> y;
+    std::vector<int> battery;
+    std::vector<std::uint32_t> id; //fleet-wide id of each row
+    std::size_t size() const {return x.size();}
+};
+
+class RobotFleet{
+    private:
+        struct Slot{
+            RobotKind kind;
+            std::uint32_t row;
+        };
+        FleetColumns columns[ROBOT_KIND_COUNT];
+        std::vector<Slot> slots; //id -> (kind, row)
+
+        //Robots that always move the same way (Wheeled, Flying): the model's kernel
+        template <typename Model, Direction Dir>
+        static std::size_t stepStraight(FleetColumns& c, const OccupancyGrid& world){
+            return Model::template moveAll<Dir>(c.x.data(), c.y.data(), c.battery.data(), c.size(), world);
+        }
+        template <typename Model>
+        static std::size_t moveColumns(FleetColumns& c, Direction dir, const OccupancyGrid& world){
+            switch(dir){
+                case Direction::Up: return stepStraight<Model, Direction::Up>(c, world);
+                case Direction::Down: return stepStraight<Model, Direction::Down>(c, world);
+                case Direction::Left: return stepStraight<Model, Direction::Left>(c, world);
+                case Direction::Right: return stepStraight<Model, Direction::Right>(c, world);
+            }
+            return 0;
+        }
+        //Legged AI: probe right, then up, else go left
+        template <typename Model>
+        static std::size_t stepLegged(FleetColumns& c, const OccupancyGrid& world){
+            const std::size_t n = c.size();
+            int* xs = c.x.data();
+            int* ys = c.y.data();
+            int* bat = c.battery.data();
+            std::size_t moved = 0;
+            for(std::size_t i = 0; i < n; ++i){
+                int x = xs[i];
+                int y = ys[i];
+                int dx, dy;
+                leggedDirection(x, y, world, dx, dy);
+                int nx = x + dx * Model::STEP;
+                int ny = y + dy * Model::STEP;
+                bool ok = bat[i] >= LOW_BATTERY && world.inBounds(nx, ny) && !world.isBlocked(nx, ny);
+                xs[i] = ok ? nx : x;
+                ys[i] = ok ? ny : y;
+                bat[i] -= ok ? Model::COST : 0;
+                moved += ok;
+            }
+            return moved;
+        }
+        //One autonomous tick of one kind's columns
+        template <typename Model, FleetAi Ai>
+        static std::size_t stepKind(FleetColumns& c, const OccupancyGrid& world){
+            if constexpr(Ai == FleetAi::Right) return stepStraight<Model, Direction::Right>(c, world);
+            else if constexpr(Ai == FleetAi::Up) return stepStraight<Model, Direction::Up>(c, world);
+            else return stepLegged<Model>(c, world);
+        }
+    public:
+    //Add a robot, returns its fleet id
+    std::uint32_t spawn(RobotKind kind, int x = 0, int y = 0, int battery = 100){
+        FleetColumns& c = columns[static_cast<int>(kind)];
+        std::uint32_t id = static_cast<std::uint32_t>(slots.size());
+        slots.push_back({kind, static_cast<std::uint32_t>(c.size())});
+        c.x.push_back(x);
+        c.y.push_back(y);
+        c.battery.push_back(battery);
+        c.id.push_back(id);
+        return id;
+    }
+    void reserve(RobotKind kind, std::size_t count){
+        FleetColumns& c = columns[static_cast<int>(kind)];
+        c.x.reserve(count);
+        c.y.reserve(count);
+        c.battery.reserve(count);
+        c.id.reserve(count);
+    }
+    std::size_t size() const {return slots.size();}
+    void clear(){
+        for(auto& c : columns) c = FleetColumns();
+        slots.clear();
+    }
+    RobotKind kind(std::uint32_t id) const {return slots[id].kind;}
+    int getX(std::uint32_t id) const {return columns[static_cast<int>(slots[id].kind)].x[slots[id].row];}
+    int getY(std::uint32_t id) const {return columns[static_cast<int>(slots[id].kind)].y[slots[id].row];}
+    int getBattery(std::uint32_t id) const {return columns[static_cast<int>(slots[id].kind)].battery[slots[id].row];}
+    void setState(std::uint32_t id, int x, int y, int battery){
+        FleetColumns& c = columns[static_cast<int>(slots[id].kind)];
+        c.x[slots[id].row] = x;
+        c.y[slots[id].row] = y;
+        c.battery[slots[id].row] = battery;
+    }
+    const FleetColumns& group(RobotKind kind) const {return columns[static_cast<int>(kind)];}
+    FleetColumns& group(RobotKind kind) {return columns[static_cast<int>(kind)];}
+
+    //Move every robot of one kind one move in dir
+    std::size_t moveKind(RobotKind kind, Direction dir, const OccupancyGrid& world){
+        switch(kind){
+#define ROBOT_KIND_MOVE(name, step, cost, symbol, ai) \
+            case RobotKind::name: return moveColumns<name##Movement>(group(kind), dir, world);
+            ROBOT_KINDS(ROBOT_KIND_MOVE)
+#undef ROBOT_KIND_MOVE
+        }
+        return 0;
+    }
+    //One autonomous tick: every robot runs its kind's AI. Returns how many robots moved.
+    //Robots do not block each other, so stepping kind by kind gives the same result
+    //as stepping robot by robot.
+    std::size_t step(const OccupancyGrid& world){
+        std::size_t moved = 0;
+#define ROBOT_KIND_STEP(name, step, cost, symbol, ai) \
+        moved += stepKind<name##Movement, FleetAi::ai>(group(RobotKind::name), world);
+        ROBOT_KINDS(ROBOT_KIND_STEP)
+#undef ROBOT_KIND_STEP
+        return moved;
+    }
+};
+
+#endif
@@ -0,0 +1,114 @@
+//robot_pool.h
+//Object pool with stable handles, for objects that are spawned and removed a lot.
+//Objects live in fixed-size chunks, so an object never moves once created.
+//release() does not destroy the object: it is parked on a free list and the
+//next acquire() hands the same object out again (the caller resets its state).
+//Reusing objects this way keeps their own buffers (strings, path blocks...)
+//too, so once the pool has grown to the busiest moment, spawning and
+//removing objects does not touch the heap at all.
+//
+//A handle is (slot index, generation). Every release() bumps the slot's
+//generation, so a handle kept after its object was removed is detected as
+//stale (get() returns nullptr) instead of silently pointing at a new object.
+#ifndef ROBOT_POOL_H
+#define ROBOT_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+struct PoolHandle{
+    std::uint32_t index = ~0u;
+    std::uint32_t generation = 0;
+    bool valid() const {return index != ~0u;}
+    bool operator==(const PoolHandle& o) const {return index == o.index && generation == o.generation;}
+    bool operator!=(const PoolHandle& o) const {return !(*this == o);}
+};
+
+template <typename T>
+class ObjectPool{
+    private:
+        static constexpr std::size_t CHUNK = 256; //objects per chunk
+        struct Slot{
+            std::optional<T> object; //empty until the slot is used the first time
+            std::uint32_t generation = 0;
+            bool alive = false;
+        };
+        std::vector<std::unique_ptr<Slot[]>> chunks;
+        std::uint32_t slotCount = 0;   //slots handed out at least once
+        std::vector<std::uint32_t> freeList; //parked slots
+        std::size_t liveCount = 0;
+
+        Slot& slot(std::uint32_t i){return chunks[i / CHUNK][i % CHUNK];}
+        const Slot& slot(std::uint32_t i) const {return chunks[i / CHUNK][i % CHUNK];}
+    public:
+        ObjectPool() = default;
+        ObjectPool(const ObjectPool&) = delete;
+        ObjectPool& operator=(const ObjectPool&) = delete;
+
+    //A live object: a parked one if there is one (still in the state it was
+    //released in), otherwise a new one built from args
+    template <typename... Args>
+    PoolHandle acquire(Args&&... args){
+        std::uint32_t i;
+        if(!freeList.empty()){
+            i = freeList.back();
+            freeList.pop_back();
+        }
+        else{
+            i = slotCount++;
+            if(i / CHUNK >= chunks.size()) chunks.emplace_back(new Slot[CHUNK]);
+            slot(i).object.emplace(std::forward<Args>(args)...);
+        }
+        Slot& s = slot(i);
+        s.alive = true;
+        ++liveCount;
+        return {i, s.generation};
+    }
+    //Park the object; false if the handle is stale
+    bool release(PoolHandle h){
+        if(!get(h)) return false;
+        Slot& s = slot(h.index);
+        s.alive = false;
+        ++s.generation;
+        freeList.push_back(h.index);
+        --liveCount;
+        return true;
+    }
+    //The object, or nullptr if the handle is stale
+    T* get(PoolHandle h){
+        if(h.index >= slotCount) return nullptr;
+        Slot& s = slot(h.index);
+        return s.alive && s.generation == h.generation ? &*s.object : nullptr;
+    }
+    const T* get(PoolHandle h) const {
+        if(h.index >= slotCount) return nullptr;
+        const Slot& s = slot(h.index);
+        return s.alive && s.generation == h.generation ? &*s.object : nullptr;
+    }
+    //Visit every live object as fn(T&), in slot order
+    template <typename Fn>
+    void forEach(Fn fn){
+        for(std::uint32_t i = 0; i < slotCount; ++i){
+            Slot& s = slot(i);
+            if(s.alive) fn(*s.object);
+        }
+    }
+    //Make room for `count` objects in total without growing later
+    template <typename... Args>
+    void reserve(std::size_t count, Args&&... args){
+        std::vector<PoolHandle> taken;
+        taken.reserve(count);
+        while(liveCount < count) taken.push_back(acquire(args...));
+        for(PoolHandle h : taken) release(h);
+        freeList.reserve(count);
+    }
+    std::size_t size() const {return liveCount;}
+    //Objects created so far, live or parked
+    std::size_t capacity() const {return slotCount;}
+};
+
+#endif
@@ -3,13 +3,41 @@
 #include <memory>      // for std::unique_ptr and std::make_unique
 //Real robotics code never uses raw new/delete — always smart pointers to avoid memory leaks.
 #include <string>      // for std::string
+#include <cstdlib>     // for std::atoi
+#include <chrono>      // for timing the fleet stress test
+#include <thread>      // for pacing the live view
+#include <random>      // for scenario obstacles and spawn points
+#include <cmath>       // for std::sqrt in the proximity report
+#include "occupancy_grid.h" // O(1) obstacle lookups
+#include "robot_fleet.h"    // data-oriented engine for big fleets
+#include "movement_model.h" // step/cost policies, one kernel per robot kind
+#include "parallel_tick.h"  // multi-threaded tick with robot-robot blocking
+#include "path_planner.h"   // A*/JPS and shared distance fields
+#include "grid_renderer.h"  // viewport + changed-cells-only terminal drawing
+#include "path_trace.h"     // 4-bit delta-encoded path history
+#include "robot_pool.h"     // recycled robot objects with stable handles
+#include "proximity_grid.h" // broadphase: robots near a point, shared cells
+#include "sim_checkpoint.h" // checkpoints + command log, replay from any checkpoint
+#include "../Common/async_logger.h" // LOG_INFO: printing happens on a background thread
+#include "../Common/scenario_file.h" // headless batch runs: robot_sim --scenario file
+#include "../Common/metrics.h"       // timers/histograms, only with -DMETRICS_ENABLED=1
 //Base Class Robot
-enum class Direction {Up,Down,Left,Right};
-const int GRID_SIZE = 10;
+//Direction and the movement rules of each kind are in movement_model.h
+//default map, copied into the world at start-up
 std::vector<std::pair<int,int>> obstacles = {
     {3, 3}, {4, 3}, {5, 3},  // a wall
     {7, 6}, {2, 8}
 };
+//The world: size is chosen at runtime (see main), obstacles are looked up in O(1)
+OccupancyGrid world(10, 10);
+//Shared planner: robots with the same goal share one distance field
+PathPlanner planner(world);
+//What fits on the terminal: at most 40 x 20 cells (80 columns with the spaces)
+const int VIEW_COLS = 40;
+const int VIEW_ROWS = 20;
+GridRenderer view(VIEW_COLS, VIEW_ROWS);
+//Path histories of all robots live in blocks of this arena
+PathArena pathArena;
 class Robot{
     protected:
     //protected: derived classes (Wheeled, Legged, Flying) can access these directly.
@@ -19,17 +47,19 @@ class Robot{
         int positionY = 0;
         int battery = 100;
         std::string type;
-        std::vector<std::pair<int,int>> path;
+        PathTrace path{pathArena}; //every position visited, ~0.5 byte per step
+        std::uint32_t traceId = 0; //the path's id in the trace file, new for every spawn
         bool isObstacle(int posX, int posY)const{
-            for(const auto& obs : obstacles){
-                if(obs.first == posX && obs.second == posY)return true;
-            }
-            return false;
+            return world.isBlocked(posX, posY);
         }
+        //navigation goal, used by robots with a planning AI
+        bool hasGoal = false;
+        int goalX = 0;
+        int goalY = 0;
     public:
         
         Robot(std::string t) : type(t){
-            path.emplace_back(positionX, positionY);
+            path.push(positionX, positionY);
         } //construtor, init list() type = t
         //Constructor using member initializer list
         //Initializes type ("Wheeled", "Legged", etc.)
@@ -45,13 +75,35 @@ class Robot{
         }
 
 
-        virtual void showPath()const{
-            std::cout << "Path History: \n";
-            for(auto& [x,y] : path){
-                std::cout << "(" << x << "," << y << ") ";
-                std::cout << "->";
+        //Long histories only show their newest positions
+        virtual void showPath(std::size_t maxShown = 20)const{
+            std::string text = "Path History: \n";
+            std::size_t from = 0;
+            if(path.size() > maxShown){
+                from = path.size() - maxShown;
+                text = "Path History (last " + std::to_string(maxShown) + " of " + std::to_string(path.size())
+                     + " positions, " + std::to_string(path.bytesUsed()) + " bytes): \n";
             }
-            std::cout << "\n";
+            path.forEach([&](int x, int y){
+                text += "(" + std::to_string(x) + "," + std::to_string(y) + ") ";
+                text += "->";
+            }, from);
+            LOG_INFO(text);
+        }
+        //Stream the positions added since the last call to the trace file
+        void exportPath(PathTraceFile& file){path.exportTo(file, traceId);}
+        std::uint32_t getTraceId()const{return traceId;}
+        //Start over as a fresh robot at (x, y); used when the pool hands out a recycled robot.
+        //The new path goes to the trace file as trace `trace`, so it never continues
+        //the previous robot's trace. The path keeps its buffers, so this does not allocate.
+        void respawn(int x, int y, std::uint32_t trace){
+            traceId = trace;
+            positionX = x;
+            positionY = y;
+            battery = 100;
+            hasGoal = false;
+            path.clear();
+            path.push(positionX, positionY);
         }
         virtual void showStatus() const{
         //virtual: can be overridden (though we use default here)
@@ -64,6 +116,15 @@ class Robot{
         //Const getters — safe way for outside code (like displayGrid) to read position/type.
         //Encapsulation: direct access to positionX/Y denied, must use getters.
         std::string getType()const{return type;}
+        int getBattery()const{return battery;}
+        void setGoal(int x, int y){
+            hasGoal = true;
+            goalX = x;
+            goalY = y;
+        }
+        void clearGoal(){hasGoal = false;}
+        //Which fleet column group this robot belongs to (see robot_fleet.h)
+        virtual RobotKind kind()const = 0;
         virtual ~Robot() = default; // crucial for polymorphism
         //Virtual destructor — absolutely required for polymorphism.
         //virtual : allow overide
@@ -71,188 +132,288 @@ class Robot{
         //default: default destructor
 
 };
+//Shared body of every robot kind: move() is the kind's MovementModel kernel
+//(movement_model.h), so a derived class only adds its AI in update().
+//Inside the derived classes moveWith() is called directly: no virtual call,
+//and step, cost and direction table are compile-time constants.
+template <typename Model>
+class MovingRobot : public Robot{
+    protected:
+        const char* className; //for the "moved efficiently" message
+        //One move along the shared distance field. Returns false when there is
+        //no goal, the goal is reached or it can't be reached with this step size.
+        bool stepTowardGoal(){
+            int dx, dy;
+            if(!hasGoal || !planner.nextMove(positionX, positionY, goalX, goalY, Model::STEP, dx, dy)){
+                return false;
+            }
+            if(dx > 0) moveWith(Direction::Right);
+            else if(dx < 0) moveWith(Direction::Left);
+            else if(dy > 0) moveWith(Direction::Up);
+            else moveWith(Direction::Down);
+            return true;
+        }
+    public:
+        MovingRobot(std::string t, const char* name) : Robot(t), className(name){}
+    void moveWith(Direction dir){
+        METRICS_SCOPE("robot_move");
+        switch(Model::move(positionX, positionY, battery, dir, world)){
+            case MoveResult::LowBattery: METRICS_COUNT("robot_move_low_battery", 1); LOG_WARN("Low battery!"); return;
+            case MoveResult::Boundary: METRICS_COUNT("robot_move_boundary", 1); LOG_WARN("Cannot move — boundary!"); return;
+            case MoveResult::Blocked: METRICS_COUNT("robot_move_blocked", 1); LOG_WARN("Blocked by obstacle!"); return;
+            case MoveResult::Moved: break;
+        }
+        LOG_INFO(className, " moved efficiently");
+        path.push(positionX, positionY);
+    }
+    //This is polymorphism in action — same move() call, different results!
+    void move(Direction dir) override {moveWith(dir);}
+};
 //Derived Classed
-class WheeledRobot : public Robot {
+//A new kind = one line in ROBOT_KINDS (movement_model.h) + a NameRobot class with its AI
+class WheeledRobot : public MovingRobot<WheeledMovement> {
         
     public:
-        WheeledRobot() : Robot("Wheeled") {}
+        WheeledRobot() : MovingRobot("Wheeled", "WheeledRobot") {}
+        RobotKind kind()const override {return RobotKind::Wheeled;}
         //Calls base constructor with type string
         //Constructor is public → main() can create it
-        void move(Direction dir) override {
-            //This is polymorphism in action — same move() call, different results!
-            if(battery < 10){
-                std::cout << "Low battery!\n";
-                return;
-            }
-            int dy = 0;
-            int dx = 0;
-            switch (dir){
-                case Direction::Up: dy = 1;break;
-                case Direction::Down: dy = -1;break;
-                case Direction::Right: dx = 1;break;
-                case Direction::Left: dx = -1;break;
-            
-            default:
-                break;
-            }
-            int newX = positionX + dx;
-            int newY = positionY + dy;
-            if(newX < 0 || newX >= GRID_SIZE || newY < 0 || newY >= GRID_SIZE){
-                std::cout << "Cannot move — boundary!\n";
-                return;
-            }
-            else if(isObstacle(newX,newY)){
-                std::cout << "Blocked by obstacle!\n";
-                return;
-            }
-            else{
-                positionX = newX;
-                positionY = newY;
-                battery -= 5;
-                std::cout << "WheeledRobot moved efficiently\n";
-                path.emplace_back(positionX, positionY);
-            }
-            
-        }
         void update() override {
-            move(Direction::Right);
+            moveWith(Direction::Right);
         }
 };
-class LeggedRobot : public Robot{
+class LeggedRobot : public MovingRobot<LeggedMovement>{
     public:
-        LeggedRobot() : Robot("Legged") {}
-     void move(Direction dir) override {
-            //This is polymorphism in action — same move() call, different results!
-            if(battery < 10){
-                std::cout << "Low battery!\n";
-                return;
-            }
-            int dy = 0;
-            int dx = 0;
-            switch (dir){
-                case Direction::Up: dy = 1;break;
-                case Direction::Down: dy = -1;break;
-                case Direction::Right: dx = 1;break;
-                case Direction::Left: dx = -1;break;
-            
-            default:
-                break;
-            }
-            int newX = positionX + dx;
-            int newY = positionY + dy;
-            if(newX < 0 || newX >= GRID_SIZE || newY < 0 || newY >= GRID_SIZE){
-                std::cout << "Cannot move — boundary!\n";
-                return;
-            }
-            else if(isObstacle(newX,newY)){
-                std::cout << "Blocked by obstacle!\n";
+        LeggedRobot() : MovingRobot("Legged", "LeggedRobot") {}
+        RobotKind kind()const override {return RobotKind::Legged;}
+        void update() override {
+            if(hasGoal){
+                //goal set: follow the planner, stay put once there
+                if(!stepTowardGoal() && (positionX != goalX || positionY != goalY)){
+                    LOG_WARN("LeggedRobot: goal unreachable!");
+                }
                 return;
             }
-            else{
-                positionX = newX;
-                positionY = newY;
-                battery -= 10;
-                std::cout << "LeggedRobot moved efficiently\n";
-                path.emplace_back(positionX, positionY);
-            }
-            
-        }
-        void update() override {
             int testX = positionX+1;// try move to right
             int testY = positionY;
-            if(isObstacle(testX,testY)||testX >= GRID_SIZE-1){
+            if(isObstacle(testX,testY)||testX >= world.getWidth()-1){
                 testX = positionX;
                 testY = positionY + 1; //try move to up
-                if (isObstacle(testX, testY) || testY >= GRID_SIZE-1) {
+                if (isObstacle(testX, testY) || testY >= world.getHeight()-1) {
                     // Try left as last resort
-                    move(Direction::Left); 
+                    moveWith(Direction::Left); 
                     return;
                 }
-                move(Direction::Up);
+                moveWith(Direction::Up);
             }
             else{
-                move(Direction::Right);
+                moveWith(Direction::Right);
             }
         }
 };
 
-class FlyingRobot : public Robot{
+class FlyingRobot : public MovingRobot<FlyingMovement>{
     public:
-        FlyingRobot(std::string name) : Robot(name){}
-     void move(Direction dir) override {
-            //This is polymorphism in action — same move() call, different results!
-            if(battery < 10){
-                std::cout << "Low battery!\n";
-                return;
-            }
-            int dy = 0;
-            int dx = 0;
-            switch (dir){
-                case Direction::Up: dy = 3;break;
-                case Direction::Down: dy = -3;break;
-                case Direction::Right: dx = 3;break;
-                case Direction::Left: dx = -3;break;
-            
-            default:
-                break;
-            }
-            int newX = positionX + dx;
-            int newY = positionY + dy;
-            if(newX < 0 || newX >= GRID_SIZE || newY < 0 || newY >= GRID_SIZE){
-                std::cout << "Cannot move — boundary!\n";
-                return;
-            }
-            else if(isObstacle(newX,newY)){
-                std::cout << "Blocked by obstacle!\n";
+        FlyingRobot(std::string name = "FlyingRobot") : MovingRobot(name, "FlyingRobot"){}
+        RobotKind kind()const override {return RobotKind::Flying;}
+        void update() override {
+            if(hasGoal){
+                //3-cell jumps, planned on the step-3 distance field
+                if(!stepTowardGoal() && (positionX != goalX || positionY != goalY)){
+                    LOG_WARN("FlyingRobot: goal unreachable in 3-cell jumps!");
+                }
                 return;
             }
-            else{
-                positionX = newX;
-                positionY = newY;
-                battery -= 18;
-                std::cout << "FlyingRobot moved efficiently\n";
-                path.emplace_back(positionX, positionY);
-            }
-            
-        }
-        void update() override {
             // Flying robots love altitude!
-            move(Direction::Up);  // big jump of 3
+            moveWith(Direction::Up);  // big jump of 3
         }
 };
 
-void displayGrid(const std::vector<std::unique_ptr<Robot>>& robots){
-    std::cout << "\n=== Grid World (0 to " << GRID_SIZE-1 << ") ===\n";
-    for(int row = GRID_SIZE-1; row >= 0; --row){
-        for(int col = 0; col < GRID_SIZE; ++col){
-            char symbol = '.';
-            bool isObstacle = false;
-            for(const auto& obs : obstacles){
-                if(obs.first == col && obs.second == row){
-                    symbol = '#'; // obstacle symbol
-                    isObstacle = true;
-                    break;
-                }
+//Which robot in the pool: its kind picks the sub-pool, the handle the slot
+struct RobotHandle{
+    RobotKind kind = RobotKind::Wheeled;
+    PoolHandle slot;
+};
+//All robots of the simulator. Removed robots are recycled by the next spawn of
+//the same kind, so spawning and removing robots at a steady rate is allocation-free.
+class RobotPool{
+    private:
+        //one sub-pool per kind: poolWheeled, poolLegged, ...
+#define ROBOT_KIND_POOL(name, step, cost, symbol, ai) ObjectPool<name##Robot> pool##name;
+        ROBOT_KINDS(ROBOT_KIND_POOL)
+#undef ROBOT_KIND_POOL
+        std::vector<Robot*> live;               //every live robot, see list()
+        std::vector<RobotHandle> liveHandles;   //same order as live
+        std::vector<std::uint32_t> livePos[ROBOT_KIND_COUNT]; //slot index -> position in live
+        std::uint32_t nextTraceId = 0; //one trace per spawn, in spawn order
+
+        Robot* find(RobotHandle h){
+            switch(h.kind){
+#define ROBOT_KIND_FIND(name, step, cost, symbol, ai) case RobotKind::name: return pool##name.get(h.slot);
+                ROBOT_KINDS(ROBOT_KIND_FIND)
+#undef ROBOT_KIND_FIND
             }
-            if (isObstacle)
-            {
-                std::cout << symbol << ' ';
-                continue;
+            return nullptr;
+        }
+    public:
+    RobotHandle spawn(RobotKind kind, int x = 0, int y = 0){
+        RobotHandle h;
+        h.kind = kind;
+        switch(kind){
+#define ROBOT_KIND_ACQUIRE(name, step, cost, symbol, ai) case RobotKind::name: h.slot = pool##name.acquire(); break;
+            ROBOT_KINDS(ROBOT_KIND_ACQUIRE)
+#undef ROBOT_KIND_ACQUIRE
+        }
+        Robot* robot = find(h);
+        robot->respawn(x, y, nextTraceId++);
+        auto& pos = livePos[static_cast<int>(kind)];
+        if(h.slot.index >= pos.size()) pos.resize(h.slot.index + 1);
+        pos[h.slot.index] = static_cast<std::uint32_t>(live.size());
+        live.push_back(robot);
+        liveHandles.push_back(h);
+        return h;
+    }
+    //Remove a robot; false if it was already removed (stale handle)
+    bool despawn(RobotHandle h){
+        if(!find(h)) return false;
+        //the last robot in the list takes the removed robot's place
+        std::uint32_t at = livePos[static_cast<int>(h.kind)][h.slot.index];
+        live[at] = live.back();
+        liveHandles[at] = liveHandles.back();
+        livePos[static_cast<int>(liveHandles[at].kind)][liveHandles[at].slot.index] = at;
+        live.pop_back();
+        liveHandles.pop_back();
+        switch(h.kind){
+#define ROBOT_KIND_RELEASE(name, step, cost, symbol, ai) case RobotKind::name: pool##name.release(h.slot); break;
+            ROBOT_KINDS(ROBOT_KIND_RELEASE)
+#undef ROBOT_KIND_RELEASE
+        }
+        return true;
+    }
+    //The robot, or nullptr if it was removed
+    Robot* get(RobotHandle h){return find(h);}
+    //One autonomous step for every robot, kind by kind. The calls name the class,
+    //so they are direct (inlinable) calls instead of a vtable lookup per robot.
+    void updateAll(){
+#define ROBOT_KIND_UPDATE(name, step, cost, symbol, ai) \
+        pool##name.forEach([](name##Robot& r){ METRICS_SCOPE("robot_update"); r.name##Robot::update(); });
+        ROBOT_KINDS(ROBOT_KIND_UPDATE)
+#undef ROBOT_KIND_UPDATE
+    }
+    //Grow every part of the pool for `count` robots of a kind up front
+    void reserve(RobotKind kind, std::size_t count){
+        switch(kind){
+#define ROBOT_KIND_RESERVE(name, step, cost, symbol, ai) case RobotKind::name: pool##name.reserve(count); break;
+            ROBOT_KINDS(ROBOT_KIND_RESERVE)
+#undef ROBOT_KIND_RESERVE
+        }
+        live.reserve(live.size() + count);
+        liveHandles.reserve(liveHandles.size() + count);
+        livePos[static_cast<int>(kind)].reserve(count);
+    }
+    //Live robots in spawn order, except that a despawn moves the last robot into the gap
+    const std::vector<Robot*>& list() const {return live;}
+    const std::vector<RobotHandle>& handles() const {return liveHandles;}
+    std::size_t size() const {return live.size();}
+};
+using RobotList = std::vector<Robot*>;
+
+//Draw the robots and obstacles inside the viewport into the renderer
+void composeView(const RobotList& robots){
+    view.clear();
+    //robots in reverse so the first robot on a cell wins, like before
+    for(auto it = robots.rbegin(); it != robots.rend(); ++it){
+        const auto& robot = *it;
+        view.plot(robot->getX(), robot->getY(), robot->getType()[0]); // 'W' or 'L'
+    }
+    //obstacles drawn last, they always win
+    view.drawObstacles(world);
+}
+void displayGrid(const RobotList& robots){
+    METRICS_SCOPE("render_frame");
+    const int width = world.getWidth();
+    const int height = world.getHeight();
+    std::string text = "\n=== Grid World (0 to " + std::to_string(width-1) + ") ===\n";
+    //bigger than the terminal: follow the first robot and say which part is shown
+    if(width > view.spanX() || height > view.spanY()){
+        if(!robots.empty()) view.centerOn(robots[0]->getX(), robots[0]->getY(), world);
+        text = "\n=== Grid World (0 to " + std::to_string(width-1) + "), view x "
+             + std::to_string(view.getOriginX()) + "-" + std::to_string(view.getOriginX() + view.spanX() - 1)
+             + " y " + std::to_string(view.getOriginY()) + "-" + std::to_string(view.getOriginY() + view.spanY() - 1)
+             + " ===\n";
+    }
+    composeView(robots);
+    text += view.frameText();
+    LOG_INFO(text);
+}
+//The grid shows one robot per cell; list the cells where robots stack up
+void showSharedCells(const RobotList& robots){
+    std::vector<int> xs;
+    std::vector<int> ys;
+    for(const auto& robot : robots){
+        xs.push_back(robot->getX());
+        ys.push_back(robot->getY());
+    }
+    ProximityGrid index(1);
+    index.build(xs.data(), ys.data(), robots.size());
+    index.forEachShared([&](int x, int y, const std::uint32_t* ids, std::size_t count){
+        std::cout << "Sharing cell (" << x << ", " << y << "):";
+        for(std::size_t i = 0; i < count; ++i) std::cout << " " << robots[ids[i]]->getType();
+        std::cout << "\n";
+    });
+}
+//Autonomous steps drawn in place: only the cells that changed are redrawn
+void liveView(RobotPool& pool){
+    const RobotList& robots = pool.list();
+    std::cout << "How many simulation steps? (1-1000) ";
+    int steps;
+    if(!(std::cin >> steps) || steps <= 0 || steps > 1000){
+        std::cout << "Invalid number of steps!(must be 1-1000)\n";
+        return;
+    }
+    std::cout << "Zoom (cells per character, 1-1000)? ";
+    int zoom;
+    if(!(std::cin >> zoom) || zoom <= 0 || zoom > 1000){
+        std::cout << "Invalid zoom!\n";
+        return;
+    }
+    //move messages would scroll the screen away, keep them off the console meanwhile
+    logFlush();
+    AsyncLogger::instance().setConsole(false);
+    view.setZoom(zoom);
+    view.fitTo(world, VIEW_COLS, VIEW_ROWS);
+    //without ANSI escapes every frame is printed whole, one below the other
+    const bool ansi = GridRenderer::ansiSupported();
+    std::size_t sent = 0;
+    for(int s = 0; s <= steps; ++s){
+        if(s > 0){
+            pool.updateAll();
+        }
+        {
+            METRICS_SCOPE("render_frame");
+            if(!robots.empty()) view.centerOn(robots[0]->getX(), robots[0]->getY(), world);
+            composeView(robots);
+            std::string status = "Step " + std::to_string(s) + "/" + std::to_string(steps) + "  zoom " + std::to_string(zoom);
+            if(ansi){
+                std::size_t changed = view.update();
+                view.present(status + "  redrawn cells: " + std::to_string(changed));
+                sent += view.lastBytes();
             }
-            for(const auto& robot : robots){
-                if(robot->getX() == col && robot -> getY() == row){
-                    symbol = robot->getType()[0]; // 'W' or 'L'
-                    break;
-                }
+            else{
+                std::string frame = status + "\n" + view.frameText();
+                std::cout << frame << std::flush;
+                sent += frame.size();
             }
-            std::cout << symbol << ' ';
         }
-        std::cout << '\n'; 
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
-    std::cout << "\n";
-    
+    logFlush();
+    AsyncLogger::instance().setConsole(true);
+    std::cout << "\nLive view done, " << sent << " bytes sent to the terminal.\n";
+    view.setZoom(1);
+    view.fitTo(world, VIEW_COLS, VIEW_ROWS);
 }
-void moveOption(std::vector<std::unique_ptr<Robot>>& robots){
+void moveOption(const RobotList& robots){
             std::cout << "Choose robot:\n1. Wheeled  2. Legged  3. Flying\n";
             int robotChoice; 
             std::cin >> robotChoice;
@@ -278,7 +439,7 @@ void moveOption(std::vector<std::unique_ptr<Robot>>& robots){
             robots[robotChoice-1]->move(dir);
             robots[robotChoice-1]->showPath();
         };
-void moveTogather(std::vector<std::unique_ptr<Robot>>& robots){
+void moveTogather(const RobotList& robots){
             std::cout << "How many simulation steps? (between 1-4) ";
             int steps; 
             if(!(std::cin >> steps)|| steps <= 0 || steps > 4){
@@ -299,17 +460,18 @@ void moveTogather(std::vector<std::unique_ptr<Robot>>& robots){
                 case 3: dir = Direction::Left; break;
                 case 4: dir = Direction::Right; break;
             }
-            std::cout << "\nStarting autonomous simulation for " << steps << " steps...\n\n";
+            LOG_INFO("\nStarting autonomous simulation for ", steps, " steps...\n");
             for(auto& rb : robots){
                 for(int s = 0 ; s < steps ; ++s){
-                    std::cout << "--- Simulation Step " << (s + 1) << " ---\n";
+                    LOG_INFO("--- Simulation Step ", (s + 1), " ---");
                     rb->move(dir);
                 }
                 displayGrid(robots);
             }
-            std::cout << "Autonomous simulation complete!\n";
+            LOG_INFO("Autonomous simulation complete!");
         };
-void autonomousMovement(std::vector<std::unique_ptr<Robot>>& robots){
+void autonomousMovement(RobotPool& pool){
+            const RobotList& robots = pool.list();
             std::cout << "How many simulation steps? (between 1-9) ";
             int steps; 
             if(!(std::cin >> steps)|| steps <= 0 || steps > 9){
@@ -317,37 +479,526 @@ void autonomousMovement(std::vector<std::unique_ptr<Robot>>& robots){
                 return;
             }
             
-            std::cout << "\nStarting autonomous simulation for " << steps << " steps...\n\n";
+            LOG_INFO("\nStarting autonomous simulation for ", steps, " steps...\n");
             for(int s = 0 ; s < steps ; ++s){
-                std::cout << "--- Simulation Step " << (s + 1) << " ---\n";
-                for(auto& rb : robots){
-                    rb->update();
-                }
+                LOG_INFO("--- Simulation Step ", (s + 1), " ---");
+                pool.updateAll();
                 displayGrid(robots);
             }
-            std::cout << "Autonomous simulation complete!\n";
+            LOG_INFO("Autonomous simulation complete!");
         };
-int main() {
-    std::vector<std::unique_ptr<Robot>> robots;
-    robots.push_back(std::make_unique<WheeledRobot>());
-    robots.push_back(std::make_unique<LeggedRobot>());
-    robots.push_back(std::make_unique<FlyingRobot>("FlyingRobot"));
+//Give every robot a navigation goal and preview the planned routes
+void setGoalOption(const RobotList& robots){
+    std::cout << "Goal X Y? (-1 -1 clears the goal) ";
+    int x, y;
+    if(!(std::cin >> x >> y)){
+        std::cout << "Invalid goal!\n";
+        return;
+    }
+    if(x == -1 && y == -1){
+        for(auto& rb : robots) rb->clearGoal();
+        std::cout << "Goals cleared.\n";
+        return;
+    }
+    if(!walkable(world, x, y)){
+        std::cout << "Goal must be a free cell inside the grid!\n";
+        return;
+    }
+    for(auto& rb : robots){
+        rb->setGoal(x, y);
+        int step = kindRules(rb->kind()).step;
+        auto route = findPath(world, rb->getX(), rb->getY(), x, y, step);
+        std::cout << rb->getType() << ": ";
+        if(route.empty()){
+            std::cout << "no route\n";
+            continue;
+        }
+        std::cout << route.size() - 1 << " moves ";
+        for(auto& [px, py] : route) std::cout << "(" << px << "," << py << ")";
+        std::cout << "\n";
+    }
+}
+//Stress test: clone the current robots into a data-oriented fleet and step it
+void fleetStressTest(const RobotList& robots){
+    std::cout << "How many robots? (1-10000000) ";
+    long long count;
+    if(!(std::cin >> count) || count <= 0 || count > 10000000){
+        std::cout << "Invalid number of robots!\n";
+        return;
+    }
+    std::cout << "How many ticks? (1-1000) ";
+    int ticks;
+    if(!(std::cin >> ticks) || ticks <= 0 || ticks > 1000){
+        std::cout << "Invalid number of ticks!\n";
+        return;
+    }
+    std::cout << "Threads for the collision-aware tick? (0 = plain step, robots pass through each other) ";
+    int threads;
+    if(!(std::cin >> threads) || threads < 0 || threads > 256){
+        std::cout << "Invalid number of threads!\n";
+        return;
+    }
+    RobotFleet fleet;
+    for(long long i = 0; i < count; ++i){
+        const Robot& r = *robots[i % robots.size()];
+        fleet.spawn(r.kind(), r.getX(), r.getY(), r.getBattery());
+    }
+    std::unique_ptr<ParallelTicker> ticker;
+    if(threads > 0){
+        ticker = std::make_unique<ParallelTicker>(threads);
+    }
+    std::size_t moves = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(int t = 0; t < ticks; ++t){
+        moves += ticker ? ticker->tick(fleet, world) : fleet.step(world);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << count << " robots x " << ticks << " ticks in " << seconds * 1000.0 << " ms ("
+              << (count * ticks) / (seconds > 0 ? seconds : 1e-9) / 1e6 << " M robot-steps/s, "
+              << moves << " moves)\n";
+}
+//Read the trace file back and show where every robot has been
+void replayTrace(const std::string& tracePath){
+    PathArena arena;
+    std::vector<std::unique_ptr<PathTrace>> traces;
+    if(!loadPathTraces(tracePath, arena, traces)){
+        std::cout << "Could not read " << tracePath << " (missing or damaged)\n";
+        if(traces.empty()) return;
+    }
+    std::cout << "\n=== Trace " << tracePath << " ===\n";
+    for(std::size_t i = 0; i < traces.size(); ++i){
+        const PathTrace& t = *traces[i];
+        if(t.empty()) continue;
+        auto [sx, sy] = t.at(0);
+        auto [ex, ey] = t.back();
+        std::cout << "Robot " << i << ": " << t.size() << " positions, (" << sx << "," << sy << ") -> ("
+                  << ex << "," << ey << "), " << t.bytesUsed() << " bytes in memory\n";
+    }
+}
+//Warehouse layout for huge maps: storage zones (one region in every 4 x 4,
+//see chunked_world.h) full of 4-cell racks with 12-cell aisles and a cross
+//aisle every 512 rows, open floor everywhere else. Written straight to a map
+//file; identical tiles and zones are stored once.
+bool makeWarehouseMap(const std::string& path, int width, int height){
+    auto zone = [](int rx, int ry){
+        return rx % 4 == 1 && ry % 4 == 1 ? ChunkState::Mixed : ChunkState::Free;
+    };
+    auto racks = [](int, int ty, std::uint64_t rows[CHUNK_TILE]){
+        const std::uint64_t RACK_ROW = 0x00F000F000F000F0ull; //cells 4-7 of every 16 blocked
+        bool any = false;
+        for(int r = 0; r < CHUNK_TILE; ++r){
+            int y = ty * CHUNK_TILE + r;
+            if(y % 512 >= 16 && y % 512 < 496){
+                rows[r] = RACK_ROW;
+                any = true;
+            }
+        }
+        return any ? ChunkState::Mixed : ChunkState::Free;
+    };
+    return writeChunkedMap(path, width, height, zone, racks);
+}
+//One headless tick; scenario runs and replays share it so both step the same way
+std::size_t scenarioTick(OccupancyGrid& grid, RobotFleet& fleet, ParallelTicker* ticker){
+    if(ChunkedWorld* chunks = grid.chunked()){
+        //keep the map tiles around every robot in memory, as far as the longest move
+        for(int k = 0; k < ROBOT_KIND_COUNT; ++k){
+            const FleetColumns& g = fleet.group(static_cast<RobotKind>(k));
+            chunks->track(g.x.data(), g.y.data(), g.size(), maxKindStep());
+        }
+        chunks->trim();
+    }
+    return ticker ? ticker->tick(fleet, grid) : fleet.step(grid);
+}
+
+//Headless batch run: robot_sim --scenario file.txt
+//Builds the world and a data-oriented fleet from the file, runs every tick
+//without any I/O and reports throughput plus a hash of the final state.
+//Keys (see scenarios/example.txt):
+//  world W H            size (default 100 100)
+//  obstacle X Y         one blocked cell, any number of lines
+//  random_obstacles N   N blocked cells at random places
+//  robots KIND N        KIND = wheeled / legged / flying, any number of lines
+//  spawn random|origin  where robots start (default random free cells)
+//  battery B            starting battery (default 100)
+//  recharge_every N     refill every battery every N ticks (0 = never)
+//  ticks N              how many ticks (default 1000)
+//  threads N            0 = plain step, N > 0 = collision-aware parallel tick
+//  seed S               random seed (default 1)
+//  map PATH             stream the world from a chunked map file (its size
+//                       replaces `world`); obstacle lines are edits on top
+//  make_map warehouse   first write a warehouse layout of `world` size to PATH
+//                       (kept if PATH already holds a map of that size)
+//  tile_cache N         map tiles kept in memory (default 65536, 0.5 KB each)
+//  proximity R          after every tick, find each robot's neighbours within R
+//  nearest K            at the end, find each robot's K nearest robots
+//  event T obstacle X Y block cell (X, Y) at the start of tick T (any number of lines)
+//  event T clear X Y    free cell (X, Y) at the start of tick T
+//  checkpoint_every N   save the whole state every N ticks (0 = never)
+//  checkpoint PREFIX    checkpoint files are PREFIX_<tick>.ckpt (default robot_sim)
+//  command_log PATH     record every recharge and event (default PREFIX.cmdlog
+//                       when checkpointing); replay with robot_sim --replay
+int runScenario(const std::string& path){
+    ScenarioFile sc;
+    if(!sc.load(path)) return 1;
+    const int width = static_cast<int>(sc.getInt("world", 0, 100));
+    const int height = static_cast<int>(sc.getInt("world", 1, 100));
+    const long long randomObstacles = sc.getInt("random_obstacles", 0, 0);
+    const int battery = static_cast<int>(sc.getInt("battery", 0, 100));
+    const long long rechargeEvery = sc.getInt("recharge_every", 0, 0);
+    const long long ticks = sc.getInt("ticks", 0, 1000);
+    const int threads = static_cast<int>(sc.getInt("threads", 0, 0));
+    const bool spawnRandom = sc.getString("spawn", 0, "random") != "origin";
+    std::mt19937_64 rng(static_cast<std::uint64_t>(sc.getInt("seed", 0, 1)));
+    const std::string mapPath = sc.getString("map");
+    const long long tileCache = sc.getInt("tile_cache", 0, 65536);
+    const long long proximityRadius = sc.getInt("proximity", 0, -1); //-1 = off
+    const long long nearestK = sc.getInt("nearest", 0, 0);
+    const long long checkpointEvery = sc.getInt("checkpoint_every", 0, 0);
+    const std::string checkpointPrefix = sc.getString("checkpoint", 0, "robot_sim");
+    std::string commandLogPath = sc.getString("command_log");
+    if(commandLogPath.empty() && checkpointEvery > 0) commandLogPath = checkpointPrefix + ".cmdlog";
+    if(width <= 0 || height <= 0 || ticks < 0 || threads < 0 || threads > 256 || tileCache < 0
+       || proximityRadius < -1 || proximityRadius > 1000000 || nearestK < 0 || nearestK > 1000
+       || checkpointEvery < 0){
+        std::cout << path << ": world size, ticks, threads, tile_cache, proximity, nearest or checkpoint_every out of range\n";
+        return 1;
+    }
+    //scheduled world edits, in tick order (lines of the same tick keep their order)
+    std::vector<SimCommand> events;
+    for(const auto& args : sc.all("event")){
+        if(args.size() < 4 || (args[1] != "obstacle" && args[1] != "clear")){
+            std::cout << path << ": event needs T obstacle|clear X Y\n";
+            return 1;
+        }
+        SimCommand c{};
+        c.tick = static_cast<std::uint64_t>(std::atoll(args[0].c_str()));
+        c.op = args[1] == "obstacle" ? SimOp::SetObstacle : SimOp::ClearObstacle;
+        c.x = std::atoi(args[2].c_str());
+        c.y = std::atoi(args[3].c_str());
+        events.push_back(c);
+    }
+    std::stable_sort(events.begin(), events.end(), [](const SimCommand& a, const SimCommand& b){ return a.tick < b.tick; });
+
+    auto obstacleLines = sc.all("obstacle");
+    OccupancyGrid grid;
+    if(mapPath.empty()){
+        grid = OccupancyGrid(width, height,
+                             OccupancyGrid::chooseMode(width, height, obstacleLines.size() + randomObstacles));
+    }
+    else{
+        const std::string generator = sc.getString("make_map");
+        if(generator == "warehouse"){
+            //writing takes seconds for a huge world; reuse a map of the right size
+            bool reuse;
+            {
+                ChunkedWorld existing(mapPath, 0); //unmapped again before a rewrite
+                reuse = existing.isOpen() && existing.getWidth() == width && existing.getHeight() == height;
+            }
+            if(!reuse && !makeWarehouseMap(mapPath, width, height)){
+                std::cout << path << ": cannot write map " << mapPath << "\n";
+                return 1;
+            }
+        }
+        else if(!generator.empty()){
+            std::cout << path << ": unknown map generator '" << generator << "'\n";
+            return 1;
+        }
+        auto chunks = std::make_unique<ChunkedWorld>(mapPath, static_cast<std::size_t>(tileCache));
+        if(!chunks->isOpen()){
+            std::cout << path << ": cannot open map " << mapPath << "\n";
+            return 1;
+        }
+        grid = OccupancyGrid(std::move(chunks));
+    }
+    //the parallel tick keeps per-tile arrays for the whole world
+    if(threads > 0 && (static_cast<std::uint64_t>(grid.getWidth()) / 64 + 1) * (grid.getHeight() / 64 + 1) > (1u << 24)){
+        std::cout << path << ": world too big for threads > 0, use the plain step (threads 0)\n";
+        return 1;
+    }
+    const int worldW = grid.getWidth();
+    const int worldH = grid.getHeight();
+    for(const auto& args : obstacleLines){
+        if(args.size() >= 2) grid.set(std::atoi(args[0].c_str()), std::atoi(args[1].c_str()));
+    }
+    for(long long i = 0; i < randomObstacles; ++i){
+        grid.set(static_cast<int>(rng() % worldW), static_cast<int>(rng() % worldH));
+    }
+
+    //check every robots line before spawning any
+    long long totalRobots = 0;
+    for(const auto& args : sc.all("robots")){
+        if(args.size() < 2) continue;
+        long long count = std::atoll(args[1].c_str());
+        //ids are 32-bit; far below that the columns would not fit in memory anyway
+        const long long MAX_ROBOTS = 100000000;
+        totalRobots += count > 0 ? count : 0;
+        if(count <= 0 || totalRobots > MAX_ROBOTS){
+            std::cout << path << ": robots " << args[0] << " " << args[1] << " out of range (1 to "
+                      << MAX_ROBOTS << " robots in total)\n";
+            return 1;
+        }
+    }
+    RobotFleet fleet;
+    long long perKind[ROBOT_KIND_COUNT] = {};
+    for(const auto& args : sc.all("robots")){
+        if(args.size() < 2) continue;
+        RobotKind kind;
+        if(!kindFromName(args[0], kind)){
+            std::cout << path << ": unknown robot kind '" << args[0] << "'\n";
+            return 1;
+        }
+        long long count = std::atoll(args[1].c_str());
+        fleet.reserve(kind, static_cast<std::size_t>(perKind[static_cast<int>(kind)] + count));
+        for(long long i = 0; i < count; ++i){
+            int x = 0;
+            int y = 0;
+            //a few tries for a free cell, crowded maps may still start on an obstacle
+            for(int tries = 0; spawnRandom && tries < 16; ++tries){
+                x = static_cast<int>(rng() % worldW);
+                y = static_cast<int>(rng() % worldH);
+                if(!grid.isBlocked(x, y)) break;
+            }
+            fleet.spawn(kind, x, y, battery);
+        }
+        perKind[static_cast<int>(kind)] += count;
+    }
+
+    std::unique_ptr<ParallelTicker> ticker;
+    if(threads > 0) ticker = std::make_unique<ParallelTicker>(threads);
+    std::size_t moves = 0;
+    ProximityGrid proximity(static_cast<int>(std::max(1ll, proximityRadius))); //cell = radius: 3x3 cells per query
+    ProximityResult neighbourSet;
+    std::size_t neighbours = 0;
+    double proximitySeconds = 0;
+    //every input goes through issue(), so the command log sees all of them
+    std::unique_ptr<CommandLogWriter> commandLog;
+    if(!commandLogPath.empty()){
+        commandLog = std::make_unique<CommandLogWriter>(commandLogPath);
+        if(!commandLog->isOpen()){
+            std::cout << path << ": cannot write command log " << commandLogPath << "\n";
+            return 1;
+        }
+    }
+    std::uint64_t worldVersion = 0; //bumped by every world edit, see CheckpointWriter
+    auto issue = [&](const SimCommand& c){
+        applyCommand(c, grid, fleet);
+        if(c.op != SimOp::Recharge) ++worldVersion;
+        if(commandLog) commandLog->append(c);
+    };
+    std::unique_ptr<CheckpointWriter> checkpoints;
+    if(checkpointEvery > 0) checkpoints = std::make_unique<CheckpointWriter>(mapPath, static_cast<std::size_t>(tileCache));
+    double captureSeconds = 0;
+    auto capture = [&](long long t){
+        auto c0 = std::chrono::steady_clock::now();
+        if(commandLog) commandLog->flush(); //the log must reach at least as far as the checkpoint
+        checkpoints->capture(checkpointPrefix + "_" + std::to_string(t) + ".ckpt", static_cast<std::uint64_t>(t),
+                             static_cast<std::uint32_t>(threads), grid, worldVersion, fleet);
+        captureSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - c0).count();
+    };
+    std::size_t nextEvent = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(long long t = 0; t < ticks; ++t){
+        if(checkpoints && t > 0 && t % checkpointEvery == 0) capture(t);
+        if(rechargeEvery > 0 && t > 0 && t % rechargeEvery == 0){
+            SimCommand c{};
+            c.tick = static_cast<std::uint64_t>(t);
+            c.op = SimOp::Recharge;
+            c.value = battery;
+            issue(c);
+        }
+        for(; nextEvent < events.size() && events[nextEvent].tick <= static_cast<std::uint64_t>(t); ++nextEvent){
+            SimCommand c = events[nextEvent];
+            c.tick = static_cast<std::uint64_t>(t);
+            issue(c);
+        }
+        {
+            METRICS_SCOPE("sim_tick");
+            moves += scenarioTick(grid, fleet, ticker.get());
+        }
+        //timed on its own and left out of the tick rates below
+        if(proximityRadius >= 0){
+            METRICS_SCOPE("proximity");
+            auto p0 = std::chrono::steady_clock::now();
+            proximity.build(fleet);
+            proximity.radiusAll(static_cast<int>(proximityRadius), neighbourSet, ticker ? &ticker->threadPool() : nullptr);
+            neighbours += neighbourSet.hits.size();
+            proximitySeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - p0).count();
+        }
+    }
+    if(checkpoints && ticks > 0 && ticks % checkpointEvery == 0) capture(ticks);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if(seconds <= 0) seconds = 1e-9;
+    //the rates cover stepping only, so runs with and without proximity compare
+    double tickSeconds = seconds - proximitySeconds;
+    if(tickSeconds <= 0) tickSeconds = 1e-9;
+    if(commandLog) commandLog->flush();
+    if(checkpoints) checkpoints->wait();
+
+    const std::uint64_t hash = fleetStateHash(fleet);
+    const double robotSteps = static_cast<double>(fleet.size()) * ticks;
+    std::cout << "=== Scenario " << path << " ===\n";
+    std::cout << "world " << worldW << " x " << worldH << " ("
+              << (grid.getMode() == OccupancyMode::Dense ? "dense" : grid.getMode() == OccupancyMode::Sparse ? "sparse" : "chunked")
+              << "), " << grid.blocked() << " obstacles\n";
+    if(const ChunkedWorld* chunks = grid.chunked()){
+        std::cout << "map " << mapPath << " " << chunks->fileBytes() / 1024.0 << " KB, tiles in memory "
+                  << chunks->cachedTiles() << " (" << chunks->memoryBytes() / (1024.0 * 1024.0) << " MB), loaded "
+                  << chunks->loads() << ", evicted " << chunks->evictions() << "\n";
+    }
+    std::cout << "robots " << fleet.size() << " (";
+    for(int k = 0; k < ROBOT_KIND_COUNT; ++k){
+        std::string name = kindRules(static_cast<RobotKind>(k)).name;
+        for(char& ch : name) ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+        std::cout << (k > 0 ? ", " : "") << name << " " << perKind[k];
+    }
+    std::cout << "), " << ticks << " ticks, "
+              << (ticker ? std::to_string(ticker->threadCount()) + " threads, collision-aware" : std::string("plain step"))
+              << "\n";
+    std::cout << "elapsed " << seconds << " s\n";
+    if(proximityRadius >= 0){
+        std::size_t shared = 0;
+        proximity.forEachShared([&](int, int, const std::uint32_t*, std::size_t count){ shared += count; });
+        std::cout << "proximity r=" << proximityRadius << ": " << (fleet.size() && ticks ? static_cast<double>(neighbours) / robotSteps : 0.0)
+                  << " neighbours per robot per tick, " << shared << " robots sharing a cell at the end, "
+                  << proximitySeconds << " s\n";
+    }
+    if(nearestK > 0){
+        auto n0 = std::chrono::steady_clock::now();
+        proximity.build(fleet);
+        proximity.nearestAll(static_cast<std::size_t>(nearestK), neighbourSet, ticker ? &ticker->threadPool() : nullptr);
+        double nearestSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - n0).count();
+        double sum = 0;
+        std::size_t full = 0; //robots that have K others at all
+        for(std::size_t q = 0; q < neighbourSet.queries(); ++q){
+            if(neighbourSet.count(q) < static_cast<std::size_t>(nearestK)) continue;
+            sum += std::sqrt(static_cast<double>((neighbourSet.end(q) - 1)->dist2));
+            ++full;
+        }
+        std::cout << "nearest k=" << nearestK << ": mean distance to the k-th nearest robot "
+                  << (full ? sum / full : 0.0) << ", " << nearestSeconds << " s\n";
+    }
+    if(checkpoints){
+        std::cout << "checkpoints " << checkpoints->checkpointsWritten() << " written ("
+                  << checkpoints->bytesWritten() / (1024.0 * 1024.0) << " MB), "
+                  << checkpoints->checkpointsFailed() << " failed, " << captureSeconds << " s in the tick loop\n";
+    }
+    if(commandLog) std::cout << "command log " << commandLogPath << ": " << commandLog->size() << " commands\n";
+    std::cout << "ticks/s " << ticks / tickSeconds << "\n";
+    std::cout << "robot-steps/s " << robotSteps / tickSeconds << "\n";
+    std::cout << "robot-moves/s " << moves / tickSeconds << " (" << moves << " moves)\n";
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+    std::cout << "final state hash " << hex << "\n";
+    metricsExport("robot_sim");
+    return 0;
+}
+
+//Replay: robot_sim --replay CHECKPOINT LOG TICK [SAVE]
+//Loads a checkpoint, re-applies the logged commands and steps on to TICK,
+//then prints the state hash (the same one --scenario prints). The tick is
+//deterministic for any thread count, so this lands on the original state.
+//SAVE optionally writes a new checkpoint at TICK.
+int replayRun(const std::string& checkpointPath, const std::string& logPath, long long untilTick,
+              const std::string& savePath){
+    OccupancyGrid grid;
+    RobotFleet fleet;
+    CheckpointInfo info;
+    std::vector<SimCommand> commands;
+    if(!loadCheckpoint(checkpointPath, info, grid, fleet) || !loadCommandLog(logPath, commands)) return 1;
+    const long long startTick = static_cast<long long>(info.header.tick);
+    if(untilTick < startTick){
+        std::cout << checkpointPath << " is at tick " << startTick << ", cannot go back to " << untilTick << "\n";
+        return 1;
+    }
+    std::unique_ptr<ParallelTicker> ticker;
+    if(info.header.threads > 0) ticker = std::make_unique<ParallelTicker>(info.header.threads);
+    //commands before the checkpoint are already in it
+    std::size_t next = 0;
+    while(next < commands.size() && commands[next].tick < info.header.tick) ++next;
+    std::size_t applied = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(long long t = startTick; t < untilTick; ++t){
+        for(; next < commands.size() && commands[next].tick == static_cast<std::uint64_t>(t); ++next, ++applied){
+            applyCommand(commands[next], grid, fleet);
+        }
+        scenarioTick(grid, fleet, ticker.get());
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "replayed " << checkpointPath << " from tick " << startTick << " to " << untilTick << ", "
+              << applied << " commands, " << fleet.size() << " robots, "
+              << (ticker ? std::to_string(ticker->threadCount()) + " threads" : std::string("plain step"))
+              << ", " << seconds << " s\n";
+    if(!savePath.empty()){
+        CheckpointWriter writer(info.mapPath, info.tileBudget);
+        writer.capture(savePath, static_cast<std::uint64_t>(untilTick), info.header.threads, grid, 0, fleet);
+        writer.wait();
+        if(writer.checkpointsWritten() != 1){
+            std::cout << "cannot write checkpoint " << savePath << "\n";
+            return 1;
+        }
+        std::cout << "saved " << savePath << "\n";
+    }
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(fleetStateHash(fleet)));
+    std::cout << "state hash at tick " << untilTick << " " << hex << "\n";
+    return 0;
+}
+//the benchmarks (Benchmark/) include this file and bring their own main
+#ifndef BENCHMARK_BUILD
+int main(int argc, char* argv[]) {
+    //headless batch mode: robot_sim --scenario file.txt
+    if(argc >= 3 && std::string(argv[1]) == "--scenario"){
+        return runScenario(argv[2]);
+    }
+    //resume from a checkpoint: robot_sim --replay CHECKPOINT LOG TICK [SAVE]
+    if(argc >= 5 && std::string(argv[1]) == "--replay"){
+        return replayRun(argv[2], argv[3], std::atoll(argv[4]), argc >= 6 ? argv[5] : "");
+    }
+    //optional world size: robot_sim <width> <height>
+    if(argc >= 3){
+        int width = std::atoi(argv[1]);
+        int height = std::atoi(argv[2]);
+        if(width > 0 && height > 0){
+            world = OccupancyGrid(width, height, OccupancyGrid::chooseMode(width, height, obstacles.size()));
+        }
+    }
+    world.insert(obstacles);
+    view.fitTo(world, VIEW_COLS, VIEW_ROWS);
+    RobotPool pool;
+    pool.spawn(RobotKind::Wheeled);
+    pool.spawn(RobotKind::Legged);
+    pool.spawn(RobotKind::Flying);
+    const RobotList& robots = pool.list();
+    //every run is streamed to a trace file, a chunk after each menu action
+    const std::string TRACE_PATH = "robot_trace.bin";
+    PathTraceFile traceFile(TRACE_PATH);
     
     int choice;
     do {
         displayGrid(robots);
+        logFlush(); //let queued log lines out before the menu
         std::cout << "\n=== Robot Simulator Menu ===\n";
         std::cout << "1. Move robot\n";
         std::cout << "2. Show all status\n";
         std::cout << "3. Autonomous Movement (each robot uses own AI)\n";
-        std::cout << "4. Quit\n";
+        std::cout << "4. Fleet stress test (data-oriented engine)\n";
+        std::cout << "5. Set navigation goal (Legged/Flying AI)\n";
+        std::cout << "6. Live view (autonomous, redraws only what changed)\n";
+        std::cout << "7. Replay path trace file\n";
+        std::cout << "8. Quit\n";
         std::cin >> choice;
         switch(choice){
             case 1 : moveOption(robots);break;
-            case 2 : for (const auto& r : robots) r->showStatus();break;
-            case 3 : autonomousMovement(robots);break;
-            case 4 : std::cout << "Goodbye!\n"; break;
+            case 2 : for (const auto& r : robots) r->showStatus();
+                     showSharedCells(robots);break;
+            case 3 : autonomousMovement(pool);break;
+            case 4 : fleetStressTest(robots);break;
+            case 5 : setGoalOption(robots);break;
+            case 6 : liveView(pool);break;
+            case 7 : traceFile.flush(); replayTrace(TRACE_PATH);break;
+            case 8 : std::cout << "Goodbye!\n"; break;
         }
+        for(Robot* r : robots) r->exportPath(traceFile);
         //std::cout << "Choice: ";
         
         
@@ -373,7 +1024,9 @@ int main() {
                 break;
         }
                 */
-    } while (choice != 4);
+    } while (choice != 8);
+    metricsExport("robot_sim");
 
     return 0;
-}
\ No newline at end of file
+}
+#endif
@@ -0,0 +1,488 @@
+//sim_checkpoint.h
+//Checkpoints and a command log for the headless scenario runs.
+//
+//A checkpoint holds the whole simulation at the start of one tick: the world
+//(obstacles) and every robot of the fleet. The command log records every input
+//applied to the run afterwards (recharges, obstacle edits), each with its tick.
+//A checkpoint plus the log reproduce the run from that tick on, bit for bit,
+//because a tick only depends on this state and these commands.
+//
+//Checkpoint file (native little-endian, every section 8-byte aligned):
+//  CheckpointHeader                    magic "ROBOCKP", version, tick, stepping,
+//                                      fleet hash, FNV-1a checksum of what follows
+//  CheckpointWorld                     mode, size, map file, counts
+//    char    mapPath[]                 chunked worlds: the map file the edits sit on
+//    int32_t cells[cellCount][2]       dense / sparse: every blocked cell (x, y)
+//    CheckpointTile tiles[tileCount]   chunked: every edited tile
+//  uint64_t robotCount
+//    uint8_t kind[n], int32_t x[n], y[n], battery[n]    one column each, by fleet id
+//
+//Command log: CommandLogHeader, then one SimCommand per applied input.
+//
+//Taking a checkpoint must not stall the tick loop, so capture() only copies
+//what the next tick will overwrite and a background thread does the rest:
+//  - fleet columns: copied (a memcpy per column). Every tick rewrites nearly all
+//    of them, so sharing them copy-on-write would only move the same copy into
+//    the next tick.
+//  - world: serialized once into an immutable image that every checkpoint
+//    shares until the world is edited (copy-on-write). A world that never
+//    changes is never copied again.
+//  - ordering by id, hashing, checksumming and writing run on the writer thread.
+#ifndef SIM_CHECKPOINT_H
+#define SIM_CHECKPOINT_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>    // for std::rename, std::remove
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "occupancy_grid.h"
+#include "robot_fleet.h"
+#include "../Common/scenario_file.h" // fnv1a
+
+const std::uint32_t CHECKPOINT_VERSION = 1;
+const std::uint32_t COMMAND_LOG_VERSION = 1;
+
+struct CheckpointHeader{
+    char magic[8];               // "ROBOCKP\0"
+    std::uint32_t version;
+    std::uint32_t threads;       // 0 = plain step, N = collision-aware tick
+    std::uint64_t tick;          // ticks done before this state
+    std::uint64_t fleetHash;     // fleetStateHash() of the saved fleet
+    std::uint64_t payloadBytes;  // bytes after the header
+    std::uint64_t checksum;      // fnv1a of those bytes
+};
+struct CheckpointWorld{
+    std::uint32_t mode;          // OccupancyMode
+    std::int32_t width;
+    std::int32_t height;
+    std::uint32_t mapPathLength; // chunked: 0 = no map file
+    std::uint64_t cellCount;
+    std::uint64_t tileCount;
+    std::uint64_t tileBudget;    // chunked: tile cache size
+};
+struct CheckpointTile{
+    std::int32_t x0;             // first cell of the tile
+    std::int32_t y0;
+    std::uint64_t rows[CHUNK_TILE];
+};
+static_assert(sizeof(CheckpointHeader) % 8 == 0, "header must keep sections 8-byte aligned");
+static_assert(sizeof(CheckpointWorld) % 8 == 0, "world section must stay 8-byte aligned");
+static_assert(sizeof(CheckpointTile) % 8 == 0, "tiles must stay 8-byte aligned");
+
+enum class SimOp : std::uint32_t {Recharge = 1, SetObstacle = 2, ClearObstacle = 3};
+struct SimCommand{
+    std::uint64_t tick;          // applied at the start of this tick
+    SimOp op;
+    std::int32_t x;              // obstacle cell
+    std::int32_t y;
+    std::int32_t value;          // Recharge: the new battery level
+};
+struct CommandLogHeader{
+    char magic[8];               // "ROBOCMD\0"
+    std::uint32_t version;
+    std::uint32_t reserved;
+};
+static_assert(sizeof(SimCommand) == 24, "command records are written as raw bytes");
+
+//Hash of every robot's (x, y, battery) in id order; equal hashes = equal runs
+inline std::uint64_t fleetStateHash(const RobotFleet& fleet){
+    std::uint64_t hash = fnv1a(nullptr, 0);
+    for(std::uint32_t id = 0; id < fleet.size(); ++id){
+        int state[3] = {fleet.getX(id), fleet.getY(id), fleet.getBattery(id)};
+        hash = fnv1a(state, sizeof(state), hash);
+    }
+    return hash;
+}
+
+//Apply one logged input to the simulation
+inline void applyCommand(const SimCommand& c, OccupancyGrid& world, RobotFleet& fleet){
+    switch(c.op){
+        case SimOp::Recharge:
+            for(int k = 0; k < ROBOT_KIND_COUNT; ++k){
+                auto& column = fleet.group(static_cast<RobotKind>(k)).battery;
+                std::fill(column.begin(), column.end(), c.value);
+            }
+            break;
+        case SimOp::SetObstacle: world.set(c.x, c.y); break;
+        case SimOp::ClearObstacle: world.clear(c.x, c.y); break;
+    }
+}
+
+inline std::size_t checkpointPad8(std::size_t n){return (n + 7) & ~std::size_t(7);}
+
+//Serialized world section (CheckpointWorld and what follows it)
+inline std::shared_ptr<const std::vector<std::uint8_t>> checkpointWorldImage(const OccupancyGrid& world,
+        const std::string& mapPath, std::size_t tileBudget){
+    auto image = std::make_shared<std::vector<std::uint8_t>>(sizeof(CheckpointWorld));
+    CheckpointWorld w{};
+    w.mode = static_cast<std::uint32_t>(world.getMode());
+    w.width = world.getWidth();
+    w.height = world.getHeight();
+    auto append = [&](const void* data, std::size_t size){
+        const std::uint8_t* bytes = static_cast<const std::uint8_t*>(data);
+        image->insert(image->end(), bytes, bytes + size);
+    };
+    if(const ChunkedWorld* chunks = world.chunked()){
+        const std::string path = chunks->isOpen() ? mapPath : std::string();
+        w.mapPathLength = static_cast<std::uint32_t>(path.size());
+        w.tileBudget = tileBudget;
+        append(path.data(), path.size());
+        image->resize(checkpointPad8(image->size()));
+        chunks->forEachEditedTile([&](int x0, int y0, const std::uint64_t* rows){
+            CheckpointTile tile;
+            tile.x0 = x0;
+            tile.y0 = y0;
+            std::memcpy(tile.rows, rows, sizeof(tile.rows));
+            append(&tile, sizeof(tile));
+            ++w.tileCount;
+        });
+    }
+    else{
+        world.forEachBlocked([&](int x, int y){
+            std::int32_t cell[2] = {x, y};
+            append(cell, sizeof(cell));
+            ++w.cellCount;
+        });
+    }
+    std::memcpy(image->data(), &w, sizeof(w));
+    return image;
+}
+
+//Writes checkpoints on a background thread. At most one checkpoint waits while
+//another is written; capture() blocks only if both are still busy.
+class CheckpointWriter{
+    private:
+        struct Job{
+            std::string path;
+            std::uint64_t tick = 0;
+            std::uint32_t threads = 0;
+            std::shared_ptr<const std::vector<std::uint8_t>> world;
+            FleetColumns columns[ROBOT_KIND_COUNT]; //copies, buffers reused between jobs
+        };
+        Job staging;  //filled by capture()
+        Job pending;  //handed over, not yet taken by the writer
+        bool hasPending = false;
+        bool busy = false; //the writer is working on a job
+        bool stopping = false;
+        mutable std::mutex mtx;
+        std::condition_variable wake;
+        std::condition_variable taken;
+        std::thread writer;
+
+        std::shared_ptr<const std::vector<std::uint8_t>> worldImage;
+        std::uint64_t worldImageVersion = ~0ull;
+        std::string mapPath;
+        std::size_t tileBudget;
+        std::uint64_t written = 0;
+        std::uint64_t failed = 0;
+        std::uint64_t bytes = 0;
+
+        void writerLoop(){
+            Job job;
+            std::vector<std::uint8_t> out;
+            while(true){
+                {
+                    std::unique_lock<std::mutex> lock(mtx);
+                    wake.wait(lock, [&]{ return stopping || hasPending; });
+                    if(!hasPending) return;
+                    std::swap(job, pending);
+                    hasPending = false;
+                    busy = true;
+                }
+                taken.notify_all();
+                bool ok = writeJob(job, out);
+                std::lock_guard<std::mutex> lock(mtx);
+                busy = false;
+                if(ok){
+                    ++written;
+                    bytes += out.size();
+                }
+                else ++failed;
+                taken.notify_all();
+            }
+        }
+        static bool writeJob(const Job& job, std::vector<std::uint8_t>& out){
+            std::size_t n = 0;
+            for(const auto& c : job.columns) n += c.size();
+            //columns back in id order
+            std::vector<std::uint8_t> kinds(checkpointPad8(n), 0);
+            std::vector<std::int32_t> xs(n), ys(n), battery(n);
+            for(int k = 0; k < ROBOT_KIND_COUNT; ++k){
+                const FleetColumns& c = job.columns[k];
+                for(std::size_t row = 0; row < c.size(); ++row){
+                    const std::uint32_t id = c.id[row];
+                    if(id >= n) return false;
+                    kinds[id] = static_cast<std::uint8_t>(k);
+                    xs[id] = c.x[row];
+                    ys[id] = c.y[row];
+                    battery[id] = c.battery[row];
+                }
+            }
+            std::uint64_t hash = fnv1a(nullptr, 0);
+            for(std::size_t id = 0; id < n; ++id){
+                int state[3] = {xs[id], ys[id], battery[id]};
+                hash = fnv1a(state, sizeof(state), hash);
+            }
+            out.clear();
+            out.resize(sizeof(CheckpointHeader));
+            auto append = [&](const void* data, std::size_t size){
+                const std::uint8_t* b = static_cast<const std::uint8_t*>(data);
+                out.insert(out.end(), b, b + size);
+                out.resize(checkpointPad8(out.size()));
+            };
+            append(job.world->data(), job.world->size());
+            std::uint64_t count = n;
+            append(&count, sizeof(count));
+            append(kinds.data(), kinds.size());
+            append(xs.data(), n * sizeof(std::int32_t));
+            append(ys.data(), n * sizeof(std::int32_t));
+            append(battery.data(), n * sizeof(std::int32_t));
+            CheckpointHeader header{};
+            std::memcpy(header.magic, "ROBOCKP", 8);
+            header.version = CHECKPOINT_VERSION;
+            header.threads = job.threads;
+            header.tick = job.tick;
+            header.fleetHash = hash;
+            header.payloadBytes = out.size() - sizeof(header);
+            header.checksum = fnv1a(out.data() + sizeof(header), header.payloadBytes);
+            std::memcpy(out.data(), &header, sizeof(header));
+            //write next to the target, then rename: a crash never leaves half a checkpoint
+            const std::string temp = job.path + ".tmp";
+            {
+                std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+                file.write(reinterpret_cast<const char*>(out.data()), static_cast<std::streamsize>(out.size()));
+                if(!file) return false;
+            }
+            std::remove(job.path.c_str());
+            return std::rename(temp.c_str(), job.path.c_str()) == 0;
+        }
+    public:
+        //mapPath / budget describe a chunked world (its map file and tile cache size)
+        explicit CheckpointWriter(std::string map = "", std::size_t budget = 65536)
+            : mapPath(std::move(map)), tileBudget(budget){
+            writer = std::thread(&CheckpointWriter::writerLoop, this);
+        }
+        ~CheckpointWriter(){
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                stopping = true;
+            }
+            wake.notify_all();
+            writer.join(); //the writer finishes a pending checkpoint first
+        }
+        CheckpointWriter(const CheckpointWriter&) = delete;
+        CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    //Snapshot the state at the start of `tick` and write it to path in the
+    //background. worldVersion must change whenever the world is edited.
+    void capture(const std::string& path, std::uint64_t tick, std::uint32_t threads,
+                 const OccupancyGrid& world, std::uint64_t worldVersion, const RobotFleet& fleet){
+        if(worldVersion != worldImageVersion){
+            worldImage = checkpointWorldImage(world, mapPath, tileBudget);
+            worldImageVersion = worldVersion;
+        }
+        staging.path = path;
+        staging.tick = tick;
+        staging.threads = threads;
+        staging.world = worldImage;
+        for(int k = 0; k < ROBOT_KIND_COUNT; ++k){
+            const FleetColumns& from = fleet.group(static_cast<RobotKind>(k));
+            FleetColumns& to = staging.columns[k];
+            to.x.assign(from.x.begin(), from.x.end());
+            to.y.assign(from.y.begin(), from.y.end());
+            to.battery.assign(from.battery.begin(), from.battery.end());
+            to.id.assign(from.id.begin(), from.id.end());
+        }
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            taken.wait(lock, [&]{ return !hasPending; });
+            std::swap(staging, pending);
+            hasPending = true;
+        }
+        wake.notify_one();
+    }
+    //Wait until every captured checkpoint is on disk
+    void wait(){
+        std::unique_lock<std::mutex> lock(mtx);
+        taken.wait(lock, [&]{ return !hasPending && !busy; });
+    }
+    std::uint64_t checkpointsWritten() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return written;
+    }
+    std::uint64_t checkpointsFailed() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return failed;
+    }
+    std::uint64_t bytesWritten() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return bytes;
+    }
+};
+
+//What a checkpoint says about itself besides world and fleet
+struct CheckpointInfo{
+    CheckpointHeader header;
+    std::string mapPath;         // chunked world: its map file ("" = none)
+    std::size_t tileBudget = 0;
+};
+//Read a checkpoint into world and fleet (both replaced). Returns false and
+//says why if the file is missing, damaged or from another version.
+inline bool loadCheckpoint(const std::string& path, CheckpointInfo& info,
+                           OccupancyGrid& world, RobotFleet& fleet){
+    CheckpointHeader& header = info.header;
+    std::ifstream in(path, std::ios::binary);
+    std::vector<std::uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if(!in.eof() && !in){
+        std::cout << path << ": cannot read checkpoint\n";
+        return false;
+    }
+    if(data.size() < sizeof(header)){
+        std::cout << path << ": not a checkpoint\n";
+        return false;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+    if(std::memcmp(header.magic, "ROBOCKP", 8) != 0 || header.version != CHECKPOINT_VERSION){
+        std::cout << path << ": not a version " << CHECKPOINT_VERSION << " checkpoint\n";
+        return false;
+    }
+    if(header.payloadBytes != data.size() - sizeof(header)
+       || header.checksum != fnv1a(data.data() + sizeof(header), header.payloadBytes)){
+        std::cout << path << ": checkpoint is damaged (size or checksum)\n";
+        return false;
+    }
+    std::size_t pos = sizeof(header);
+    //read `size` bytes, then skip to the next 8-byte boundary
+    auto take = [&](void* to, std::size_t size){
+        if(size > data.size() - pos) return false;
+        std::memcpy(to, data.data() + pos, size);
+        pos = std::min(data.size(), checkpointPad8(pos + size));
+        return true;
+    };
+    CheckpointWorld w;
+    if(!take(&w, sizeof(w)) || w.width < 0 || w.height < 0 || w.mode > static_cast<std::uint32_t>(OccupancyMode::Chunked)){
+        std::cout << path << ": bad world section\n";
+        return false;
+    }
+    const OccupancyMode mode = static_cast<OccupancyMode>(w.mode);
+    if(mode == OccupancyMode::Chunked){
+        std::string mapPath(w.mapPathLength, '\0');
+        if(!take(&mapPath[0], mapPath.size())){
+            std::cout << path << ": bad world section\n";
+            return false;
+        }
+        info.mapPath = mapPath;
+        info.tileBudget = static_cast<std::size_t>(w.tileBudget);
+        std::unique_ptr<ChunkedWorld> chunks;
+        if(mapPath.empty()) chunks = std::make_unique<ChunkedWorld>(w.width, w.height, w.tileBudget);
+        else{
+            chunks = std::make_unique<ChunkedWorld>(mapPath, w.tileBudget);
+            if(!chunks->isOpen() || chunks->getWidth() != w.width || chunks->getHeight() != w.height){
+                std::cout << path << ": map " << mapPath << " is missing or has another size\n";
+                return false;
+            }
+        }
+        for(std::uint64_t i = 0; i < w.tileCount; ++i){
+            CheckpointTile tile;
+            if(!take(&tile, sizeof(tile)) || !chunks->writeTile(tile.x0, tile.y0, tile.rows)){
+                std::cout << path << ": bad world tile\n";
+                return false;
+            }
+        }
+        world = OccupancyGrid(std::move(chunks));
+    }
+    else{
+        world = OccupancyGrid(w.width, w.height, mode);
+        if(w.cellCount > (data.size() - pos) / 8){
+            std::cout << path << ": bad world section\n";
+            return false;
+        }
+        for(std::uint64_t i = 0; i < w.cellCount; ++i){
+            std::int32_t cell[2];
+            std::memcpy(cell, data.data() + pos + i * 8, sizeof(cell));
+            world.set(cell[0], cell[1]);
+        }
+        pos += static_cast<std::size_t>(w.cellCount) * 8;
+    }
+    std::uint64_t n = 0;
+    if(!take(&n, sizeof(n)) || n > (data.size() - pos) / 13){
+        std::cout << path << ": bad fleet section\n";
+        return false;
+    }
+    std::vector<std::uint8_t> kinds(n);
+    std::vector<std::int32_t> xs(n), ys(n), battery(n);
+    if(!take(kinds.data(), kinds.size()) || !take(xs.data(), n * 4) || !take(ys.data(), n * 4)
+       || !take(battery.data(), n * 4)){
+        std::cout << path << ": bad fleet section\n";
+        return false;
+    }
+    fleet.clear();
+    //spawning in id order rebuilds the same columns and rows as the saved fleet
+    for(std::uint64_t id = 0; id < n; ++id){
+        if(kinds[id] >= ROBOT_KIND_COUNT){
+            std::cout << path << ": bad robot kind\n";
+            return false;
+        }
+        fleet.spawn(static_cast<RobotKind>(kinds[id]), xs[id], ys[id], battery[id]);
+    }
+    if(fleetStateHash(fleet) != header.fleetHash){
+        std::cout << path << ": fleet does not match its hash\n";
+        return false;
+    }
+    return true;
+}
+
+//Append-only command log; every record is in the OS's hands once flush() returns
+class CommandLogWriter{
+    private:
+        std::ofstream out;
+        std::uint64_t count = 0;
+    public:
+        explicit CommandLogWriter(const std::string& path) : out(path, std::ios::binary | std::ios::trunc){
+            CommandLogHeader header{};
+            std::memcpy(header.magic, "ROBOCMD", 8);
+            header.version = COMMAND_LOG_VERSION;
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        }
+    bool isOpen() const {return static_cast<bool>(out);}
+    void append(const SimCommand& c){
+        out.write(reinterpret_cast<const char*>(&c), sizeof(c));
+        ++count;
+    }
+    void flush(){out.flush();}
+    std::uint64_t size() const {return count;}
+};
+
+//Every command of a log, in the order they were applied
+inline bool loadCommandLog(const std::string& path, std::vector<SimCommand>& commands){
+    std::ifstream in(path, std::ios::binary);
+    CommandLogHeader header{};
+    if(!in.read(reinterpret_cast<char*>(&header), sizeof(header))
+       || std::memcmp(header.magic, "ROBOCMD", 8) != 0 || header.version != COMMAND_LOG_VERSION){
+        std::cout << path << ": not a version " << COMMAND_LOG_VERSION << " command log\n";
+        return false;
+    }
+    commands.clear();
+    SimCommand c;
+    while(in.read(reinterpret_cast<char*>(&c), sizeof(c))){
+        if(!commands.empty() && c.tick < commands.back().tick){
+            std::cout << path << ": commands out of tick order\n";
+            return false;
+        }
+        commands.push_back(c);
+    }
+    //a half-written last record (the run was killed) is ignored
+    return true;
+}
+
+#endif
@@ -0,0 +1,148 @@
+//lockfree_queue.h
+//Bounded lock-free queues for passing messages between threads.
+//  SpscQueue - one producer thread, one consumer thread
+//  MpscQueue - many producer threads, one consumer thread
+//Neither queue ever allocates after construction and nobody waits on a mutex:
+//a full queue makes tryPush() return false, an empty one makes tryPop() return false.
+//The head and tail indices live on separate cache lines so producer and
+//consumer don't keep stealing the same line from each other (false sharing).
+#ifndef LOCKFREE_QUEUE_H
+#define LOCKFREE_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+const std::size_t CACHE_LINE = 64;
+
+//Round up to a power of two so "index & mask" replaces "index % capacity"
+inline std::size_t roundUpPow2(std::size_t n){
+    std::size_t p = 1;
+    while(p < n) p <<= 1;
+    return p;
+}
+
+//alignas on the class pads the object to whole cache lines, so whatever is
+//allocated next to it can't share a line with the indices either
+template <typename T>
+class alignas(CACHE_LINE) SpscQueue{
+    private:
+        std::vector<T> slots;
+        std::size_t mask;
+        //written by the consumer, read by the producer
+        alignas(CACHE_LINE) std::atomic<std::size_t> head{0};
+        std::size_t cachedTail = 0; //consumer's last look at tail
+        //written by the producer, read by the consumer
+        alignas(CACHE_LINE) std::atomic<std::size_t> tail{0};
+        std::size_t cachedHead = 0; //producer's last look at head
+    public:
+        explicit SpscQueue(std::size_t capacity)
+            : slots(roundUpPow2(capacity < 2 ? 2 : capacity)), mask(slots.size() - 1){}
+        SpscQueue(const SpscQueue&) = delete;
+        SpscQueue& operator=(const SpscQueue&) = delete;
+
+    std::size_t capacity() const {return slots.size();}
+    //Producer side
+    bool tryPush(const T& value){
+        std::size_t t = tail.load(std::memory_order_relaxed);
+        if(t - cachedHead == slots.size()){
+            cachedHead = head.load(std::memory_order_acquire); //only reload when it looks full
+            if(t - cachedHead == slots.size()) return false;
+        }
+        slots[t & mask] = value;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+    //Consumer side
+    bool tryPop(T& out){
+        std::size_t h = head.load(std::memory_order_relaxed);
+        if(h == cachedTail){
+            cachedTail = tail.load(std::memory_order_acquire);
+            if(h == cachedTail) return false;
+        }
+        out = slots[h & mask];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+    //Consumer side: take up to maxCount items with one index update
+    std::size_t popBatch(T* out, std::size_t maxCount){
+        std::size_t h = head.load(std::memory_order_relaxed);
+        cachedTail = tail.load(std::memory_order_acquire);
+        std::size_t n = cachedTail - h;
+        if(n > maxCount) n = maxCount;
+        for(std::size_t i = 0; i < n; ++i) out[i] = slots[(h + i) & mask];
+        head.store(h + n, std::memory_order_release);
+        return n;
+    }
+    //Approximate, only exact when both sides are idle
+    std::size_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+};
+
+//Bounded queue after Dmitry Vyukov's design: every slot carries a sequence
+//number that tells producers and the consumer whose turn it is.
+template <typename T>
+class alignas(CACHE_LINE) MpscQueue{
+    private:
+        struct Slot{
+            std::atomic<std::size_t> sequence;
+            T value;
+        };
+        std::unique_ptr<Slot[]> slots;
+        std::size_t size_;
+        std::size_t mask;
+        alignas(CACHE_LINE) std::atomic<std::size_t> tail{0}; //shared by producers
+        alignas(CACHE_LINE) std::size_t head = 0;             //consumer only
+    public:
+        explicit MpscQueue(std::size_t capacity)
+            : size_(roundUpPow2(capacity < 2 ? 2 : capacity)), mask(size_ - 1){
+            slots.reset(new Slot[size_]);
+            for(std::size_t i = 0; i < size_; ++i) slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        MpscQueue(const MpscQueue&) = delete;
+        MpscQueue& operator=(const MpscQueue&) = delete;
+
+    std::size_t capacity() const {return size_;}
+    //Any producer thread
+    bool tryPush(const T& value){
+        std::size_t pos = tail.load(std::memory_order_relaxed);
+        while(true){
+            Slot& slot = slots[pos & mask];
+            std::size_t seq = slot.sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+            if(diff == 0){
+                //slot is free for this position: claim it
+                if(tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)){
+                    slot.value = value;
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if(diff < 0){
+                return false; //full
+            }
+            else{
+                pos = tail.load(std::memory_order_relaxed); //another producer got there first
+            }
+        }
+    }
+    //Consumer thread only
+    bool tryPop(T& out){
+        Slot& slot = slots[head & mask];
+        if(slot.sequence.load(std::memory_order_acquire) != head + 1) return false;
+        out = slot.value;
+        slot.sequence.store(head + size_, std::memory_order_release); //free for the next lap
+        ++head;
+        return true;
+    }
+    //Consumer thread only: take up to maxCount items that are ready, in order
+    std::size_t popBatch(T* out, std::size_t maxCount){
+        std::size_t n = 0;
+        while(n < maxCount && tryPop(out[n])) ++n;
+        return n;
+    }
+};
+
+#endif
@@ -9,19 +9,350 @@
 #include <mutex> //a lock to prevent race conditions
 #include <atomic> //faster and simpler lock for simple types(int,bool)
 #include <chrono> //modern, precise time measurement and sleeping
+#include <random>
+#include <cstdint>
+#include <cstdlib> //for std::atoi
+#include <algorithm>
+#include "lockfree_queue.h" //bounded lock-free SPSC / MPSC queues
+#include "state_snapshot.h" //seqlock snapshot, one writer many readers
+#include "periodic_scheduler.h" //fixed-rate loops on absolute deadlines
+#include "../Common/task_scheduler.h" //work-stealing pool for batch work (analytics)
+#include "../Common/async_logger.h" //LOG_INFO: printing happens on a background thread
+#include "../Common/metrics.h" //timers/histograms, only with -DMETRICS_ENABLED=1
 
-//Shared struct
-struct RobotState{
+//What the robot looks like at one moment (plain data so it can be snapshotted)
+struct RobotTelemetry{
     int positionX = 0;
     int positionY = 0;
     int battery = 100;
     double temperature = 25.0;
-    bool running = true;
-    std::mutex mtx; //hand glove for prevent race conditions
+    std::uint64_t version = 0; //control cycles applied so far
+    std::int64_t timeUs = 0;   //when it was published, same clock as timedNowUs() (Common/timed_stream.h)
+};
+//Shared struct
+//The control thread is the only writer: it changes its own copy and publishes
+//it, readers copy the snapshot. Nobody holds a lock the control loop waits on.
+struct RobotState{
+    RobotTelemetry current; //control thread only
+    SeqlockSnapshot<RobotTelemetry> snapshot;
+    std::atomic<bool> running{true};
 };
 
-void sensorThread(RobotState& state){
+// === messages between threads ===
+using Clock = std::chrono::steady_clock;
+inline std::int64_t nowNs(){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+struct SensorSample{
+    std::uint64_t seq = 0;
+    std::int64_t sentNs = 0; //when it was pushed, for latency measurement
+    double distance = 0.0;   //cm
+    double temperature = 0.0;
+};
+struct LogEvent{
+    enum class Source : std::uint8_t {Sensor, Control} source = Source::Sensor;
+    std::uint64_t seq = 0;
+    std::int64_t sentNs = 0;
+    int positionX = 0;
+    int positionY = 0;
+    int battery = 0;
+    double value = 0.0;
+};
+//Queue hand-off latency seen by one consumer (only that thread writes it)
+struct LatencyStats{
+    std::uint64_t count = 0;
+    std::int64_t totalNs = 0;
+    std::int64_t maxNs = 0;
+    //Returns this hand-off's latency
+    std::int64_t add(std::int64_t sentNs){
+        std::int64_t ns = nowNs() - sentNs;
+        ++count;
+        totalNs += ns;
+        maxNs = std::max(maxNs, ns);
+        return ns;
+    }
+    double averageUs() const {return count ? totalNs / 1000.0 / count : 0.0;}
+};
+// === sensor analytics: batch statistics on the shared task pool ===
+struct WindowSummary{
+    std::size_t samples = 0;
+    double minDistance = 0.0;
+    double maxDistance = 0.0;
+    double meanDistance = 0.0;
+    double meanTemperature = 0.0;
+};
+//The control loop collects every sample it takes; once per window it hands
+//them to the pool and goes on. It never waits for the result: if the last
+//window is still being worked on, it keeps collecting into the next one.
+struct SensorAnalytics{
+    TaskScheduler* pool = nullptr;
+    int windowCycles = 20; //control cycles per window (1 s at 20 Hz)
+    //control thread only
+    int cycles = 0;
+    std::vector<SensorSample> window;
+    TaskHandle pending; //the report task of the window being worked on
+    std::uint64_t deferred = 0; //cycles a full window waited for the previous one
+    //written by the report task; read once pending is done
+    std::uint64_t windows = 0;
+    std::uint64_t samples = 0;
+    WindowSummary last;
+};
+//Split over the pool, each thread keeps its own partial result
+WindowSummary summarizeWindow(TaskScheduler& pool, const std::vector<SensorSample>& window){
+    struct Partial{
+        double minD = 1e300, maxD = -1e300, sumD = 0.0, sumT = 0.0;
+    };
+    std::vector<Partial> partial(pool.size());
+    pool.parallelFor(window.size(), [&](std::size_t begin, std::size_t end, unsigned t){
+        Partial& p = partial[t];
+        for(std::size_t i = begin; i < end; ++i){
+            p.minD = std::min(p.minD, window[i].distance);
+            p.maxD = std::max(p.maxD, window[i].distance);
+            p.sumD += window[i].distance;
+            p.sumT += window[i].temperature;
+        }
+    }, 4096);
+    WindowSummary s;
+    s.samples = window.size();
+    if(window.empty()) return s;
+    Partial total;
+    for(const Partial& p : partial){
+        total.minD = std::min(total.minD, p.minD);
+        total.maxD = std::max(total.maxD, p.maxD);
+        total.sumD += p.sumD;
+        total.sumT += p.sumT;
+    }
+    s.minDistance = total.minD;
+    s.maxDistance = total.maxD;
+    s.meanDistance = total.sumD / window.size();
+    s.meanTemperature = total.sumT / window.size();
+    return s;
+}
+//Called once per control cycle, after the cycle's samples went into a.window
+void analyticsStep(SensorAnalytics& a){
+    if(++a.cycles < a.windowCycles) return;
+    if(!a.pending.done()){
+        ++a.deferred;
+        return;
+    }
+    a.cycles = 0;
+    auto data = std::make_shared<std::vector<SensorSample>>(std::move(a.window));
+    a.window.clear();
+    auto summary = std::make_shared<WindowSummary>();
+    TaskScheduler& pool = *a.pool;
+    TaskHandle work = pool.spawn([&pool, data, summary]{ *summary = summarizeWindow(pool, *data); });
+    a.pending = pool.then(work, [&a, summary]{
+        ++a.windows;
+        a.samples += summary->samples;
+        a.last = *summary;
+        LOG_INFO("[Analytics] window ", a.windows, ": ", summary->samples, " samples, distance min ",
+                 summary->minDistance, " mean ", summary->meanDistance, " max ", summary->maxDistance, " cm");
+    });
+}
+
+// === pipeline: sensor -> control (SPSC), sensor + control -> logger (MPSC) ===
+struct Pipeline{
+    SpscQueue<SensorSample> toControl{1024};
+    MpscQueue<LogEvent> toLogger{4096};
+    std::atomic<std::uint64_t> dropped{0}; //pushes that found a queue full
+    int sensorHz = 100;
+    int controlHz = 20;
+    bool verbose = true; //print every log event
+    LatencyStats controlLatency; //written by the control thread only
+    LatencyStats loggerLatency;  //written by the logging thread only
+    SensorAnalytics* analytics = nullptr; //off when null
+};
+
+//Each loop body below is one cycle; the PeriodicScheduler decides when it runs
+struct SensorSource{
+    std::mt19937 gen{42};
+    std::uniform_real_distribution<double> distRan{10.0, 200.0};
+    std::normal_distribution<double> tempNoise{0.0, 0.2};
+    std::uint64_t seq = 0;
+};
+void sensorStep(SensorSource& source, Pipeline& pipe){
+    METRICS_SCOPE("sensor_cycle");
+    SensorSample sample;
+    sample.seq = source.seq++;
+    sample.distance = source.distRan(source.gen);
+    sample.temperature = 25.0 + source.tempNoise(source.gen);
+    sample.sentNs = nowNs();
+    if(!pipe.toControl.tryPush(sample)){
+        pipe.dropped.fetch_add(1, std::memory_order_relaxed);
+        METRICS_COUNT("queue_full_drops", 1);
+    }
+    LogEvent ev;
+    ev.source = LogEvent::Source::Sensor;
+    ev.seq = sample.seq;
+    ev.value = sample.distance;
+    ev.sentNs = sample.sentNs;
+    if(!pipe.toLogger.tryPush(ev)){
+        pipe.dropped.fetch_add(1, std::memory_order_relaxed);
+        METRICS_COUNT("queue_full_drops", 1);
+    }
+}
+void controlStep(RobotState& state, Pipeline& pipe){
+    METRICS_SCOPE("control_cycle");
+    SensorSample batch[256];
+    //take everything the sensor sent since the last cycle, in one go
+    std::size_t n;
+    double nearest = 1e9;
+    double temperature = 0.0;
+    bool any = false;
+    while((n = pipe.toControl.popBatch(batch, 256)) > 0){
+        for(std::size_t i = 0; i < n; ++i){
+            std::int64_t ns = pipe.controlLatency.add(batch[i].sentNs);
+            METRICS_RECORD_NS("queue_sensor_to_control", ns);
+            nearest = std::min(nearest, batch[i].distance);
+            temperature = batch[i].temperature;
+        }
+        if(pipe.analytics) pipe.analytics->window.insert(pipe.analytics->window.end(), batch, batch + n);
+        any = true;
+    }
+    if(any && pipe.analytics) analyticsStep(*pipe.analytics);
+    if(!any) return;
+    RobotTelemetry& cur = state.current;
+    //simple rule: drive right unless something is close
+    if(nearest > 30.0 && cur.battery > 0){
+        ++cur.positionX;
+        --cur.battery;
+    }
+    cur.temperature = temperature;
+    ++cur.version;
+    cur.timeUs = nowNs() / 1000;
+    state.snapshot.publish(cur);
+    LogEvent ev;
+    ev.positionX = cur.positionX;
+    ev.positionY = cur.positionY;
+    ev.battery = cur.battery;
+    ev.source = LogEvent::Source::Control;
+    ev.value = nearest;
+    ev.sentNs = nowNs();
+    if(!pipe.toLogger.tryPush(ev)){
+        pipe.dropped.fetch_add(1, std::memory_order_relaxed);
+        METRICS_COUNT("queue_full_drops", 1);
+    }
+}
+void loggingStep(Pipeline& pipe){
+    METRICS_SCOPE("logger_cycle");
+    LogEvent batch[256];
+    std::size_t n;
+    while((n = pipe.toLogger.popBatch(batch, 256)) > 0){
+        for(std::size_t i = 0; i < n; ++i){
+            std::int64_t ns = pipe.loggerLatency.add(batch[i].sentNs);
+            METRICS_RECORD_NS("queue_to_logger", ns);
+            if(!pipe.verbose) continue;
+            const LogEvent& ev = batch[i];
+            if(ev.source == LogEvent::Source::Sensor){
+                LOG_INFO("[Sensor Thread] #", ev.seq, " distance: ", ev.value, " cm");
+            }
+            else{
+                LOG_INFO("[Control Thread] position (", ev.positionX, ",", ev.positionY,
+                         ") battery ", ev.battery, "% nearest ", ev.value, " cm");
+            }
+        }
+    }
+}
+
+//Telemetry reader (display, dashboards...): polls the snapshot as fast as it likes
+struct ReaderStats{
+    std::uint64_t reads = 0;
+    std::uint64_t retries = 0;      //copies redone because the writer was mid-publish
+    std::uint64_t inconsistent = 0; //snapshots that break "positionX + battery == 100"
+};
+void telemetryThread(RobotState& state, ReaderStats& stats){
+    RobotTelemetry seen;
     while(state.running){
-        std::this_thread::sleep_for(std::chrono::milliseconds(200)); //5Hz
+        stats.retries += state.snapshot.read(seen);
+        ++stats.reads;
+        //each control cycle moves one cell and spends 1% together, so a torn copy would show here
+        if(seen.positionX + seen.battery != 100) ++stats.inconsistent;
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+//the benchmarks (Benchmark/) include this file and bring their own main
+#ifndef BENCHMARK_BUILD
+// === main thread: start, run for a while, shut down cleanly ===
+//usage: multi_threads_robot [sensorHz] [seconds] [readers] [rt]   (quiet above 200 Hz)
+//  rt = pin sensor/control/logger to their own CPUs and ask for SCHED_FIFO
+//       (the task pool is then pinned to the CPUs after them)
+int main(int argc, char* argv[]){
+    RobotState state;
+    Pipeline pipe;
+    int seconds = 3;
+    int readerCount = 2;
+    if(argc >= 2) pipe.sensorHz = std::max(1, std::atoi(argv[1]));
+    if(argc >= 3) seconds = std::max(1, std::atoi(argv[2]));
+    if(argc >= 4) readerCount = std::max(0, std::atoi(argv[3]));
+    bool realtime = argc >= 5 && std::string(argv[4]) == "rt";
+    pipe.verbose = pipe.sensorHz <= 200;
+
+    SensorSource source;
+    //sensor, control and logger keep a thread (and with rt a CPU) each; batch
+    //work goes to one pool sized to the CPUs left over, not a thread per job
+    const unsigned LOOPS = 3;
+    SchedulerOptions poolOptions;
+    poolOptions.reservedCpus = LOOPS;
+    poolOptions.pin = realtime;
+    TaskScheduler pool(poolOptions);
+    SensorAnalytics analytics;
+    analytics.pool = &pool;
+    analytics.windowCycles = pipe.controlHz; //one window per second
+    pipe.analytics = &analytics;
+    PeriodicScheduler scheduler;
+    auto options = [&](unsigned loop, int priority){
+        TaskOptions o;
+        if(realtime){
+            o.cpu = pool.reservedCpu(loop);
+            o.fifoPriority = priority; //sensor highest, logger lowest
+        }
+        return o;
+    };
+    scheduler.add("sensor", pipe.sensorHz, [&]{ sensorStep(source, pipe); }, options(0, 80));
+    scheduler.add("control", pipe.controlHz, [&]{ controlStep(state, pipe); }, options(1, 70));
+    scheduler.add("logger", 100, [&]{ loggingStep(pipe); }, options(2, 10));
+    scheduler.start();
+    std::vector<ReaderStats> readerStats(readerCount);
+    std::vector<std::thread> readers;
+    for(int i = 0; i < readerCount; ++i){
+        readers.emplace_back(telemetryThread, std::ref(state), std::ref(readerStats[i]));
+    }
+
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    state.running = false;
+    scheduler.stop();
+    pool.wait(analytics.pending); //the last window still being worked on
+    loggingStep(pipe); //whatever arrived before shutdown
+    for(auto& t : readers) t.join();
+    logFlush();
+
+    std::cout << "\n=== Loop timing ===\n";
+    scheduler.printReport(seconds);
+    std::cout << "\n=== Pipeline summary (" << pipe.sensorHz << " Hz sensor, " << seconds << " s) ===\n";
+    std::cout << "sensor -> control : " << pipe.controlLatency.count << " samples, avg "
+              << pipe.controlLatency.averageUs() << " us (includes waiting for the 20 Hz cycle)\n";
+    std::cout << "-> logger         : " << pipe.loggerLatency.count << " events, avg "
+              << pipe.loggerLatency.averageUs() << " us, max " << pipe.loggerLatency.maxNs / 1000.0 << " us\n";
+    std::cout << "dropped (queue full): " << pipe.dropped.load() << "\n";
+    SchedulerStats poolStats = pool.stats();
+    std::cout << "analytics         : " << analytics.windows << " windows, " << analytics.samples << " samples, "
+              << analytics.deferred << " deferred; last window mean distance " << analytics.last.meanDistance
+              << " cm, mean temperature " << analytics.last.meanTemperature << " C\n";
+    std::cout << "task pool         : " << pool.workerCount() << " workers, " << poolStats.executed << " jobs, "
+              << poolStats.stolen << " stolen, " << poolStats.sleeps << " sleeps\n";
+    ReaderStats total;
+    for(const ReaderStats& r : readerStats){
+        total.reads += r.reads;
+        total.retries += r.retries;
+        total.inconsistent += r.inconsistent;
     }
-}
\ No newline at end of file
+    std::cout << "telemetry readers : " << readerCount << " threads, " << total.reads << " snapshots, "
+              << total.retries << " retries, " << total.inconsistent << " inconsistent\n";
+    RobotTelemetry last = state.snapshot.read();
+    std::cout << "final position (" << last.positionX << "," << last.positionY << ") battery "
+              << last.battery << "% after " << last.version << " control cycles\n";
+    metricsExport("multi_threads_robot");
+    return 0;
+}
+#endif
@@ -0,0 +1,185 @@
+//periodic_scheduler.h
+//Runs loops at a fixed rate on absolute deadlines.
+//sleep_for(period) after the work drifts by however long the work took, plus
+//the wake-up delay, every single cycle. Here each task owns a deadline that
+//moves forward by exactly one period per cycle, so the rate stays exact:
+//  release k = start + k * period
+//Per task it records:
+//  jitter   - how late the body started compared to its release time
+//  overrun  - the body ran longer than one period
+//  missed   - whole periods that were skipped because the task was too late
+//             (we realign to the next release instead of running a burst)
+//Optional, when the OS allows it (Linux only, ignored elsewhere):
+//  CPU pinning and SCHED_FIFO priority. A failure is reported, not fatal.
+#ifndef PERIODIC_SCHEDULER_H
+#define PERIODIC_SCHEDULER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <cerrno>
+#include <cstring>
+#endif
+#include "../Common/metrics.h"
+
+struct TaskStats{
+    std::uint64_t cycles = 0;
+    std::uint64_t overruns = 0;
+    std::uint64_t missed = 0;
+    std::int64_t jitterMinNs = 0;
+    std::int64_t jitterMaxNs = 0;
+    std::int64_t jitterSumNs = 0;
+    std::int64_t bodyMaxNs = 0;
+    double jitterAvgUs() const {return cycles ? jitterSumNs / 1000.0 / cycles : 0.0;}
+};
+
+struct TaskOptions{
+    int cpu = -1;         //pin to this CPU, -1 = let the OS decide
+    int fifoPriority = 0; //SCHED_FIFO priority 1..99, 0 = normal scheduling
+};
+
+class PeriodicScheduler{
+    private:
+        using Clock = std::chrono::steady_clock;
+        struct Task{
+            std::string name;
+            std::chrono::nanoseconds period;
+            std::function<void()> body;
+            TaskOptions options;
+            TaskStats stats; //written by the task's own thread only
+            std::thread thread;
+        };
+        std::vector<std::unique_ptr<Task>> tasks;
+        std::atomic<bool> running{false};
+
+        //Sleep until an absolute time point
+        static void sleepUntil(Clock::time_point when){
+#ifdef __linux__
+            //steady_clock is CLOCK_MONOTONIC on Linux
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(when.time_since_epoch()).count();
+            timespec ts;
+            ts.tv_sec = static_cast<time_t>(ns / 1000000000);
+            ts.tv_nsec = static_cast<long>(ns % 1000000000);
+            while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR){}
+#else
+            std::this_thread::sleep_until(when);
+#endif
+        }
+        static void applyOptions(Task& task){
+#ifdef __linux__
+            if(task.options.cpu >= 0){
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                CPU_SET(task.options.cpu, &set);
+                int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+                if(err != 0){
+                    std::cout << "[Scheduler] " << task.name << ": cannot pin to CPU " << task.options.cpu
+                              << " (" << std::strerror(err) << ")\n";
+                }
+            }
+            if(task.options.fifoPriority > 0){
+                sched_param param{};
+                param.sched_priority = task.options.fifoPriority;
+                int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+                if(err != 0){
+                    std::cout << "[Scheduler] " << task.name << ": SCHED_FIFO not permitted ("
+                              << std::strerror(err) << "), using normal scheduling\n";
+                }
+            }
+#else
+            (void)task;
+#endif
+        }
+        void loop(Task& task, Clock::time_point start){
+            applyOptions(task);
+            METRICS_THREAD_NAME(task.name);
+            TaskStats& s = task.stats;
+            Clock::time_point release = start;
+            while(running.load(std::memory_order_acquire)){
+                sleepUntil(release);
+                Clock::time_point begin = Clock::now();
+                std::int64_t jitter = std::chrono::duration_cast<std::chrono::nanoseconds>(begin - release).count();
+                task.body();
+                Clock::time_point end = Clock::now();
+                std::int64_t body = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+
+                if(s.cycles == 0 || jitter < s.jitterMinNs) s.jitterMinNs = jitter;
+                s.jitterMaxNs = std::max(s.jitterMaxNs, jitter);
+                s.jitterSumNs += jitter;
+                s.bodyMaxNs = std::max(s.bodyMaxNs, body);
+                ++s.cycles;
+                if(body > task.period.count()) ++s.overruns;
+
+                release += task.period;
+                if(end >= release){
+                    //already past the next release: skip the periods we can't make
+                    std::int64_t late = std::chrono::duration_cast<std::chrono::nanoseconds>(end - release).count();
+                    std::int64_t skip = late / task.period.count() + 1;
+                    s.missed += static_cast<std::uint64_t>(skip);
+                    release += task.period * skip;
+                }
+            }
+        }
+    public:
+        PeriodicScheduler() = default;
+        ~PeriodicScheduler(){ stop(); }
+        PeriodicScheduler(const PeriodicScheduler&) = delete;
+        PeriodicScheduler& operator=(const PeriodicScheduler&) = delete;
+
+    //Register a task before start(); returns its index
+    std::size_t add(const std::string& name, double hz, std::function<void()> body, TaskOptions options = TaskOptions()){
+        auto task = std::make_unique<Task>();
+        task->name = name;
+        task->period = std::chrono::nanoseconds(static_cast<std::int64_t>(1e9 / (hz > 0 ? hz : 1.0)));
+        task->body = std::move(body);
+        task->options = options;
+        tasks.push_back(std::move(task));
+        return tasks.size() - 1;
+    }
+    //All tasks share the same first release, so their phases are fixed
+    void start(){
+        if(running.exchange(true)) return;
+        Clock::time_point first = Clock::now() + std::chrono::milliseconds(1);
+        for(auto& task : tasks){
+            Task& t = *task;
+            t.stats = TaskStats();
+            t.thread = std::thread([this, &t, first]{ loop(t, first); });
+        }
+    }
+    //Stops after each task finishes its current cycle
+    void stop(){
+        if(!running.exchange(false)) return;
+        for(auto& task : tasks){
+            if(task->thread.joinable()) task->thread.join();
+        }
+    }
+    std::size_t size() const {return tasks.size();}
+    const std::string& name(std::size_t i) const {return tasks[i]->name;}
+    double periodUs(std::size_t i) const {return tasks[i]->period.count() / 1000.0;}
+    //Only meaningful once stop() has returned
+    const TaskStats& stats(std::size_t i) const {return tasks[i]->stats;}
+
+    void printReport(double seconds) const {
+        std::cout << "task\tperiod(us)\tcycles\trate(Hz)\tjitter avg/max(us)\tbody max(us)\toverruns\tmissed\n";
+        for(std::size_t i = 0; i < tasks.size(); ++i){
+            const TaskStats& s = tasks[i]->stats;
+            std::cout << tasks[i]->name << "\t" << periodUs(i) << "\t\t" << s.cycles << "\t"
+                      << (seconds > 0 ? s.cycles / seconds : 0.0) << "\t\t"
+                      << s.jitterAvgUs() << " / " << s.jitterMaxNs / 1000.0 << "\t\t"
+                      << s.bodyMaxNs / 1000.0 << "\t\t" << s.overruns << "\t\t" << s.missed << "\n";
+        }
+    }
+};
+
+#endif
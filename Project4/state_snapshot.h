@@ -0,0 +1,70 @@
+//state_snapshot.h
+//Seqlock: one writer publishes a whole struct, any number of readers copy it.
+//  - the writer never waits for anybody (no mutex, no priority inversion)
+//  - readers never block the writer; a reader that overlapped a write just
+//    copies again, so every copy it returns is one consistent version
+//The payload is stored as atomic 64-bit words, so a torn read is a retry and
+//not a data race. T must be trivially copyable (plain numbers, no pointers to own).
+#ifndef STATE_SNAPSHOT_H
+#define STATE_SNAPSHOT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+template <typename T>
+class SeqlockSnapshot{
+    static_assert(std::is_trivially_copyable<T>::value, "SeqlockSnapshot needs a trivially copyable type");
+    private:
+        static constexpr std::size_t WORDS = (sizeof(T) + 7) / 8;
+        std::atomic<std::uint64_t> sequence{0}; //odd while a write is in progress
+        std::atomic<std::uint64_t> words[WORDS];
+    public:
+        explicit SeqlockSnapshot(const T& initial = T()){
+            std::uint64_t buffer[WORDS] = {};
+            std::memcpy(buffer, &initial, sizeof(T));
+            for(std::size_t i = 0; i < WORDS; ++i) words[i].store(buffer[i], std::memory_order_relaxed);
+        }
+        SeqlockSnapshot(const SeqlockSnapshot&) = delete;
+        SeqlockSnapshot& operator=(const SeqlockSnapshot&) = delete;
+
+    //Writer side (one thread only)
+    void publish(const T& value){
+        std::uint64_t buffer[WORDS] = {};
+        std::memcpy(buffer, &value, sizeof(T));
+        std::uint64_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release); //odd number is visible before the data
+        for(std::size_t i = 0; i < WORDS; ++i) words[i].store(buffer[i], std::memory_order_relaxed);
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+    //Reader side: one attempt, false if a write overlapped the copy
+    bool tryRead(T& out) const {
+        std::uint64_t before = sequence.load(std::memory_order_acquire);
+        if(before & 1) return false;
+        std::uint64_t buffer[WORDS];
+        for(std::size_t i = 0; i < WORDS; ++i) buffer[i] = words[i].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire); //data is read before the second check
+        if(sequence.load(std::memory_order_relaxed) != before) return false;
+        std::memcpy(&out, buffer, sizeof(T));
+        return true;
+    }
+    //Reader side: retry until a consistent copy is made, returns how many retries it took
+    unsigned read(T& out) const {
+        unsigned retries = 0;
+        while(!tryRead(out)) ++retries;
+        return retries;
+    }
+    T read() const {
+        T out;
+        read(out);
+        return out;
+    }
+    //How many versions were published (the sequence moves by 2 per publish,
+    //so this goes up by 1)
+    std::uint64_t version() const {return sequence.load(std::memory_order_acquire) / 2;}
+};
+
+#endif